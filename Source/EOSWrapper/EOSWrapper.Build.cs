@@ -14,7 +14,15 @@ public class EOSWrapper : ModuleRules
 
 		PublicDependencyModuleNames.AddRange(new string[] { "OnlineSubsystemUtils" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreOnline", "CoreUObject", "Engine", "EOSSDK", "EOSShared", "Json", "OnlineBase", "OnlineSubsystem", "Sockets", "NetCore" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core", "CoreOnline", "CoreUObject", "Engine", "EOSSDK", "EOSShared", "Json", "OnlineBase", "OnlineSubsystem", "Sockets", "NetCore", "HTTP", "PlatformCrypto", "PlatformCryptoTypes" });
+
+		// ID token tests sign their own tokens, PlatformCrypto only verifies
+		bool bWithOpenSSL = Target.Platform == UnrealTargetPlatform.Win64 || Target.Platform == UnrealTargetPlatform.Linux || Target.Platform == UnrealTargetPlatform.Mac;
+		if (bWithOpenSSL)
+		{
+			AddEngineThirdPartyPrivateStaticDependencies(Target, "OpenSSL");
+		}
+		PrivateDefinitions.Add("WITH_EOSWRAPPER_OPENSSL=" + (bWithOpenSSL ? "1" : "0"));
 
 		PrivateDefinitions.Add("USE_XBL_XSTS_TOKEN=" + (bUseXblXstsToken ? "1" : "0"));
 		PrivateDefinitions.Add("USE_PSN_ID_TOKEN=" + (bUsePsnIdToken ? "1" : "0"));
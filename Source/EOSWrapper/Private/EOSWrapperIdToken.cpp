@@ -0,0 +1,441 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperIdToken.h"
+#include "EOSWrapperTypes.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Dom/JsonObject.h"
+#include "HttpModule.h"
+#include "Interfaces/IHttpResponse.h"
+#include "IPlatformCrypto.h"
+#include "Misc/Base64.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "OnlineSubsystem.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("ID tokens verified locally"), STAT_EOSWrapper_IdTokensVerifiedLocally, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("ID tokens rejected locally"), STAT_EOSWrapper_IdTokensRejectedLocally, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("ID tokens left to the backend"), STAT_EOSWrapper_IdTokensUnverifiable, STATGROUP_EOSWrapper);
+DECLARE_CYCLE_STAT(TEXT("Verify ID token batch"), STAT_EOSWrapper_VerifyIdTokenBatch, STATGROUP_EOSWrapper);
+
+/** Keys are fetched again after this long even if every token names a known one */
+static constexpr double KeyRefreshIntervalInSeconds = 3600.0;
+/** Unknown key ids trigger a refresh at most this often, so forged tokens can't hammer the key endpoint */
+static constexpr double MinKeyFetchIntervalInSeconds = 60.0;
+/** First retry delay after a failed key fetch, doubled on every further failure up to MinKeyFetchIntervalInSeconds */
+static constexpr double MinKeyFetchRetryDelayInSeconds = 2.0;
+/** Tokens waiting this long for the first keys go to the backend instead */
+static constexpr double MaxKeyWaitInSeconds = 5.0;
+/** Allowed difference between our clock and the issuer's for exp, iat and nbf */
+static constexpr int64 ClockSkewInSeconds = 60;
+/** Issuer of Epic Account Services ID tokens, compared as is */
+static const TCHAR* const IdTokenIssuer = TEXT("https://api.epicgames.dev/epic/oauth/v1");
+
+struct FEOSIdTokenVerifier::FSigningKeys
+{
+	TUniquePtr<FEncryptionContext> Context;
+	TMap<FString, FRSAKeyHandle> Keys;
+
+	~FSigningKeys()
+	{
+		for (const TPair<FString, FRSAKeyHandle>& Key : Keys)
+		{
+			Context->DestroyKey_RSA(Key.Value);
+		}
+	}
+};
+
+static bool DecodeBase64Url(const FString& Source, TArray<uint8>& OutBytes)
+{
+	FString Padded = Source;
+	Padded.ReplaceCharInline(TEXT('-'), TEXT('+'));
+	Padded.ReplaceCharInline(TEXT('_'), TEXT('/'));
+	while (Padded.Len() % 4 != 0)
+	{
+		Padded.AppendChar(TEXT('='));
+	}
+	return FBase64::Decode(Padded, OutBytes);
+}
+
+static TSharedPtr<FJsonObject> ParseJsonObject(const FString& Json)
+{
+	TSharedPtr<FJsonObject> Object;
+	FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(Json), Object);
+	return Object;
+}
+
+/** Decodes one base64url segment of a JWT into its JSON object */
+static TSharedPtr<FJsonObject> DecodeJsonSegment(const FString& Segment)
+{
+	TArray<uint8> Bytes;
+	if (!DecodeBase64Url(Segment, Bytes))
+	{
+		return nullptr;
+	}
+	const FUTF8ToTCHAR Json(reinterpret_cast<const ANSICHAR*>(Bytes.GetData()), Bytes.Num());
+	return ParseJsonObject(FString(Json.Length(), Json.Get()));
+}
+
+static bool HasAudience(const FJsonObject& Payload, const TArray<FString>& AcceptedAudiences)
+{
+	FString Audience;
+	if (Payload.TryGetStringField(TEXT("aud"), Audience))
+	{
+		return AcceptedAudiences.Contains(Audience);
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* Audiences = nullptr;
+	if (Payload.TryGetArrayField(TEXT("aud"), Audiences))
+	{
+		for (const TSharedPtr<FJsonValue>& Value : *Audiences)
+		{
+			if (Value.IsValid() && AcceptedAudiences.Contains(Value->AsString()))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/** Checks signature and claims of a compact serialized JWT, safe to call from any thread */
+static FEOSIdTokenVerifier::EResult VerifyIdToken(const FString& Token, const FString& AccountId, const TArray<FString>& AcceptedAudiences, const TMap<FString, FRSAKeyHandle>& Keys,
+	FEncryptionContext& Context, int64 NowUnixTime, int64& OutExpiresAtUnixTime, bool& bOutUnknownKey)
+{
+	typedef FEOSIdTokenVerifier::EResult EResult;
+
+	// Without a client id to check against we can't tell a token for this game from one for another, leave it to the backend
+	if (AcceptedAudiences.Num() == 0)
+	{
+		return EResult::Unverifiable;
+	}
+
+	int32 HeaderEnd = INDEX_NONE;
+	int32 PayloadEnd = INDEX_NONE;
+	if (!Token.FindChar(TEXT('.'), HeaderEnd) || !Token.FindLastChar(TEXT('.'), PayloadEnd) || HeaderEnd == PayloadEnd)
+	{
+		return EResult::Invalid;
+	}
+
+	const TSharedPtr<FJsonObject> Header = DecodeJsonSegment(Token.Left(HeaderEnd));
+	const TSharedPtr<FJsonObject> Payload = DecodeJsonSegment(Token.Mid(HeaderEnd + 1, PayloadEnd - HeaderEnd - 1));
+	FString Algorithm;
+	FString KeyId;
+	if (!Header.IsValid() || !Payload.IsValid() || !Header->TryGetStringField(TEXT("alg"), Algorithm) || !Algorithm.Equals(TEXT("RS256"), ESearchCase::CaseSensitive) ||
+		!Header->TryGetStringField(TEXT("kid"), KeyId))
+	{
+		return EResult::Invalid;
+	}
+
+	const FRSAKeyHandle* Key = Keys.Find(KeyId);
+	if (Key == nullptr)
+	{
+		bOutUnknownKey = true;
+		return EResult::Unverifiable;
+	}
+
+	TArray<uint8> Signature;
+	if (!DecodeBase64Url(Token.RightChop(PayloadEnd + 1), Signature))
+	{
+		return EResult::Invalid;
+	}
+	// The signature covers the encoded header and payload as sent
+	const FTCHARToUTF8 SigningInput(*Token, PayloadEnd);
+	if (!Context.DigestVerify_RS256(TArrayView<const char>(SigningInput.Get(), SigningInput.Length()), Signature, *Key))
+	{
+		return EResult::Invalid;
+	}
+
+	FString Issuer;
+	FString Subject;
+	double ExpiresAt = 0.0;
+	double IssuedAt = 0.0;
+	double NotBefore = 0.0;
+	if (!Payload->TryGetStringField(TEXT("iss"), Issuer) || !Issuer.Equals(IdTokenIssuer, ESearchCase::CaseSensitive) || !HasAudience(*Payload, AcceptedAudiences) ||
+		!Payload->TryGetNumberField(TEXT("exp"), ExpiresAt) || (int64)ExpiresAt + ClockSkewInSeconds <= NowUnixTime)
+	{
+		return EResult::Invalid;
+	}
+	if ((Payload->TryGetNumberField(TEXT("iat"), IssuedAt) && (int64)IssuedAt - ClockSkewInSeconds > NowUnixTime) ||
+		(Payload->TryGetNumberField(TEXT("nbf"), NotBefore) && (int64)NotBefore - ClockSkewInSeconds > NowUnixTime))
+	{
+		return EResult::Invalid;
+	}
+	if (!AccountId.IsEmpty() && (!Payload->TryGetStringField(TEXT("sub"), Subject) || Subject != AccountId))
+	{
+		return EResult::Invalid;
+	}
+
+	OutExpiresAtUnixTime = (int64)ExpiresAt;
+	return EResult::Valid;
+}
+
+FEOSIdTokenVerifier::FEOSIdTokenVerifier(const FString& InSigningKeysLocation, const TArray<FString>& InAcceptedAudiences, int32 InMaxWorkers)
+	: SigningKeysLocation(InSigningKeysLocation), MaxWorkers(FMath::Max(InMaxWorkers, 1))
+{
+	for (const FString& Audience : InAcceptedAudiences)
+	{
+		if (!Audience.IsEmpty())
+		{
+			AcceptedAudiences.AddUnique(Audience);
+		}
+	}
+	if (AcceptedAudiences.Num() == 0)
+	{
+		UE_LOG_ONLINE(Warning, TEXT("[FEOSIdTokenVerifier::FEOSIdTokenVerifier] No accepted client ids configured, every token is verified by the backend"));
+	}
+
+	// Loaded here since workers can't load modules
+	PlatformCrypto = FModuleManager::LoadModulePtr<IPlatformCrypto>(TEXT("PlatformCrypto"));
+	if (PlatformCrypto == nullptr)
+	{
+		UE_LOG_ONLINE(Warning, TEXT("[FEOSIdTokenVerifier::FEOSIdTokenVerifier] PlatformCrypto is not available, every token is verified by the backend"));
+		return;
+	}
+	FetchSigningKeys();
+}
+
+FEOSIdTokenVerifier::~FEOSIdTokenVerifier()
+{
+	if (SigningKeysRequest.IsValid())
+	{
+		SigningKeysRequest->OnProcessRequestComplete().Unbind();
+		SigningKeysRequest->CancelRequest();
+	}
+}
+
+void FEOSIdTokenVerifier::Verify(const FString& Token, const FString& AccountId, const FOnTokenVerified& OnVerified)
+{
+	FQueuedToken& QueuedToken = QueuedTokens.Emplace_GetRef();
+	QueuedToken.Token = Token;
+	QueuedToken.AccountId = AccountId;
+	QueuedToken.OnVerified = OnVerified;
+	QueuedToken.QueueTimeInSeconds = FPlatformTime::Seconds();
+}
+
+void FEOSIdTokenVerifier::Tick()
+{
+	for (int32 Index = InFlightBatches.Num() - 1; Index >= 0; Index--)
+	{
+		if (InFlightBatches[Index]->bDone)
+		{
+			TSharedRef<FBatch, ESPMode::ThreadSafe> Batch = InFlightBatches[Index];
+			InFlightBatches.RemoveAtSwap(Index);
+			CompleteTokens(MoveTemp(Batch->Tokens));
+		}
+	}
+
+	if (PlatformCrypto == nullptr)
+	{
+		// Callbacks may queue new tokens, those wait for the next tick
+		TArray<FQueuedToken> Tokens = MoveTemp(QueuedTokens);
+		QueuedTokens.Reset();
+		CompleteTokens(MoveTemp(Tokens));
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (!SigningKeysRequest.IsValid() && Now >= NextKeyFetchTimeInSeconds)
+	{
+		FetchSigningKeys();
+	}
+
+	if (QueuedTokens.Num() == 0)
+	{
+		return;
+	}
+
+	if (SigningKeys.IsValid())
+	{
+		LaunchBatch();
+		return;
+	}
+
+	// Still waiting for the first keys, only hold tokens back while a fetch can still bring them
+	TArray<FQueuedToken> ExpiredTokens;
+	for (int32 Index = QueuedTokens.Num() - 1; Index >= 0; Index--)
+	{
+		if (!SigningKeysRequest.IsValid() || Now - QueuedTokens[Index].QueueTimeInSeconds > MaxKeyWaitInSeconds)
+		{
+			ExpiredTokens.Add(MoveTemp(QueuedTokens[Index]));
+			QueuedTokens.RemoveAt(Index);
+		}
+	}
+	CompleteTokens(MoveTemp(ExpiredTokens));
+}
+
+bool FEOSIdTokenVerifier::ReadTokenExpiry(const FString& Token, int64& OutExpiresAtUnixTime)
+{
+	int32 HeaderEnd = INDEX_NONE;
+	int32 PayloadEnd = INDEX_NONE;
+	if (!Token.FindChar(TEXT('.'), HeaderEnd) || !Token.FindLastChar(TEXT('.'), PayloadEnd) || HeaderEnd == PayloadEnd)
+	{
+		return false;
+	}
+
+	double ExpiresAt = 0.0;
+	const TSharedPtr<FJsonObject> Payload = DecodeJsonSegment(Token.Mid(HeaderEnd + 1, PayloadEnd - HeaderEnd - 1));
+	if (!Payload.IsValid() || !Payload->TryGetNumberField(TEXT("exp"), ExpiresAt))
+	{
+		return false;
+	}
+	OutExpiresAtUnixTime = (int64)ExpiresAt;
+	return true;
+}
+
+void FEOSIdTokenVerifier::FetchSigningKeys()
+{
+	LastKeyFetchTimeInSeconds = FPlatformTime::Seconds();
+
+	// Anything that isn't an URL is a JWKS file, relative paths start at the project directory
+	if (!SigningKeysLocation.StartsWith(TEXT("http://")) && !SigningKeysLocation.StartsWith(TEXT("https://")))
+	{
+		const FString FilePath = FPaths::IsRelative(SigningKeysLocation) ? FPaths::Combine(FPaths::ProjectDir(), SigningKeysLocation) : SigningKeysLocation;
+		FString JwksJson;
+		const bool bLoaded = FFileHelper::LoadFileToString(JwksJson, *FilePath);
+		if (!bLoaded)
+		{
+			UE_LOG_ONLINE(Warning, TEXT("[FEOSIdTokenVerifier::FetchSigningKeys] Failed to read signing keys from (%s)"), *FilePath);
+		}
+		ScheduleNextKeyFetch(bLoaded && OnSigningKeysReceived(JwksJson));
+		return;
+	}
+
+	SigningKeysRequest = FHttpModule::Get().CreateRequest();
+	SigningKeysRequest->SetURL(SigningKeysLocation);
+	SigningKeysRequest->SetVerb(TEXT("GET"));
+	SigningKeysRequest->OnProcessRequestComplete().BindLambda(
+		[this](FHttpRequestPtr Request, FHttpResponsePtr Response, bool bSucceeded)
+		{
+			SigningKeysRequest.Reset();
+			if (bSucceeded && Response.IsValid() && EHttpResponseCodes::IsOk(Response->GetResponseCode()))
+			{
+				ScheduleNextKeyFetch(OnSigningKeysReceived(Response->GetContentAsString()));
+				return;
+			}
+			UE_LOG_ONLINE(Warning, TEXT("[FEOSIdTokenVerifier::FetchSigningKeys] Failed to fetch signing keys from (%s), response code (%d)"), *SigningKeysLocation,
+				Response.IsValid() ? Response->GetResponseCode() : 0);
+			ScheduleNextKeyFetch(false);
+		});
+	SigningKeysRequest->ProcessRequest();
+}
+
+void FEOSIdTokenVerifier::ScheduleNextKeyFetch(bool bSucceeded)
+{
+	if (bSucceeded)
+	{
+		KeyFetchRetryDelayInSeconds = 0.0;
+		NextKeyFetchTimeInSeconds = FPlatformTime::Seconds() + KeyRefreshIntervalInSeconds;
+		return;
+	}
+	// Failed fetches are retried soon rather than after a full refresh interval, backing off while the endpoint stays down
+	KeyFetchRetryDelayInSeconds = FMath::Clamp(KeyFetchRetryDelayInSeconds * 2.0, MinKeyFetchRetryDelayInSeconds, MinKeyFetchIntervalInSeconds);
+	NextKeyFetchTimeInSeconds = FPlatformTime::Seconds() + KeyFetchRetryDelayInSeconds;
+}
+
+bool FEOSIdTokenVerifier::OnSigningKeysReceived(const FString& JwksJson)
+{
+	const TSharedPtr<FJsonObject> Jwks = ParseJsonObject(JwksJson);
+	const TArray<TSharedPtr<FJsonValue>>* KeyValues = nullptr;
+	if (!Jwks.IsValid() || !Jwks->TryGetArrayField(TEXT("keys"), KeyValues))
+	{
+		UE_LOG_ONLINE(Warning, TEXT("[FEOSIdTokenVerifier::OnSigningKeysReceived] Signing keys are not a JWKS document"));
+		return false;
+	}
+
+	TSharedRef<FSigningKeys, ESPMode::ThreadSafe> NewKeys = MakeShared<FSigningKeys, ESPMode::ThreadSafe>();
+	NewKeys->Context = PlatformCrypto->CreateContext();
+	if (!NewKeys->Context.IsValid())
+	{
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& KeyValue : *KeyValues)
+	{
+		const TSharedPtr<FJsonObject>* Key = nullptr;
+		FString KeyType;
+		if (!KeyValue.IsValid() || !KeyValue->TryGetObject(Key) || !(*Key)->TryGetStringField(TEXT("kty"), KeyType) || KeyType != TEXT("RSA"))
+		{
+			continue;
+		}
+
+		FString KeyId;
+		FString EncodedModulus;
+		FString EncodedExponent;
+		TArray<uint8> Modulus;
+		TArray<uint8> Exponent;
+		if (!(*Key)->TryGetStringField(TEXT("kid"), KeyId) || KeyId.IsEmpty() || !(*Key)->TryGetStringField(TEXT("n"), EncodedModulus) ||
+			!(*Key)->TryGetStringField(TEXT("e"), EncodedExponent) || !DecodeBase64Url(EncodedModulus, Modulus) || !DecodeBase64Url(EncodedExponent, Exponent))
+		{
+			continue;
+		}
+
+		if (FRSAKeyHandle KeyHandle = NewKeys->Context->CreateKey_RSA(Exponent, TArray<uint8>(), Modulus))
+		{
+			NewKeys->Keys.Add(KeyId, KeyHandle);
+		}
+	}
+
+	UE_LOG_ONLINE(Log, TEXT("[FEOSIdTokenVerifier::OnSigningKeysReceived] Loaded %d signing keys"), NewKeys->Keys.Num());
+	// Batches still running keep the old keys alive
+	SigningKeys = NewKeys;
+	return true;
+}
+
+void FEOSIdTokenVerifier::LaunchBatch()
+{
+	TSharedRef<FBatch, ESPMode::ThreadSafe> Batch = MakeShared<FBatch, ESPMode::ThreadSafe>();
+	Batch->Tokens = MoveTemp(QueuedTokens);
+	QueuedTokens.Reset();
+	InFlightBatches.Add(Batch);
+
+	Async(EAsyncExecution::ThreadPool,
+		[Batch, Keys = SigningKeys, AcceptedAudiences = AcceptedAudiences, PlatformCrypto = PlatformCrypto, NumChunks = FMath::Min(MaxWorkers, Batch->Tokens.Num()),
+			NowUnixTime = FDateTime::UtcNow().ToUnixTimestamp()]()
+		{
+			SCOPE_CYCLE_COUNTER(STAT_EOSWrapper_VerifyIdTokenBatch);
+			ParallelFor(NumChunks,
+				[&Batch, &Keys, &AcceptedAudiences, PlatformCrypto, NumChunks, NowUnixTime](int32 Chunk)
+				{
+					TUniquePtr<FEncryptionContext> Context = PlatformCrypto->CreateContext();
+					for (int32 Index = Chunk; Index < Batch->Tokens.Num(); Index += NumChunks)
+					{
+						FQueuedToken& QueuedToken = Batch->Tokens[Index];
+						if (Context.IsValid())
+						{
+							QueuedToken.Result = VerifyIdToken(
+								QueuedToken.Token, QueuedToken.AccountId, AcceptedAudiences, Keys->Keys, *Context, NowUnixTime, QueuedToken.ExpiresAtUnixTime, QueuedToken.bUnknownKey);
+						}
+					}
+				});
+			Batch->bDone = true;
+		});
+}
+
+void FEOSIdTokenVerifier::CompleteTokens(TArray<FQueuedToken> Tokens)
+{
+	for (const FQueuedToken& QueuedToken : Tokens)
+	{
+		if (QueuedToken.bUnknownKey && !SigningKeysRequest.IsValid() && FPlatformTime::Seconds() - LastKeyFetchTimeInSeconds > MinKeyFetchIntervalInSeconds)
+		{
+			FetchSigningKeys();
+		}
+
+		switch (QueuedToken.Result)
+		{
+			case EResult::Valid:
+				INC_DWORD_STAT(STAT_EOSWrapper_IdTokensVerifiedLocally);
+				break;
+			case EResult::Invalid:
+				INC_DWORD_STAT(STAT_EOSWrapper_IdTokensRejectedLocally);
+				break;
+			default:
+				INC_DWORD_STAT(STAT_EOSWrapper_IdTokensUnverifiable);
+				break;
+		}
+		QueuedToken.OnVerified(QueuedToken.Result, QueuedToken.ExpiresAtUnixTime);
+	}
+}
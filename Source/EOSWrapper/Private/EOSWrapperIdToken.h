@@ -0,0 +1,88 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Interfaces/IHttpRequest.h"
+
+class IPlatformCrypto;
+
+/**
+ * Verifies EOS Auth ID tokens (RS256 signed JWTs) without a backend round trip.
+ * Signing keys come from a JWKS document fetched over HTTP, or read from disk when the location isn't an URL, and are kept until they get old or a token
+ * names a key we don't know. Tokens queued during a frame are verified as one batch spread over up to MaxWorkers thread pool workers, the callbacks run
+ * from Tick on the game thread. Tokens that can't be checked locally (no keys, unknown key, no crypto support) come back Unverifiable so the caller can ask
+ * the backend instead.
+ */
+class FEOSIdTokenVerifier
+{
+public:
+	enum class EResult : uint8
+	{
+		Valid,
+		Invalid,
+		Unverifiable
+	};
+
+	/** ExpiresAtUnixTime is the exp claim of valid tokens, 0 otherwise */
+	typedef TFunction<void(EResult Result, int64 ExpiresAtUnixTime)> FOnTokenVerified;
+
+	/** AcceptedAudiences are the client ids tokens may be issued to, without any every token comes back Unverifiable */
+	FEOSIdTokenVerifier(const FString& InSigningKeysLocation, const TArray<FString>& InAcceptedAudiences, int32 InMaxWorkers);
+	~FEOSIdTokenVerifier();
+
+	/** AccountId is the Epic account the token has to belong to, empty accepts any */
+	void Verify(const FString& Token, const FString& AccountId, const FOnTokenVerified& OnVerified);
+	void Tick();
+
+	/** Reads the exp claim without checking anything else, for tokens the backend already verified */
+	static bool ReadTokenExpiry(const FString& Token, int64& OutExpiresAtUnixTime);
+
+private:
+	/** Public keys by key id, destroyed with the context that created them once no batch uses them anymore */
+	struct FSigningKeys;
+	typedef TSharedPtr<const FSigningKeys, ESPMode::ThreadSafe> FSigningKeysPtr;
+
+	struct FQueuedToken
+	{
+		FString Token;
+		FString AccountId;
+		FOnTokenVerified OnVerified;
+		double QueueTimeInSeconds = 0.0;
+		EResult Result = EResult::Unverifiable;
+		int64 ExpiresAtUnixTime = 0;
+		/** Set when the token was signed with a key we don't have, triggers a key refresh */
+		bool bUnknownKey = false;
+	};
+
+	struct FBatch
+	{
+		TArray<FQueuedToken> Tokens;
+		FThreadSafeBool bDone;
+	};
+
+	void FetchSigningKeys();
+	/** Returns false when the document couldn't be used, the current keys are kept then */
+	bool OnSigningKeysReceived(const FString& JwksJson);
+	void ScheduleNextKeyFetch(bool bSucceeded);
+	void LaunchBatch();
+	/** Takes the tokens by value since callbacks may queue new ones */
+	void CompleteTokens(TArray<FQueuedToken> Tokens);
+
+	IPlatformCrypto* PlatformCrypto = nullptr;
+	FString SigningKeysLocation;
+	TArray<FString> AcceptedAudiences;
+	int32 MaxWorkers;
+
+	FSigningKeysPtr SigningKeys;
+	FHttpRequestPtr SigningKeysRequest;
+	double LastKeyFetchTimeInSeconds = -DBL_MAX;
+	double NextKeyFetchTimeInSeconds = 0.0;
+	/** Delay before the next retry while fetches keep failing, 0 after a success */
+	double KeyFetchRetryDelayInSeconds = 0.0;
+
+	TArray<FQueuedToken> QueuedTokens;
+	TArray<TSharedRef<FBatch, ESPMode::ThreadSafe>> InFlightBatches;
+};
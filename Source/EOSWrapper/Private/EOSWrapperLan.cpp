@@ -0,0 +1,335 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperLan.h"
+#include "EOSWrapperTypes.h"
+#include "OnlineSubsystem.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN packets sent"), STAT_EOSWrapper_LanPacketsSent, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN packets received"), STAT_EOSWrapper_LanPacketsReceived, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN bytes sent"), STAT_EOSWrapper_LanBytesSent, STATGROUP_EOSWrapper);
+
+void FEOSLanPacketWriter::WriteString(FStringView Value)
+{
+	FTCHARToUTF8 Converter(Value.GetData(), Value.Len());
+	const uint16 Length = (uint16)FMath::Min(Converter.Length(), (int32)MAX_uint16);
+	Write(Length);
+	Buffer.Append(reinterpret_cast<const uint8*>(Converter.Get()), Length);
+}
+
+void FEOSLanPacketWriter::WriteName(FName Value)
+{
+	FNameBuilder Builder(Value);
+	WriteString(Builder.ToView());
+}
+
+void FEOSLanPacketWriter::WriteVariant(const FVariantData& Value)
+{
+	const EOnlineKeyValuePairDataType::Type Type = Value.GetType();
+	Write((uint8)Type);
+	switch (Type)
+	{
+		case EOnlineKeyValuePairDataType::Int32:
+		{
+			int32 Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::UInt32:
+		{
+			uint32 Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Int64:
+		{
+			int64 Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::UInt64:
+		{
+			uint64 Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Double:
+		{
+			double Data;
+			Value.GetValue(Data);
+			Write(Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Bool:
+		{
+			bool Data;
+			Value.GetValue(Data);
+			Write((uint8)Data);
+			break;
+		}
+		case EOnlineKeyValuePairDataType::String:
+		case EOnlineKeyValuePairDataType::Json:
+		{
+			WriteString(Value.ToString());
+			break;
+		}
+		case EOnlineKeyValuePairDataType::Blob:
+		{
+			TArray<uint8> Data;
+			Value.GetValue(Data);
+			const uint16 Length = (uint16)FMath::Min(Data.Num(), (int32)MAX_uint16);
+			Write(Length);
+			Buffer.Append(Data.GetData(), Length);
+			break;
+		}
+		default:
+		{
+			break;
+		}
+	}
+}
+
+bool FEOSLanPacketReader::ReadString(FString& OutValue)
+{
+	uint16 Length = 0;
+	if (!Read(Length) || Offset + Length > Size)
+	{
+		bError = true;
+		return false;
+	}
+
+	FUTF8ToTCHAR Converter(reinterpret_cast<const ANSICHAR*>(Data + Offset), Length);
+	OutValue = FString(Converter.Length(), Converter.Get());
+	Offset += Length;
+	return true;
+}
+
+bool FEOSLanPacketReader::ReadName(FName& OutValue)
+{
+	FString Value;
+	if (!ReadString(Value))
+	{
+		return false;
+	}
+	OutValue = FName(*Value);
+	return true;
+}
+
+bool FEOSLanPacketReader::ReadVariant(FVariantData& OutValue)
+{
+	uint8 Type = 0;
+	if (!Read(Type))
+	{
+		return false;
+	}
+
+	switch ((EOnlineKeyValuePairDataType::Type)Type)
+	{
+		case EOnlineKeyValuePairDataType::Empty:
+		{
+			OutValue.Empty();
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Int32:
+		{
+			int32 Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt32:
+		{
+			uint32 Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Int64:
+		{
+			int64 Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt64:
+		{
+			uint64 Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Double:
+		{
+			double Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Bool:
+		{
+			uint8 Data;
+			if (!Read(Data)) return false;
+			OutValue.SetValue(Data != 0);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::String:
+		{
+			FString Data;
+			if (!ReadString(Data)) return false;
+			OutValue.SetValue(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Json:
+		{
+			FString Data;
+			if (!ReadString(Data)) return false;
+			OutValue.SetJsonValueFromString(Data);
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Blob:
+		{
+			uint16 Length = 0;
+			if (!Read(Length) || Offset + Length > Size)
+			{
+				bError = true;
+				return false;
+			}
+			OutValue.SetValue((uint32)Length, Data + Offset);
+			Offset += Length;
+			return true;
+		}
+		default:
+		{
+			bError = true;
+			return false;
+		}
+	}
+}
+
+void FEOSLanPacketHeader::Write(FEOSLanPacketWriter& Writer) const
+{
+	Writer.Write(Magic);
+	Writer.Write(Version);
+	Writer.Write((uint8)Type);
+	Writer.Write(BuildUniqueId);
+	Writer.Write(Nonce);
+	Writer.Write(Sequence);
+}
+
+bool FEOSLanPacketHeader::Read(FEOSLanPacketReader& Reader)
+{
+	uint32 PacketMagic = 0;
+	uint8 PacketVersion = 0;
+	uint8 PacketType = 0;
+	Reader.Read(PacketMagic);
+	Reader.Read(PacketVersion);
+	Reader.Read(PacketType);
+	Reader.Read(BuildUniqueId);
+	Reader.Read(Nonce);
+	Reader.Read(Sequence);
+	Type = (EType)PacketType;
+	return !Reader.HasError() && PacketMagic == Magic && PacketVersion == Version && (Type == EType::Query || Type == EType::Response);
+}
+
+FEOSLanBeacon::~FEOSLanBeacon()
+{
+	if (Socket)
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+bool FEOSLanBeacon::Init(int32 InPort)
+{
+	SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("EOSWrapper LAN beacon"), FNetworkProtocolTypes::IPv4);
+	if (Socket == nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSLanBeacon::Init] Unable to create socket"));
+		return false;
+	}
+
+	// Hosts and searching clients on the same machine all listen on the beacon port
+	TSharedRef<FInternetAddr> LocalAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	LocalAddress->SetAnyAddress();
+	LocalAddress->SetPort(InPort);
+	if (!Socket->SetReuseAddr(true) || !Socket->SetBroadcast(true) || !Socket->SetNonBlocking(true) || !Socket->Bind(*LocalAddress))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSLanBeacon::Init] Unable to bind port %d"), InPort);
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	Port = InPort;
+	BroadcastAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	BroadcastAddress->SetBroadcastAddress();
+	BroadcastAddress->SetPort(Port);
+	SendAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	FromAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	return true;
+}
+
+bool FEOSLanBeacon::Broadcast(const uint8* Packet, int32 PacketSize)
+{
+	int32 BytesSent = 0;
+	const bool bSent = Socket->SendTo(Packet, PacketSize, BytesSent, *BroadcastAddress) && BytesSent == PacketSize;
+	INC_DWORD_STAT(STAT_EOSWrapper_LanPacketsSent);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_LanBytesSent, BytesSent);
+	return bSent;
+}
+
+bool FEOSLanBeacon::SendTo(const uint8* Packet, int32 PacketSize, uint32 Ip, int32 ToPort)
+{
+	SendAddress->SetIp(Ip);
+	SendAddress->SetPort(ToPort);
+
+	int32 BytesSent = 0;
+	const bool bSent = Socket->SendTo(Packet, PacketSize, BytesSent, *SendAddress) && BytesSent == PacketSize;
+	INC_DWORD_STAT(STAT_EOSWrapper_LanPacketsSent);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_LanBytesSent, BytesSent);
+	return bSent;
+}
+
+int32 FEOSLanBeacon::Poll(TFunctionRef<void(const uint8* Packet, int32 PacketSize, const FInternetAddr& FromAddress)> Handler)
+{
+	int32 NumPackets = 0;
+	int32 BytesRead = 0;
+	while (NumPackets < MaxPacketsPerPoll && Socket->RecvFrom(ReceiveBuffer, MaxPacketSize, BytesRead, *FromAddress))
+	{
+		NumPackets++;
+		if (BytesRead > 0)
+		{
+			Handler(ReceiveBuffer, BytesRead, *FromAddress);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_LanPacketsReceived, NumPackets);
+	return NumPackets;
+}
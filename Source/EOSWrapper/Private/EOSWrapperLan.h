@@ -0,0 +1,120 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineKeyValuePair.h"
+
+class FSocket;
+class FInternetAddr;
+class ISocketSubsystem;
+
+/** Appends values to a caller owned buffer, so a buffer kept between packets stops allocating once it reached the packet size */
+class FEOSLanPacketWriter
+{
+public:
+	explicit FEOSLanPacketWriter(TArray<uint8>& InBuffer) : Buffer(InBuffer) {}
+
+	/** Values are written in host byte order, every platform the engine ships on is little endian */
+	template <typename ValueType>
+	void Write(ValueType Value)
+	{
+		Buffer.Append(reinterpret_cast<const uint8*>(&Value), sizeof(ValueType));
+	}
+	void WriteString(FStringView Value);
+	void WriteName(FName Value);
+	void WriteVariant(const FVariantData& Value);
+
+private:
+	TArray<uint8>& Buffer;
+};
+
+/** Reads what FEOSLanPacketWriter wrote straight from the receive buffer. Any read past the end puts the reader in an error state */
+class FEOSLanPacketReader
+{
+public:
+	FEOSLanPacketReader(const uint8* InData, int32 InSize) : Data(InData), Size(InSize) {}
+
+	template <typename ValueType>
+	bool Read(ValueType& OutValue)
+	{
+		if (bError || Offset + (int32)sizeof(ValueType) > Size)
+		{
+			bError = true;
+			return false;
+		}
+		FMemory::Memcpy(&OutValue, Data + Offset, sizeof(ValueType));
+		Offset += sizeof(ValueType);
+		return true;
+	}
+	bool ReadString(FString& OutValue);
+	bool ReadName(FName& OutValue);
+	bool ReadVariant(FVariantData& OutValue);
+
+	bool HasError() const { return bError; }
+
+private:
+	const uint8* Data;
+	int32 Size;
+	int32 Offset = 0;
+	bool bError = false;
+};
+
+/** Header every LAN beacon packet starts with */
+struct FEOSLanPacketHeader
+{
+	static constexpr uint32 Magic = 0x4C534F45;
+	static constexpr uint8 Version = 1;
+	static constexpr int32 Size = 20;
+	/** Offsets of the fields a host patches per client when it sends the same response to several of them */
+	static constexpr int32 NonceOffset = 10;
+	static constexpr int32 SequenceOffset = 18;
+
+	enum class EType : uint8
+	{
+		Query = 1,
+		Response = 2
+	};
+
+	EType Type = EType::Query;
+	int32 BuildUniqueId = 0;
+	/** Identifies the search, responses echo the nonce and sequence of the query they answer */
+	uint64 Nonce = 0;
+	uint16 Sequence = 0;
+
+	void Write(FEOSLanPacketWriter& Writer) const;
+	bool Read(FEOSLanPacketReader& Reader);
+};
+
+/**
+ * Non-blocking UDP broadcast socket shared by LAN hosting and LAN discovery. It is never waited on, the owner drains it from its tick.
+ */
+class FEOSLanBeacon
+{
+public:
+	/** Fits in a single ethernet frame */
+	static constexpr int32 MaxPacketSize = 1024;
+	/** Upper bound on packets handled per poll so a flood of queries can't stall the game thread */
+	static constexpr int32 MaxPacketsPerPoll = 256;
+
+	~FEOSLanBeacon();
+
+	bool Init(int32 InPort);
+	int32 GetPort() const { return Port; }
+
+	bool Broadcast(const uint8* Packet, int32 PacketSize);
+	/** Ip in host byte order */
+	bool SendTo(const uint8* Packet, int32 PacketSize, uint32 Ip, int32 ToPort);
+	/** Hands every waiting packet to Handler, the data points into a buffer that is reused for the next packet */
+	int32 Poll(TFunctionRef<void(const uint8* Packet, int32 PacketSize, const FInternetAddr& FromAddress)> Handler);
+
+private:
+	ISocketSubsystem* SocketSubsystem = nullptr;
+	FSocket* Socket = nullptr;
+	TSharedPtr<FInternetAddr> BroadcastAddress;
+	TSharedPtr<FInternetAddr> SendAddress;
+	TSharedPtr<FInternetAddr> FromAddress;
+	int32 Port = 0;
+	uint8 ReceiveBuffer[MaxPacketSize];
+};
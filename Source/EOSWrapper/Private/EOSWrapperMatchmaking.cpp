@@ -0,0 +1,404 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperMatchmaking.h"
+#include "EOSWrapperSessionManager.h"
+#include "EOSWrapperSessionSearch.h"
+#include "OnlineSubsystem.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking queries"), STAT_EOSWrapper_MatchmakingQueries, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Matchmaking matches"), STAT_EOSWrapper_MatchmakingMatches, STATGROUP_EOSWrapper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Matchmaking average time to match"), STAT_EOSWrapper_MatchmakingAverageTimeToMatch, STATGROUP_EOSWrapper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Matchmaking average queries per match"), STAT_EOSWrapper_MatchmakingAverageQueriesPerMatch, STATGROUP_EOSWrapper);
+
+void FEOSMatchmakingLocalBackend::SearchLobbies(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& Search, const FOnBackendOperationComplete& Callback)
+{
+	NumSearches++;
+
+	Search->SearchResults.Reset();
+	for (const FLocalLobby& Lobby : Lobbies)
+	{
+		if (Search->SearchResults.Num() >= Search->MaxSearchResults)
+		{
+			break;
+		}
+
+		if (MatchesQuery(Lobby, Search->QuerySettings))
+		{
+			FOnlineSessionSearchResult& SearchResult = Search->SearchResults.AddDefaulted_GetRef();
+			SearchResult.Session.SessionSettings = Lobby.SessionSettings;
+			SearchResult.Session.SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(FString(), FUniqueNetIdEOSLobby::Create(Lobby.LobbyId), nullptr));
+			SearchResult.Session.NumOpenPublicConnections = FMath::Max(Lobby.SessionSettings.NumPublicConnections - Lobby.NumMembers, 0);
+		}
+	}
+	Search->SearchState = EOnlineAsyncTaskState::Done;
+
+	Callback(true);
+}
+
+void FEOSMatchmakingLocalBackend::JoinLobby(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& SearchResult, const FOnBackendOperationComplete& Callback)
+{
+	FLocalLobby* Lobby = FindLobby(SearchResult.Session.GetSessionIdStr());
+	if (Lobby && Lobby->NumMembers < Lobby->SessionSettings.NumPublicConnections)
+	{
+		Lobby->NumMembers++;
+		Callback(true);
+	}
+	else
+	{
+		Callback(false);
+	}
+}
+
+void FEOSMatchmakingLocalBackend::CreateLobby(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& SessionSettings, const FOnBackendOperationComplete& Callback)
+{
+	AddLobby(SessionSettings);
+	Callback(true);
+}
+
+FString FEOSMatchmakingLocalBackend::AddLobby(const FOnlineSessionSettings& SessionSettings, int32 NumMembers)
+{
+	FLocalLobby& Lobby = Lobbies.AddDefaulted_GetRef();
+	Lobby.LobbyId = FString::Printf(TEXT("LocalLobby%d"), NextLobbyId++);
+	Lobby.SessionSettings = SessionSettings;
+	Lobby.NumMembers = NumMembers;
+	return Lobby.LobbyId;
+}
+
+int32 FEOSMatchmakingLocalBackend::GetNumMembers(const FString& LobbyId) const
+{
+	for (const FLocalLobby& Lobby : Lobbies)
+	{
+		if (Lobby.LobbyId == LobbyId)
+		{
+			return Lobby.NumMembers;
+		}
+	}
+	return INDEX_NONE;
+}
+
+FEOSMatchmakingLocalBackend::FLocalLobby* FEOSMatchmakingLocalBackend::FindLobby(const FString& LobbyId)
+{
+	return Lobbies.FindByPredicate([&LobbyId](const FLocalLobby& Lobby) { return Lobby.LobbyId == LobbyId; });
+}
+
+bool FEOSMatchmakingLocalBackend::MatchesQuery(const FLocalLobby& Lobby, const FOnlineSearchSettings& QuerySettings)
+{
+	for (const TPair<FName, FOnlineSessionSearchParam>& SearchParam : QuerySettings.SearchParams)
+	{
+		// Same keys the EOS search path handles on its own
+		if (SearchParam.Key == SEARCH_LOBBIES || SearchParam.Key == SEARCH_PRESENCE || FEOSSessionSearchRanker::IsRankingSearchParam(SearchParam.Key))
+		{
+			continue;
+		}
+
+		const FOnlineSessionSetting* Setting = Lobby.SessionSettings.Settings.Find(SearchParam.Key);
+		if (Setting == nullptr)
+		{
+			return false;
+		}
+
+		double LobbyValue;
+		double SearchValue;
+		if (FEOSSessionSearchRanker::GetNumericValue(Setting->Data, LobbyValue) && FEOSSessionSearchRanker::GetNumericValue(SearchParam.Value.Data, SearchValue))
+		{
+			bool bMatches = true;
+			switch (SearchParam.Value.ComparisonOp)
+			{
+				case EOnlineComparisonOp::Equals: bMatches = LobbyValue == SearchValue; break;
+				case EOnlineComparisonOp::NotEquals: bMatches = LobbyValue != SearchValue; break;
+				case EOnlineComparisonOp::GreaterThan: bMatches = LobbyValue > SearchValue; break;
+				case EOnlineComparisonOp::GreaterThanEquals: bMatches = LobbyValue >= SearchValue; break;
+				case EOnlineComparisonOp::LessThan: bMatches = LobbyValue < SearchValue; break;
+				case EOnlineComparisonOp::LessThanEquals: bMatches = LobbyValue <= SearchValue; break;
+				default: break;
+			}
+			if (!bMatches)
+			{
+				return false;
+			}
+		}
+		else if (SearchParam.Value.ComparisonOp == EOnlineComparisonOp::NotEquals ? Setting->Data == SearchParam.Value.Data : Setting->Data != SearchParam.Value.Data)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+FEOSMatchmaker::FEOSMatchmaker(const TSharedRef<IEOSMatchmakingBackend>& InBackend, const FEOSMatchmakingSettings& InSettings, const FOnTicketComplete& InOnTicketComplete)
+	: Backend(InBackend), Settings(InSettings), OnTicketComplete(InOnTicketComplete)
+{
+}
+
+bool FEOSMatchmaker::StartTicket(int32 SearchingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	if (HasTicket(SessionName))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSMatchmaker::StartTicket] Session (%s) is already matchmaking"), *SessionName.ToString());
+		return false;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	FTicketRef Ticket = MakeShared<FTicket>();
+	Ticket->SearchingPlayerNum = SearchingPlayerNum;
+	Ticket->SessionName = SessionName;
+	Ticket->NewSessionSettings = NewSessionSettings;
+	Ticket->NewSessionSettings.bUseLobbiesIfAvailable = true;
+	Ticket->SearchSettings = SearchSettings;
+	Ticket->StartTimeInSeconds = Now;
+	Ticket->NextRoundTimeInSeconds = Now;
+	Ticket->CreateTimeInSeconds = Now + Settings.CreateLobbyAfterSeconds + FMath::FRandRange(0.f, Settings.RoundIntervalInSeconds);
+	Tickets.Add(Ticket);
+
+	SearchSettings->SearchResults.Reset();
+	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+
+	UE_LOG_ONLINE_SESSION(Log, TEXT("[FEOSMatchmaker::StartTicket] Session (%s) started matchmaking"), *SessionName.ToString());
+	return true;
+}
+
+bool FEOSMatchmaker::CancelTicket(FName SessionName)
+{
+	const int32 TicketIndex = Tickets.IndexOfByPredicate([SessionName](const FTicketRef& Ticket) { return Ticket->SessionName == SessionName; });
+	if (TicketIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	FTicketRef Ticket = Tickets[TicketIndex];
+	if (Ticket->State == ETicketState::Joining || Ticket->State == ETicketState::Creating)
+	{
+		// Too late, the lobby operation can't be taken back
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSMatchmaker::CancelTicket] Session (%s) is already joining or creating a lobby"), *SessionName.ToString());
+		return false;
+	}
+
+	// Searches still in flight see the flag and drop their results
+	Ticket->bCancelled = true;
+	Ticket->SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+	Tickets.RemoveAt(TicketIndex);
+	Metrics.NumCancellations++;
+	return true;
+}
+
+bool FEOSMatchmaker::HasTicket(FName SessionName) const
+{
+	return Tickets.ContainsByPredicate([SessionName](const FTicketRef& Ticket) { return Ticket->SessionName == SessionName; });
+}
+
+void FEOSMatchmaker::Tick()
+{
+	if (Tickets.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	// Rounds can complete tickets synchronously, so work on a copy
+	const TArray<FTicketRef> TicketsToTick = Tickets;
+	for (const FTicketRef& Ticket : TicketsToTick)
+	{
+		if (!Ticket->bCancelled && Ticket->State == ETicketState::WaitingForRound && Ticket->NextRoundTimeInSeconds <= Now)
+		{
+			StartRound(Ticket);
+		}
+	}
+}
+
+void FEOSMatchmaker::StartRound(const FTicketRef& Ticket)
+{
+	Ticket->State = ETicketState::Searching;
+	Ticket->RoundSearches.Reset();
+	Ticket->NumSearchesLaunched = 0;
+	Ticket->NumSearchesInFlight = 0;
+	MakeRoundSearches(*Ticket, Ticket->RoundSearches);
+
+	UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FEOSMatchmaker::StartRound] Session (%s) round %d runs %d searches"), *Ticket->SessionName.ToString(), Ticket->Round, Ticket->RoundSearches.Num());
+
+	LaunchSearches(Ticket);
+}
+
+void FEOSMatchmaker::MakeRoundSearches(const FTicket& Ticket, TArray<TSharedRef<FOnlineSessionSearch>>& OutSearches) const
+{
+	auto MakeSearch = [&Ticket]() {
+		TSharedRef<FOnlineSessionSearch> Search = MakeShared<FOnlineSessionSearch>();
+		Search->QuerySettings = Ticket.SearchSettings->QuerySettings;
+		Search->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
+		Search->MaxSearchResults = Ticket.SearchSettings->MaxSearchResults;
+		Search->PingBucketSize = Ticket.SearchSettings->PingBucketSize;
+		return Search;
+	};
+
+	int32 SkillBand = 0;
+	if (!Ticket.SearchSettings->QuerySettings.Get(SEARCH_EOSWRAPPER_RANK_SKILLBAND, SkillBand) || Ticket.Round > Settings.MaxSkillBandRadius)
+	{
+		// Nothing to bucket on, or every bucket came up empty: one search without a skill band
+		OutSearches.Add(MakeSearch());
+		return;
+	}
+
+	auto MakeBandSearch = [&MakeSearch](int32 Band) {
+		TSharedRef<FOnlineSessionSearch> Search = MakeSearch();
+		Search->QuerySettings.Set(SETTING_EOSWRAPPER_SKILLBAND, Band, EOnlineComparisonOp::Equals);
+		return Search;
+	};
+
+	// Nearest buckets first, they are the ones we'd rather join
+	OutSearches.Add(MakeBandSearch(SkillBand));
+	for (int32 Distance = 1; Distance <= Ticket.Round; Distance++)
+	{
+		OutSearches.Add(MakeBandSearch(SkillBand - Distance));
+		OutSearches.Add(MakeBandSearch(SkillBand + Distance));
+	}
+}
+
+void FEOSMatchmaker::LaunchSearches(const FTicketRef& Ticket)
+{
+	const int32 MaxParallelSearches = FMath::Max(Settings.MaxParallelSearches, 1);
+	while (!Ticket->bCancelled && Ticket->State == ETicketState::Searching && Ticket->NumSearchesInFlight < MaxParallelSearches &&
+		   Ticket->NumSearchesLaunched < Ticket->RoundSearches.Num())
+	{
+		TSharedRef<FOnlineSessionSearch> Search = Ticket->RoundSearches[Ticket->NumSearchesLaunched++];
+		Ticket->NumSearchesInFlight++;
+		Ticket->NumQueries++;
+		INC_DWORD_STAT(STAT_EOSWrapper_MatchmakingQueries);
+
+		Backend->SearchLobbies(Ticket->SearchingPlayerNum, Search, [WeakThis = AsWeak(), Ticket](bool bWasSuccessful) {
+			if (TSharedPtr<FEOSMatchmaker> StrongThis = WeakThis.Pin())
+			{
+				StrongThis->OnRoundSearchComplete(Ticket);
+			}
+		});
+	}
+}
+
+void FEOSMatchmaker::OnRoundSearchComplete(const FTicketRef& Ticket)
+{
+	if (Ticket->bCancelled || Ticket->State != ETicketState::Searching)
+	{
+		return;
+	}
+
+	Ticket->NumSearchesInFlight--;
+	if (Ticket->NumSearchesLaunched < Ticket->RoundSearches.Num())
+	{
+		LaunchSearches(Ticket);
+	}
+	else if (Ticket->NumSearchesInFlight == 0)
+	{
+		Arbitrate(Ticket);
+	}
+}
+
+void FEOSMatchmaker::Arbitrate(const FTicketRef& Ticket)
+{
+	// Merge the buckets, a lobby can show up in more than one of them once the skill band filter is gone.
+	// Lobbies we already failed to join count as seen so they are dropped as well
+	FOnlineSessionSearch& Search = *Ticket->SearchSettings;
+	Search.SearchResults.Reset();
+	TSet<FString> SeenSessionIds = Ticket->FailedSessionIds;
+	for (const TSharedRef<FOnlineSessionSearch>& RoundSearch : Ticket->RoundSearches)
+	{
+		for (FOnlineSessionSearchResult& SearchResult : RoundSearch->SearchResults)
+		{
+			bool bAlreadySeen = false;
+			SeenSessionIds.Add(SearchResult.Session.GetSessionIdStr(), &bAlreadySeen);
+			if (!bAlreadySeen)
+			{
+				Search.SearchResults.Add(MoveTemp(SearchResult));
+			}
+		}
+	}
+	Ticket->RoundSearches.Reset();
+
+	FEOSSessionSearchRanker::RankSearchResults(Settings.Ranking, Search);
+
+	const FOnlineSessionSearchResult* BestResult = Search.SearchResults.FindByPredicate([](const FOnlineSessionSearchResult& SearchResult) { return SearchResult.Session.NumOpenPublicConnections > 0; });
+	if (BestResult)
+	{
+		Ticket->State = ETicketState::Joining;
+		Backend->JoinLobby(Ticket->SearchingPlayerNum, Ticket->SessionName, *BestResult,
+			[WeakThis = AsWeak(), Ticket, SessionId = BestResult->Session.GetSessionIdStr()](bool bWasSuccessful) {
+				TSharedPtr<FEOSMatchmaker> StrongThis = WeakThis.Pin();
+				if (!StrongThis.IsValid())
+				{
+					return;
+				}
+
+				if (bWasSuccessful)
+				{
+					StrongThis->CompleteTicket(Ticket, true);
+				}
+				else
+				{
+					Ticket->FailedSessionIds.Add(SessionId);
+					if (FPlatformTime::Seconds() >= Ticket->CreateTimeInSeconds)
+					{
+						// We waited long enough to host ourselves, don't keep chasing lobbies that fill up before we get in
+						StrongThis->CreateLobby(Ticket);
+					}
+					else
+					{
+						// Most likely filled up since we searched, look again right away
+						StrongThis->WaitForNextRound(Ticket, 0.0);
+					}
+				}
+			});
+	}
+	else if (FPlatformTime::Seconds() >= Ticket->CreateTimeInSeconds)
+	{
+		CreateLobby(Ticket);
+	}
+	else
+	{
+		Ticket->Round++;
+		WaitForNextRound(Ticket, Settings.RoundIntervalInSeconds);
+	}
+}
+
+void FEOSMatchmaker::CreateLobby(const FTicketRef& Ticket)
+{
+	Ticket->State = ETicketState::Creating;
+	Backend->CreateLobby(Ticket->SearchingPlayerNum, Ticket->SessionName, Ticket->NewSessionSettings, [WeakThis = AsWeak(), Ticket](bool bWasSuccessful) {
+		if (TSharedPtr<FEOSMatchmaker> StrongThis = WeakThis.Pin())
+		{
+			StrongThis->CompleteTicket(Ticket, bWasSuccessful);
+		}
+	});
+}
+
+void FEOSMatchmaker::WaitForNextRound(const FTicketRef& Ticket, double DelayInSeconds)
+{
+	Ticket->State = ETicketState::WaitingForRound;
+	Ticket->NextRoundTimeInSeconds = FPlatformTime::Seconds() + DelayInSeconds;
+}
+
+void FEOSMatchmaker::CompleteTicket(const FTicketRef& Ticket, bool bWasSuccessful)
+{
+	Tickets.Remove(Ticket);
+	Ticket->SearchSettings->SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
+
+	const double TimeToMatch = FPlatformTime::Seconds() - Ticket->StartTimeInSeconds;
+	if (bWasSuccessful)
+	{
+		Metrics.NumMatches++;
+		Metrics.TotalTimeToMatchInSeconds += TimeToMatch;
+		Metrics.TotalQueries += Ticket->NumQueries;
+
+		INC_DWORD_STAT(STAT_EOSWrapper_MatchmakingMatches);
+		SET_FLOAT_STAT(STAT_EOSWrapper_MatchmakingAverageTimeToMatch, Metrics.GetAverageTimeToMatch());
+		SET_FLOAT_STAT(STAT_EOSWrapper_MatchmakingAverageQueriesPerMatch, Metrics.GetAverageQueriesPerMatch());
+	}
+	else
+	{
+		Metrics.NumFailures++;
+	}
+
+	UE_LOG_ONLINE_SESSION(Log, TEXT("[FEOSMatchmaker::CompleteTicket] Session (%s) %s after %.2f seconds, %d rounds and %d queries"), *Ticket->SessionName.ToString(),
+		bWasSuccessful ? TEXT("matched") : TEXT("failed"), TimeToMatch, Ticket->Round + 1, Ticket->NumQueries);
+
+	OnTicketComplete(Ticket->SessionName, bWasSuccessful);
+}
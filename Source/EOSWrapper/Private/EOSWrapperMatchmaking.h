@@ -0,0 +1,152 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "EOSWrapperSessionRanking.h"
+
+/** Lobby operations the matchmaker is built on. The session manager implements them over EOS lobbies, FEOSMatchmakingLocalBackend in memory */
+class IEOSMatchmakingBackend
+{
+public:
+	typedef TFunction<void(bool bWasSuccessful)> FOnBackendOperationComplete;
+
+	virtual ~IEOSMatchmakingBackend() = default;
+
+	/** Runs a single lobby search for the query settings, results are written to Search->SearchResults */
+	virtual void SearchLobbies(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& Search, const FOnBackendOperationComplete& Callback) = 0;
+	virtual void JoinLobby(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& SearchResult, const FOnBackendOperationComplete& Callback) = 0;
+	virtual void CreateLobby(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& SessionSettings, const FOnBackendOperationComplete& Callback) = 0;
+};
+
+/** In memory stand-in for the EOS lobby service, lets the matchmaker run without a backend. Operations complete synchronously */
+class FEOSMatchmakingLocalBackend : public IEOSMatchmakingBackend
+{
+public:
+	virtual void SearchLobbies(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& Search, const FOnBackendOperationComplete& Callback) override;
+	virtual void JoinLobby(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& SearchResult, const FOnBackendOperationComplete& Callback) override;
+	virtual void CreateLobby(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& SessionSettings, const FOnBackendOperationComplete& Callback) override;
+
+	/** Adds a lobby as if another player had created it, returns its id */
+	FString AddLobby(const FOnlineSessionSettings& SessionSettings, int32 NumMembers = 1);
+	/** Number of members in a lobby, INDEX_NONE if it doesn't exist */
+	int32 GetNumMembers(const FString& LobbyId) const;
+	int32 GetNumLobbies() const { return Lobbies.Num(); }
+	int32 GetNumSearches() const { return NumSearches; }
+
+private:
+	struct FLocalLobby
+	{
+		FString LobbyId;
+		FOnlineSessionSettings SessionSettings;
+		int32 NumMembers = 0;
+	};
+
+	static bool MatchesQuery(const FLocalLobby& Lobby, const FOnlineSearchSettings& QuerySettings);
+	FLocalLobby* FindLobby(const FString& LobbyId);
+
+	TArray<FLocalLobby> Lobbies;
+	int32 NextLobbyId = 0;
+	int32 NumSearches = 0;
+};
+
+/** Tuning for the matchmaker */
+struct FEOSMatchmakingSettings
+{
+	/** Time between search rounds while a ticket has not matched */
+	float RoundIntervalInSeconds = 2.f;
+	/** How far the skill band buckets widen around the searcher's band, one band per round. Past it a round searches without a skill band */
+	int32 MaxSkillBandRadius = 3;
+	/** Upper bound for lobby searches a ticket runs at the same time */
+	int32 MaxParallelSearches = 4;
+	/** Time after which a ticket that found nothing to join creates its own lobby */
+	float CreateLobbyAfterSeconds = 10.f;
+	/** Used to pick the lobby to join out of a round's results */
+	FEOSSessionRankingSettings Ranking;
+};
+
+/** Running totals over all tickets, see also "stat EOSWrapper" */
+struct FEOSMatchmakingMetrics
+{
+	int32 NumMatches = 0;
+	int32 NumFailures = 0;
+	int32 NumCancellations = 0;
+	double TotalTimeToMatchInSeconds = 0.0;
+	int32 TotalQueries = 0;
+
+	double GetAverageTimeToMatch() const { return NumMatches > 0 ? TotalTimeToMatchInSeconds / NumMatches : 0.0; }
+	double GetAverageQueriesPerMatch() const { return NumMatches > 0 ? (double)TotalQueries / NumMatches : 0.0; }
+};
+
+/**
+ * Client side matchmaking on top of lobby searches.
+ * Every ticket searches in rounds. A round runs one lobby search per skill band bucket around the searcher's SEARCH_EOSWRAPPER_RANK_SKILLBAND,
+ * a few of them in parallel, and the buckets widen by one band every round. Once a round completed its results are merged, ranked and the best open
+ * lobby is joined. A ticket that found nothing to join for long enough creates a lobby instead.
+ */
+class FEOSMatchmaker : public TSharedFromThis<FEOSMatchmaker>
+{
+public:
+	/** Called once per ticket that matched or failed, cancelled tickets don't complete */
+	typedef TFunction<void(FName SessionName, bool bWasSuccessful)> FOnTicketComplete;
+
+	FEOSMatchmaker(const TSharedRef<IEOSMatchmakingBackend>& InBackend, const FEOSMatchmakingSettings& InSettings, const FOnTicketComplete& InOnTicketComplete);
+
+	/** Queues a ticket, its first round starts on the next Tick. Fails if the session already has a ticket */
+	bool StartTicket(int32 SearchingPlayerNum, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	/** Drops a ticket. Fails if there is none or it is already joining or creating a lobby */
+	bool CancelTicket(FName SessionName);
+	bool HasTicket(FName SessionName) const;
+	void Tick();
+
+	const FEOSMatchmakingMetrics& GetMetrics() const { return Metrics; }
+
+private:
+	enum class ETicketState : uint8
+	{
+		WaitingForRound,
+		Searching,
+		Joining,
+		Creating
+	};
+
+	struct FTicket
+	{
+		int32 SearchingPlayerNum = 0;
+		FName SessionName;
+		FOnlineSessionSettings NewSessionSettings;
+		TSharedPtr<FOnlineSessionSearch> SearchSettings;
+		ETicketState State = ETicketState::WaitingForRound;
+		bool bCancelled = false;
+		double StartTimeInSeconds = 0.0;
+		double NextRoundTimeInSeconds = 0.0;
+		/** Jittered per ticket so players who started together don't all create a lobby at once */
+		double CreateTimeInSeconds = 0.0;
+		int32 Round = 0;
+		int32 NumQueries = 0;
+		/** Searches of the current round, launched in order as earlier ones complete */
+		TArray<TSharedRef<FOnlineSessionSearch>> RoundSearches;
+		int32 NumSearchesLaunched = 0;
+		int32 NumSearchesInFlight = 0;
+		/** Lobbies we failed to join, left out of later rounds so the ticket doesn't keep picking the same one */
+		TSet<FString> FailedSessionIds;
+	};
+	typedef TSharedRef<FTicket> FTicketRef;
+
+	void StartRound(const FTicketRef& Ticket);
+	void MakeRoundSearches(const FTicket& Ticket, TArray<TSharedRef<FOnlineSessionSearch>>& OutSearches) const;
+	void LaunchSearches(const FTicketRef& Ticket);
+	void OnRoundSearchComplete(const FTicketRef& Ticket);
+	void Arbitrate(const FTicketRef& Ticket);
+	void CreateLobby(const FTicketRef& Ticket);
+	void WaitForNextRound(const FTicketRef& Ticket, double DelayInSeconds);
+	void CompleteTicket(const FTicketRef& Ticket, bool bWasSuccessful);
+
+	TSharedRef<IEOSMatchmakingBackend> Backend;
+	FEOSMatchmakingSettings Settings;
+	FOnTicketComplete OnTicketComplete;
+	TArray<FTicketRef> Tickets;
+	FEOSMatchmakingMetrics Metrics;
+};
@@ -0,0 +1,348 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperQos.h"
+#include "EOSWrapperTypes.h"
+#include "HAL/RunnableThread.h"
+#include "OnlineSubsystemTypes.h"
+#include "OnlineSubsystem.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("QoS probes sent"), STAT_EOSWrapper_QosProbesSent, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("QoS probes answered"), STAT_EOSWrapper_QosProbesAnswered, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("QoS probes lost"), STAT_EOSWrapper_QosProbesLost, STATGROUP_EOSWrapper);
+
+void FEOSQosPacket::Write(uint8* Packet, uint32 Nonce, uint16 TargetIndex, uint16 SampleIndex)
+{
+	const uint32 PacketMagic = Magic;
+	FMemory::Memcpy(Packet, &PacketMagic, 4);
+	FMemory::Memcpy(Packet + 4, &Nonce, 4);
+	FMemory::Memcpy(Packet + 8, &TargetIndex, 2);
+	FMemory::Memcpy(Packet + 10, &SampleIndex, 2);
+}
+
+bool FEOSQosPacket::Read(const uint8* Packet, int32 PacketSize, uint32& OutNonce, uint16& OutTargetIndex, uint16& OutSampleIndex)
+{
+	uint32 PacketMagic = 0;
+	if (PacketSize != Size)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(&PacketMagic, Packet, 4);
+	FMemory::Memcpy(&OutNonce, Packet + 4, 4);
+	FMemory::Memcpy(&OutTargetIndex, Packet + 8, 2);
+	FMemory::Memcpy(&OutSampleIndex, Packet + 10, 2);
+	return PacketMagic == Magic;
+}
+
+FEOSQosProber::FEOSQosProber(int32 InNumSamples, double InSampleIntervalInSeconds, double InTimeoutInSeconds)
+	: NumSamples(FMath::Clamp(InNumSamples, 1, (int32)MAX_uint16)), SampleIntervalInSeconds(InSampleIntervalInSeconds), TimeoutInSeconds(InTimeoutInSeconds)
+{
+}
+
+FEOSQosProber::~FEOSQosProber()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (Socket)
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
+
+bool FEOSQosProber::CreateSocket()
+{
+	if (Socket)
+	{
+		return true;
+	}
+
+	SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("EOSWrapper QoS prober"), FNetworkProtocolTypes::IPv4);
+	if (Socket == nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSQosProber::CreateSocket] Unable to create socket"));
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> LocalAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	LocalAddress->SetAnyAddress();
+	LocalAddress->SetPort(0);
+	if (!Socket->SetNonBlocking(true) || !Socket->Bind(*LocalAddress))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSQosProber::CreateSocket] Unable to bind socket"));
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	FromAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	return true;
+}
+
+bool FEOSQosProber::Start(const TArray<TSharedPtr<FInternetAddr>>& InTargets, const FOnProbeComplete& InOnComplete)
+{
+	if (IsRunning() || InTargets.Num() > MAX_uint16 || !CreateSocket())
+	{
+		return false;
+	}
+
+	Targets = InTargets;
+	Samples.Reset();
+	Samples.SetNum(Targets.Num() * NumSamples);
+	OnComplete = InOnComplete;
+	StartTimeInSeconds = FPlatformTime::Seconds();
+	NumRoundsSent = 0;
+	// Replies to an earlier run can still be on their way, they must not count for this one
+	Nonce = FMath::Rand() ^ (uint32)FPlatformTime::Cycles();
+	bStopRequested = false;
+	bFinished = false;
+
+	Thread = FRunnableThread::Create(this, TEXT("EOSWrapperQosProber"), 0, TPri_AboveNormal);
+	return Thread != nullptr;
+}
+
+uint32 FEOSQosProber::Run()
+{
+	while (!bStopRequested)
+	{
+		const double Now = FPlatformTime::Seconds();
+		SendDueProbes(Now);
+		ReceiveReplies();
+		if (!HasPendingSamples(Now))
+		{
+			break;
+		}
+		Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(1));
+	}
+
+	bFinished = true;
+	return 0;
+}
+
+void FEOSQosProber::SendDueProbes(double Now)
+{
+	uint8 Packet[FEOSQosPacket::Size];
+	while (NumRoundsSent < NumSamples && Now >= StartTimeInSeconds + NumRoundsSent * SampleIntervalInSeconds)
+	{
+		for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); TargetIndex++)
+		{
+			if (!Targets[TargetIndex].IsValid())
+			{
+				continue;
+			}
+
+			FEOSQosPacket::Write(Packet, Nonce, (uint16)TargetIndex, (uint16)NumRoundsSent);
+			int32 BytesSent = 0;
+			FSample& Sample = Samples[TargetIndex * NumSamples + NumRoundsSent];
+			Sample.SendTimeInSeconds = FPlatformTime::Seconds();
+			Sample.bSent = Socket->SendTo(Packet, FEOSQosPacket::Size, BytesSent, *Targets[TargetIndex]) && BytesSent == FEOSQosPacket::Size;
+		}
+		NumRoundsSent++;
+	}
+}
+
+void FEOSQosProber::ReceiveReplies()
+{
+	// Anything bigger than a probe isn't one, but still has to be drained
+	uint8 Packet[64];
+	int32 BytesRead = 0;
+	while (Socket->RecvFrom(Packet, sizeof(Packet), BytesRead, *FromAddress) && BytesRead > 0)
+	{
+		const double ReceiveTimeInSeconds = FPlatformTime::Seconds();
+
+		uint32 PacketNonce;
+		uint16 TargetIndex;
+		uint16 SampleIndex;
+		if (!FEOSQosPacket::Read(Packet, BytesRead, PacketNonce, TargetIndex, SampleIndex) || PacketNonce != Nonce || TargetIndex >= Targets.Num() || SampleIndex >= NumSamples)
+		{
+			continue;
+		}
+
+		FSample& Sample = Samples[TargetIndex * NumSamples + SampleIndex];
+		const double RoundTripInSeconds = ReceiveTimeInSeconds - Sample.SendTimeInSeconds;
+		if (Sample.bSent && Sample.RoundTripInMs < 0.f && RoundTripInSeconds <= TimeoutInSeconds)
+		{
+			Sample.RoundTripInMs = (float)(RoundTripInSeconds * 1000.0);
+		}
+	}
+}
+
+bool FEOSQosProber::HasPendingSamples(double Now) const
+{
+	if (NumRoundsSent < NumSamples)
+	{
+		return true;
+	}
+
+	for (const FSample& Sample : Samples)
+	{
+		if (Sample.bSent && Sample.RoundTripInMs < 0.f && Now - Sample.SendTimeInSeconds <= TimeoutInSeconds)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+int32 FEOSQosProber::GetMedianPingInMs(int32 TargetIndex) const
+{
+	TArray<float, TInlineAllocator<8>> RoundTrips;
+	for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++)
+	{
+		const FSample& Sample = Samples[TargetIndex * NumSamples + SampleIndex];
+		if (Sample.RoundTripInMs >= 0.f)
+		{
+			RoundTrips.Add(Sample.RoundTripInMs);
+		}
+	}
+
+	if (RoundTrips.Num() == 0)
+	{
+		return MAX_QUERY_PING;
+	}
+
+	RoundTrips.Sort();
+	const int32 Middle = RoundTrips.Num() / 2;
+	const float Median = RoundTrips.Num() % 2 == 1 ? RoundTrips[Middle] : (RoundTrips[Middle - 1] + RoundTrips[Middle]) * 0.5f;
+	return FMath::Clamp(FMath::RoundToInt(Median), 0, MAX_QUERY_PING);
+}
+
+void FEOSQosProber::Tick()
+{
+	if (Thread == nullptr || !bFinished)
+	{
+		return;
+	}
+
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+
+	int32 NumSent = 0;
+	int32 NumAnswered = 0;
+	for (const FSample& Sample : Samples)
+	{
+		NumSent += Sample.bSent ? 1 : 0;
+		NumAnswered += Sample.RoundTripInMs >= 0.f ? 1 : 0;
+	}
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_QosProbesSent, NumSent);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_QosProbesAnswered, NumAnswered);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_QosProbesLost, NumSent - NumAnswered);
+
+	TArray<int32> PingsInMs;
+	PingsInMs.SetNumUninitialized(Targets.Num());
+	for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); TargetIndex++)
+	{
+		PingsInMs[TargetIndex] = GetMedianPingInMs(TargetIndex);
+	}
+
+	UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FEOSQosProber::Tick] Pinged %d hosts in %.3f seconds, %d of %d probes answered"), Targets.Num(), FPlatformTime::Seconds() - StartTimeInSeconds,
+		NumAnswered, NumSent);
+
+	Targets.Reset();
+	FOnProbeComplete Callback = MoveTemp(OnComplete);
+	Callback(PingsInMs);
+}
+
+FEOSQosResponder::~FEOSQosResponder()
+{
+	Shutdown();
+}
+
+bool FEOSQosResponder::Start(int32 InPort)
+{
+	if (Thread)
+	{
+		return true;
+	}
+
+	SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("EOSWrapper QoS responder"), FNetworkProtocolTypes::IPv4);
+	if (Socket == nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSQosResponder::Start] Unable to create socket"));
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> LocalAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	LocalAddress->SetAnyAddress();
+	LocalAddress->SetPort(InPort);
+	if (!Socket->SetNonBlocking(true) || !Socket->Bind(*LocalAddress))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSQosResponder::Start] Unable to bind port %d"), InPort);
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+		return false;
+	}
+
+	Port = InPort;
+	bStopRequested = false;
+	Thread = FRunnableThread::Create(this, TEXT("EOSWrapperQosResponder"), 0, TPri_AboveNormal);
+	UE_LOG_ONLINE_SESSION(Log, TEXT("[FEOSQosResponder::Start] Answering QoS probes on port %d"), Port);
+	return Thread != nullptr;
+}
+
+void FEOSQosResponder::Shutdown()
+{
+	if (Thread)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (Socket)
+	{
+		SocketSubsystem->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+	Port = 0;
+}
+
+uint32 FEOSQosResponder::Run()
+{
+	TSharedRef<FInternetAddr> FromAddress = SocketSubsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+	uint8 Packet[64];
+	while (!bStopRequested)
+	{
+		if (!Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)))
+		{
+			continue;
+		}
+
+		int32 BytesRead = 0;
+		while (Socket->RecvFrom(Packet, sizeof(Packet), BytesRead, *FromAddress) && BytesRead > 0)
+		{
+			// Only probes get an answer, and never a bigger one, so this can't be used to amplify traffic
+			uint32 Nonce;
+			uint16 TargetIndex;
+			uint16 SampleIndex;
+			if (FEOSQosPacket::Read(Packet, BytesRead, Nonce, TargetIndex, SampleIndex))
+			{
+				int32 BytesSent = 0;
+				Socket->SendTo(Packet, BytesRead, BytesSent, *FromAddress);
+			}
+		}
+	}
+	return 0;
+}
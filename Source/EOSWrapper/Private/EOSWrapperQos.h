@@ -0,0 +1,106 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+
+class FSocket;
+class FInternetAddr;
+class FRunnableThread;
+class ISocketSubsystem;
+
+/**
+ * Wire format of a QoS probe: magic, run nonce, target index, sample index. Responders echo probes back unchanged, so plain UDP echo servers work too.
+ */
+struct FEOSQosPacket
+{
+	static constexpr uint32 Magic = 0x534F5145;
+	static constexpr int32 Size = 12;
+
+	static void Write(uint8* Packet, uint32 Nonce, uint16 TargetIndex, uint16 SampleIndex);
+	static bool Read(const uint8* Packet, int32 PacketSize, uint32& OutNonce, uint16& OutTargetIndex, uint16& OutSampleIndex);
+};
+
+/**
+ * Measures round trip times to a set of hosts over UDP from a single non-blocking socket.
+ * Every host gets NumSamples probes spaced SampleInterval apart, all hosts in parallel. Probes not answered within the timeout count as lost and a host's
+ * ping is the median of its answered probes. Sending and receiving happen on a worker thread so round trips aren't rounded up to the frame time,
+ * the completion callback runs from Tick on the game thread.
+ */
+class FEOSQosProber : public FRunnable
+{
+public:
+	/** One entry per target in the order they were passed to Start, MAX_QUERY_PING for hosts that never answered */
+	typedef TFunction<void(const TArray<int32>& PingsInMs)> FOnProbeComplete;
+
+	FEOSQosProber(int32 InNumSamples, double InSampleIntervalInSeconds, double InTimeoutInSeconds);
+	virtual ~FEOSQosProber();
+
+	/** Targets may be null for hosts that can't be pinged, they come back as MAX_QUERY_PING. Fails while a probe is running */
+	bool Start(const TArray<TSharedPtr<FInternetAddr>>& InTargets, const FOnProbeComplete& InOnComplete);
+	bool IsRunning() const { return Thread != nullptr; }
+	/** Hands the results of a finished probe to its callback */
+	void Tick();
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested = true; }
+
+private:
+	struct FSample
+	{
+		double SendTimeInSeconds = 0.0;
+		float RoundTripInMs = -1.f;
+		bool bSent = false;
+	};
+
+	bool CreateSocket();
+	void SendDueProbes(double Now);
+	void ReceiveReplies();
+	bool HasPendingSamples(double Now) const;
+	int32 GetMedianPingInMs(int32 TargetIndex) const;
+
+	ISocketSubsystem* SocketSubsystem = nullptr;
+	FSocket* Socket = nullptr;
+	FRunnableThread* Thread = nullptr;
+	FThreadSafeBool bStopRequested;
+	FThreadSafeBool bFinished;
+
+	int32 NumSamples;
+	double SampleIntervalInSeconds;
+	double TimeoutInSeconds;
+
+	TArray<TSharedPtr<FInternetAddr>> Targets;
+	/** NumSamples per target, target major */
+	TArray<FSample> Samples;
+	TSharedPtr<FInternetAddr> FromAddress;
+	FOnProbeComplete OnComplete;
+	double StartTimeInSeconds = 0.0;
+	int32 NumRoundsSent = 0;
+	uint32 Nonce = 0;
+};
+
+/** Echoes QoS probes back to their sender so clients can ping this host. Runs on its own thread so replies don't wait for the server tick */
+class FEOSQosResponder : public FRunnable
+{
+public:
+	virtual ~FEOSQosResponder();
+
+	bool Start(int32 InPort);
+	void Shutdown();
+	int32 GetPort() const { return Port; }
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopRequested = true; }
+
+private:
+	ISocketSubsystem* SocketSubsystem = nullptr;
+	FSocket* Socket = nullptr;
+	FRunnableThread* Thread = nullptr;
+	FThreadSafeBool bStopRequested;
+	int32 Port = 0;
+};
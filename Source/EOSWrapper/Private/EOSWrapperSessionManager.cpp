@@ -4,7 +4,15 @@
 #include "EOSWrapperSessionManager.h"
 #include "EOSWrapperSubsystem.h"
 #include "EOSWrapperUserManager.h"
+#include "EOSWrapperSettings.h"
+#include "EOSWrapperSessionSearch.h"
+#include "SocketSubsystem.h"
+#include "IPAddress.h"
+#include "OnlineSubsystemUtils.h"
 #include "EOSShared.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 
 #if WITH_EOS_SDK
 #include "eos_logging.h"
@@ -15,9 +23,27 @@
 #include "eos_auth.h"
 #include "eos_metrics.h"
 #include "eos_sessions.h"
+#include "eos_presence.h"
 
 #pragma optimize("", off)
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session attributes sent"), STAT_EOSWrapper_SessionAttributesSent, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session updates skipped"), STAT_EOSWrapper_SessionUpdatesSkipped, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Session updates coalesced"), STAT_EOSWrapper_SessionUpdatesCoalesced, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Player registrations batched"), STAT_EOSWrapper_PlayerRegistrationsBatched, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Search pages fetched"), STAT_EOSWrapper_SearchPagesFetched, STATGROUP_EOSWrapper);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Partitioned search time (ms)"), STAT_EOSWrapper_PartitionedSearchTimeMs, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Friend session searches skipped"), STAT_EOSWrapper_FriendSessionSearchesSkipped, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Sessions restored from snapshot"), STAT_EOSWrapper_SessionsRestored, STATGROUP_EOSWrapper);
+DECLARE_CYCLE_STAT(TEXT("Write session snapshot"), STAT_EOSWrapper_WriteSessionSnapshot, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Named sessions"), STAT_EOSWrapper_NamedSessions, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Member statuses batched"), STAT_EOSWrapper_MemberStatusesBatched, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lobby updates without changes"), STAT_EOSWrapper_LobbyUpdatesUnchanged, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lobby member resolves skipped"), STAT_EOSWrapper_LobbyMemberResolvesSkipped, STATGROUP_EOSWrapper);
+DECLARE_CYCLE_STAT(TEXT("Apply lobby update"), STAT_EOSWrapper_ApplyLobbyUpdate, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("LAN sessions discovered"), STAT_EOSWrapper_LanSessionsDiscovered, STATGROUP_EOSWrapper);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("LAN discovery latency (ms)"), STAT_EOSWrapper_LanDiscoveryLatency, STATGROUP_EOSWrapper);
+
 /** This is the game name plus version in ansi done once for optimization */
 char BucketIdAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
 
@@ -43,19 +69,58 @@ FString MakeStringFromAttributeValue(const EOS_Sessions_AttributeData* Attribute
 	return TEXT("");
 }
 
-struct FAttributeOptions : public EOS_Sessions_AttributeData
+const char* FEOSAttributeArena::Store(const char* Utf8String, int32 Length)
+{
+	const int32 Needed = Length + 1;
+	while (Blocks.IsValidIndex(CurrentBlock) && Blocks[CurrentBlock].GetSlack() < Needed)
+	{
+		CurrentBlock++;
+	}
+	if (!Blocks.IsValidIndex(CurrentBlock))
+	{
+		CurrentBlock = Blocks.AddDefaulted();
+		Blocks[CurrentBlock].Reserve(FMath::Max(BlockSize, Needed));
+	}
+
+	TArray<char>& Block = Blocks[CurrentBlock];
+	const int32 Offset = Block.AddUninitialized(Needed);
+	FMemory::Memcpy(Block.GetData() + Offset, Utf8String, Length);
+	Block[Offset + Length] = '\0';
+	return Block.GetData() + Offset;
+}
+
+const char* FEOSAttributeArena::Store(const TCHAR* String)
+{
+	// Short strings convert in the converter's inline buffer
+	const FTCHARToUTF8 Converter(String);
+	return Store(Converter.Get(), Converter.Length());
+}
+
+const char* FEOSAttributeArena::Store(const FName& Name)
+{
+	TStringBuilder<NAME_SIZE> NameString;
+	Name.AppendString(NameString);
+	return Store(NameString.ToString());
+}
+
+void FEOSAttributeArena::Reset()
 {
-	char KeyAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
-	char ValueAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
+	for (TArray<char>& Block : Blocks)
+	{
+		Block.Reset();
+	}
+	CurrentBlock = 0;
+}
 
+/** Key and string values are not copied, they must point at literals or strings stored in an FEOSAttributeArena */
+struct FAttributeOptions : public EOS_Sessions_AttributeData
+{
 	FAttributeOptions(const char* InKey, const char* InValue) : EOS_Sessions_AttributeData()
 	{
 		ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ESessionAttributeType::EOS_SAT_String;
-		Value.AsUtf8 = ValueAnsi;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
-		FCStringAnsi::Strncpy(ValueAnsi, InValue, EOS_OSS_STRING_BUFFER_LENGTH);
+		Value.AsUtf8 = InValue;
+		Key = InKey;
 	}
 
 	FAttributeOptions(const char* InKey, bool InValue) : EOS_Sessions_AttributeData()
@@ -63,8 +128,7 @@ struct FAttributeOptions : public EOS_Sessions_AttributeData
 		ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ESessionAttributeType::EOS_SAT_Boolean;
 		Value.AsBool = InValue ? EOS_TRUE : EOS_FALSE;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
 	FAttributeOptions(const char* InKey, float InValue) : EOS_Sessions_AttributeData()
@@ -72,8 +136,7 @@ struct FAttributeOptions : public EOS_Sessions_AttributeData
 		ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ESessionAttributeType::EOS_SAT_Double;
 		Value.AsDouble = InValue;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
 	FAttributeOptions(const char* InKey, int32 InValue) : EOS_Sessions_AttributeData()
@@ -81,13 +144,13 @@ struct FAttributeOptions : public EOS_Sessions_AttributeData
 		ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ESessionAttributeType::EOS_SAT_Int64;
 		Value.AsInt64 = InValue;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
-	FAttributeOptions(const char* InKey, const FVariantData& InValue) : EOS_Sessions_AttributeData()
+	FAttributeOptions(const char* InKey, const FVariantData& InValue, FEOSAttributeArena& Arena) : EOS_Sessions_AttributeData()
 	{
 		ApiVersion = EOS_SESSIONS_SESSIONATTRIBUTEDATA_API_LATEST;
+		Key = InKey;
 
 		switch (InValue.GetType())
 		{
@@ -142,32 +205,24 @@ struct FAttributeOptions : public EOS_Sessions_AttributeData
 			case EOnlineKeyValuePairDataType::String:
 			{
 				ValueType = EOS_ESessionAttributeType::EOS_SAT_String;
-				Value.AsUtf8 = ValueAnsi;
-				Key = KeyAnsi;
 				FString OutString;
 				InValue.GetValue(OutString);
-				FCStringAnsi::Strncpy(ValueAnsi, TCHAR_TO_UTF8(*OutString), EOS_OSS_STRING_BUFFER_LENGTH);
+				Value.AsUtf8 = Arena.Store(*OutString);
 				break;
 			}
 		}
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
 	}
 };
 
+/** Key and string values are not copied, they must point at literals or strings stored in an FEOSAttributeArena */
 struct FLobbyAttributeOptions : public EOS_Lobby_AttributeData
 {
-	char KeyAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
-	char ValueAnsi[EOS_OSS_STRING_BUFFER_LENGTH];
-
 	FLobbyAttributeOptions(const char* InKey, const char* InValue) : EOS_Lobby_AttributeData()
 	{
 		ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ELobbyAttributeType::EOS_SAT_String;
-		Value.AsUtf8 = ValueAnsi;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
-		FCStringAnsi::Strncpy(ValueAnsi, InValue, EOS_OSS_STRING_BUFFER_LENGTH);
+		Value.AsUtf8 = InValue;
+		Key = InKey;
 	}
 
 	FLobbyAttributeOptions(const char* InKey, bool InValue) : EOS_Lobby_AttributeData()
@@ -175,8 +230,7 @@ struct FLobbyAttributeOptions : public EOS_Lobby_AttributeData
 		ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ELobbyAttributeType::EOS_SAT_Boolean;
 		Value.AsBool = InValue ? EOS_TRUE : EOS_FALSE;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
 	FLobbyAttributeOptions(const char* InKey, float InValue) : EOS_Lobby_AttributeData()
@@ -184,8 +238,7 @@ struct FLobbyAttributeOptions : public EOS_Lobby_AttributeData
 		ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ELobbyAttributeType::EOS_SAT_Double;
 		Value.AsDouble = InValue;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
 	FLobbyAttributeOptions(const char* InKey, int32 InValue) : EOS_Lobby_AttributeData()
@@ -193,13 +246,13 @@ struct FLobbyAttributeOptions : public EOS_Lobby_AttributeData
 		ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
 		ValueType = EOS_ELobbyAttributeType::EOS_SAT_Int64;
 		Value.AsInt64 = InValue;
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
+		Key = InKey;
 	}
 
-	FLobbyAttributeOptions(const char* InKey, const FVariantData& InValue) : EOS_Lobby_AttributeData()
+	FLobbyAttributeOptions(const char* InKey, const FVariantData& InValue, FEOSAttributeArena& Arena) : EOS_Lobby_AttributeData()
 	{
 		ApiVersion = EOS_LOBBY_ATTRIBUTEDATA_API_LATEST;
+		Key = InKey;
 
 		switch (InValue.GetType())
 		{
@@ -255,16 +308,12 @@ struct FLobbyAttributeOptions : public EOS_Lobby_AttributeData
 			case EOnlineKeyValuePairDataType::Json:
 			{
 				ValueType = EOS_ELobbyAttributeType::EOS_SAT_String;
-				Value.AsUtf8 = ValueAnsi;
-				Key = KeyAnsi;
 				FString OutString;
 				InValue.GetValue(OutString);
-				FCStringAnsi::Strncpy(ValueAnsi, TCHAR_TO_UTF8(*OutString), EOS_OSS_STRING_BUFFER_LENGTH);
+				Value.AsUtf8 = Arena.Store(*OutString);
 				break;
 			}
 		}
-		Key = KeyAnsi;
-		FCStringAnsi::Strncpy(KeyAnsi, InKey, EOS_OSS_STRING_BUFFER_LENGTH);
 	}
 };
 
@@ -315,6 +364,30 @@ bool IsSessionSettingTypeSupported(EOnlineKeyValuePairDataType::Type InType)
 	return false;
 }
 
+/** Address QoS probes for a search result go to, null for hosts that can't be pinged (P2P hosts only have a PUID) */
+static TSharedPtr<FInternetAddr> GetQosAddressFromSearchResult(const FOnlineSessionSearchResult& SearchResult)
+{
+	const TSharedPtr<FOnlineSessionInfoEOS> SessionInfo = StaticCastSharedPtr<FOnlineSessionInfoEOS>(SearchResult.Session.SessionInfo);
+	if (!SessionInfo.IsValid() || SessionInfo->EOSAddress.IsEmpty() || SessionInfo->EOSAddress.StartsWith(EOS_CONNECTION_URL_PREFIX, ESearchCase::IgnoreCase))
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FInternetAddr> QosAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetAddressFromString(SessionInfo->EOSAddress);
+	if (!QosAddress.IsValid() || !QosAddress->IsValid())
+	{
+		return nullptr;
+	}
+
+	// Without an advertised responder port the host address has to carry one, which is what a plain echo server looks like
+	int32 QosPort = 0;
+	if (SearchResult.Session.SessionSettings.Get(SETTING_EOSWRAPPER_QOSPORT, QosPort) && QosPort > 0)
+	{
+		QosAddress->SetPort(QosPort);
+	}
+	return QosAddress->GetPort() > 0 ? QosAddress : nullptr;
+}
+
 /** Get a resolved connection string from a session info */
 static bool GetConnectStringFromSessionInfo(TSharedPtr<FOnlineSessionInfoEOS>& SessionInfo, FString& ConnectInfo, int32 PortOverride = 0)
 {
@@ -409,31 +482,31 @@ FOnlineSessionInfoEOS::~FOnlineSessionInfoEOS()
 	}
 }
 
-// void FOnlineSessionInfoEOS::InitLAN(FOnlineSubsystemEOS* Subsystem)
-// {
-// 	// Read the IP from the system
-// 	bool bCanBindAll;
-// 	HostAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLocalHostAddr(*GLog, bCanBindAll);
-//
-// 	// The below is a workaround for systems that set hostname to a distinct address from 127.0.0.1 on a loopback interface.
-// 	// See e.g. https://www.debian.org/doc/manuals/debian-reference/ch05.en.html#_the_hostname_resolution
-// 	// and http://serverfault.com/questions/363095/why-does-my-hostname-appear-with-the-address-127-0-1-1-rather-than-127-0-0-1-in
-// 	// Since we bind to 0.0.0.0, we won't answer on 127.0.1.1, so we need to advertise ourselves as 127.0.0.1 for any other loopback address we may have.
-// 	uint32 HostIp = 0;
-// 	HostAddr->GetIp(HostIp); // will return in host order
-// 	// if this address is on loopback interface, advertise it as 127.0.0.1
-// 	if ((HostIp & 0xff000000) == 0x7f000000)
-// 	{
-// 		HostAddr->SetIp(0x7f000001);	// 127.0.0.1
-// 	}
-//
-// 	// Now set the port that was configured
-// 	HostAddr->SetPort(GetPortFromNetDriver(Subsystem->GetInstanceName()));
-//
-// 	FGuid OwnerGuid;
-// 	FPlatformMisc::CreateGuid(OwnerGuid);
-// 	SessionId = FUniqueNetIdEOSSession::Create(OwnerGuid.ToString());
-// }
+void FOnlineSessionInfoEOS::InitLAN(FEOSWrapperSubsystem* Subsystem)
+{
+	// Read the IP from the system
+	bool bCanBindAll;
+	HostAddr = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLocalHostAddr(*GLog, bCanBindAll);
+
+	// The below is a workaround for systems that set hostname to a distinct address from 127.0.0.1 on a loopback interface.
+	// See e.g. https://www.debian.org/doc/manuals/debian-reference/ch05.en.html#_the_hostname_resolution
+	// and http://serverfault.com/questions/363095/why-does-my-hostname-appear-with-the-address-127-0-1-1-rather-than-127-0-0-1-in
+	// Since we bind to 0.0.0.0, we won't answer on 127.0.1.1, so we need to advertise ourselves as 127.0.0.1 for any other loopback address we may have.
+	uint32 HostIp = 0;
+	HostAddr->GetIp(HostIp); // will return in host order
+	// if this address is on loopback interface, advertise it as 127.0.0.1
+	if ((HostIp & 0xff000000) == 0x7f000000)
+	{
+		HostAddr->SetIp(0x7f000001);	// 127.0.0.1
+	}
+
+	// Now set the port that was configured
+	HostAddr->SetPort(GetPortFromNetDriver(Subsystem->GetInstanceName()));
+
+	FGuid OwnerGuid;
+	FPlatformMisc::CreateGuid(OwnerGuid);
+	SessionId = FUniqueNetIdEOSSession::Create(OwnerGuid.ToString());
+}
 
 typedef TEOSGlobalCallback<EOS_Sessions_OnSessionInviteReceivedCallback, EOS_Sessions_SessionInviteReceivedCallbackInfo, FEOSWrapperSessionManager> FSessionInviteReceivedCallback;
 typedef TEOSGlobalCallback<EOS_Sessions_OnSessionInviteAcceptedCallback, EOS_Sessions_SessionInviteAcceptedCallbackInfo, FEOSWrapperSessionManager> FSessionInviteAcceptedCallback;
@@ -500,6 +573,10 @@ bool FEOSWrapperSessionManager::CreateSession(int32 HostingPlayerNum, FName Sess
 				Session->HostingPlayerNum = HostingPlayerNum;
 				// Unique identifier of this build for compatibility
 				Session->SessionSettings.BuildUniqueId = GetBuildUniqueId();
+				if (QosResponder.IsValid())
+				{
+					Session->SessionSettings.Set(SETTING_EOSWRAPPER_QOSPORT, QosResponder->GetPort(), EOnlineDataAdvertisementType::ViaOnlineService);
+				}
 
 				// Create Internet or LAN match
 				if (!NewSessionSettings.bIsLANMatch)
@@ -515,7 +592,7 @@ bool FEOSWrapperSessionManager::CreateSession(int32 HostingPlayerNum, FName Sess
 				}
 				else
 				{
-					// Result = CreateLANSession(HostingPlayerNum, Session);
+					Result = CreateLANSession(HostingPlayerNum, Session);
 				}
 			}
 			else
@@ -585,11 +662,7 @@ bool FEOSWrapperSessionManager::StartSession(FName SessionName)
 			}
 			else
 			{
-				// If this lan match has join in progress disabled, shut down the beacon
-				if (!Session->SessionSettings.bAllowJoinInProgress)
-				{
-					// LANSession->StopLANSession();
-				}
+				// The beacon stops advertising sessions that can't be joined in progress on its own
 				Result = ONLINE_SUCCESS;
 				Session->SessionState = EOnlineSessionState::InProgress;
 			}
@@ -624,14 +697,9 @@ bool FEOSWrapperSessionManager::UpdateSession(FName SessionName, FOnlineSessionS
 
 		if (!Session->SessionSettings.bIsLANMatch)
 		{
-			if (Session->SessionSettings.bUseLobbiesIfAvailable)
-			{
-				Result = UpdateLobbySession(Session);
-			}
-			else
-			{
-				Result = UpdateEOSSession(Session);
-			}
+			// Completed once the merged update for this session has been acknowledged
+			QueueSessionUpdate(SessionName);
+			Result = ONLINE_IO_PENDING;
 		}
 		else
 		{
@@ -675,19 +743,8 @@ bool FEOSWrapperSessionManager::EndSession(FName SessionName)
 			}
 			else
 			{
-				// If the session should be advertised and the lan beacon was destroyed, recreate
-				// if (Session->SessionSettings.bShouldAdvertise &&
-				// 	!LANSession.IsValid() &&
-				// 	LANSession->LanBeacon == nullptr &&
-				// 	EOSSubsystem->IsServer())
-				// {
-				// 	// Recreate the beacon
-				// 	Result = CreateLANSession(Session->HostingPlayerNum, Session);
-				// }
-				// else
-				// {
-				// 	Result = ONLINE_SUCCESS;
-				// }
+				// Ended sessions are advertised again, the beacon may have been closed while the match ran without join in progress
+				Result = !Session->SessionSettings.bShouldAdvertise || !Session->bHosting || StartLanBeacon() ? ONLINE_SUCCESS : ONLINE_FAIL;
 			}
 		}
 		else
@@ -702,7 +759,9 @@ bool FEOSWrapperSessionManager::EndSession(FName SessionName)
 
 	if (Result != ONLINE_IO_PENDING)
 	{
-		EOSSubsystem->ExecuteNextTick([this, Session, SessionName, Result]() {
+		// Sessions may be added or removed before the next tick and move in LobbySessions, so the session is looked up again by name
+		EOSSubsystem->ExecuteNextTick([this, SessionName, Result, bHadSession = Session != nullptr]() {
+			FNamedOnlineSession* Session = bHadSession ? GetNamedSession(SessionName) : nullptr;
 			if (Session)
 			{
 				Session->SessionState = EOnlineSessionState::Ended;
@@ -750,13 +809,7 @@ bool FEOSWrapperSessionManager::DestroySession(FName SessionName, const FOnDestr
 			}
 			else
 			{
-				// if (LANSession.IsValid())
-				// {
-				// 	// Tear down the LAN beacon
-				// 	LANSession->StopLANSession();
-				// 	LANSession = nullptr;
-				// }
-
+				// The beacon closes itself once nothing is advertised anymore
 				Result = ONLINE_SUCCESS;
 			}
 
@@ -793,35 +846,187 @@ bool FEOSWrapperSessionManager::IsPlayerInSession(FName SessionName, const FUniq
 	return IsPlayerInSessionImpl(this, SessionName, UniqueId);
 }
 
+/** Matchmaking backend over the EOS lobby interface, joins and creates go through the regular session flow */
+class FEOSMatchmakingLobbyBackend : public IEOSMatchmakingBackend
+{
+public:
+	FEOSMatchmakingLobbyBackend(const FEOSWrapperSessionManagerWeakPtr& InSessionManager) : SessionManager(InSessionManager) {}
+
+	virtual void SearchLobbies(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& Search, const FOnBackendOperationComplete& Callback) override
+	{
+		FEOSWrapperSessionManagerPtr Manager = SessionManager.Pin();
+		if (!Manager.IsValid())
+		{
+			Callback(false);
+			return;
+		}
+
+		const uint32 Result = Manager->StartLobbySessionSearch(SearchingPlayerNum, Search,
+			FOnSingleSessionResultCompleteDelegate::CreateLambda(
+				[Callback](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) { Callback(bWasSuccessful); }));
+		if (Result != ONLINE_IO_PENDING)
+		{
+			Callback(false);
+		}
+	}
+
+	virtual void JoinLobby(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& SearchResult, const FOnBackendOperationComplete& Callback) override
+	{
+		FEOSWrapperSessionManagerPtr Manager = SessionManager.Pin();
+		if (!Manager.IsValid())
+		{
+			Callback(false);
+			return;
+		}
+
+		TSharedRef<FDelegateHandle> DelegateHandle = MakeShared<FDelegateHandle>();
+		*DelegateHandle = Manager->AddOnJoinSessionCompleteDelegate_Handle(FOnJoinSessionCompleteDelegate::CreateLambda(
+			[WeakManager = SessionManager, SessionName, DelegateHandle, Callback](FName CompletedSessionName, EOnJoinSessionCompleteResult::Type JoinResult) {
+				if (CompletedSessionName == SessionName)
+				{
+					if (FEOSWrapperSessionManagerPtr StrongManager = WeakManager.Pin())
+					{
+						StrongManager->ClearOnJoinSessionCompleteDelegate_Handle(*DelegateHandle);
+					}
+					Callback(JoinResult == EOnJoinSessionCompleteResult::Success);
+				}
+			}));
+		Manager->JoinSession(PlayerNum, SessionName, SearchResult);
+	}
+
+	virtual void CreateLobby(int32 HostingPlayerNum, FName SessionName, const FOnlineSessionSettings& SessionSettings, const FOnBackendOperationComplete& Callback) override
+	{
+		FEOSWrapperSessionManagerPtr Manager = SessionManager.Pin();
+		if (!Manager.IsValid())
+		{
+			Callback(false);
+			return;
+		}
+
+		TSharedRef<FDelegateHandle> DelegateHandle = MakeShared<FDelegateHandle>();
+		*DelegateHandle = Manager->AddOnCreateSessionCompleteDelegate_Handle(
+			FOnCreateSessionCompleteDelegate::CreateLambda([WeakManager = SessionManager, SessionName, DelegateHandle, Callback](FName CompletedSessionName, bool bWasSuccessful) {
+				if (CompletedSessionName == SessionName)
+				{
+					if (FEOSWrapperSessionManagerPtr StrongManager = WeakManager.Pin())
+					{
+						StrongManager->ClearOnCreateSessionCompleteDelegate_Handle(*DelegateHandle);
+					}
+					Callback(bWasSuccessful);
+				}
+			}));
+		Manager->CreateSession(HostingPlayerNum, SessionName, SessionSettings);
+	}
+
+private:
+	FEOSWrapperSessionManagerWeakPtr SessionManager;
+};
+
+void FEOSWrapperSessionManager::SetMatchmakingBackend(const TSharedRef<IEOSMatchmakingBackend>& Backend)
+{
+	Matchmaker = MakeShared<FEOSMatchmaker>(Backend, MatchmakingSettings, [this](FName SessionName, bool bWasSuccessful) { TriggerOnMatchmakingCompleteDelegates(SessionName, bWasSuccessful); });
+}
+
 bool FEOSWrapperSessionManager::StartMatchmaking(
 	const TArray<FUniqueNetIdRef>& LocalPlayers, FName SessionName, const FOnlineSessionSettings& NewSessionSettings, TSharedRef<FOnlineSessionSearch>& SearchSettings)
 {
-	EOSSubsystem->ExecuteNextTick([this, SessionName]() {
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("StartMatchmaking is not supported on this platform. Use FindSessions or FindSessionById."));
-		TriggerOnMatchmakingCompleteDelegates(SessionName, false);
-	});
+	bool bWasSuccessful = false;
+	if (GetNamedSession(SessionName) != nullptr)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("Can't start matchmaking for session (%s) that already exists"), *SessionName.ToString());
+	}
+	else if (SearchSettings->bIsLanQuery || NewSessionSettings.bIsLANMatch)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("StartMatchmaking is not supported for LAN sessions. Use FindSessions instead."));
+	}
+	else
+	{
+		const int32 SearchingPlayerNum =
+			LocalPlayers.Num() > 0 ? EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(*LocalPlayers[0]) : EOSSubsystem->UserManager->GetDefaultLocalUser();
+		bWasSuccessful = Matchmaker->StartTicket(SearchingPlayerNum, SessionName, NewSessionSettings, SearchSettings);
+	}
 
-	return true;
+	if (!bWasSuccessful)
+	{
+		EOSSubsystem->ExecuteNextTick([this, SessionName]() { TriggerOnMatchmakingCompleteDelegates(SessionName, false); });
+	}
+
+	return bWasSuccessful;
 }
 
 bool FEOSWrapperSessionManager::CancelMatchmaking(int32 SearchingPlayerNum, FName SessionName)
 {
-	EOSSubsystem->ExecuteNextTick([this, SessionName]() {
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("CancelMatchmaking is not supported on this platform. Use CancelFindSessions."));
-		TriggerOnCancelMatchmakingCompleteDelegates(SessionName, false);
-	});
+	const bool bWasSuccessful = Matchmaker->CancelTicket(SessionName);
+	if (!bWasSuccessful)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("No matchmaking that can be cancelled for session (%s)"), *SessionName.ToString());
+	}
 
-	return true;
+	EOSSubsystem->ExecuteNextTick([this, SessionName, bWasSuccessful]() { TriggerOnCancelMatchmakingCompleteDelegates(SessionName, bWasSuccessful); });
+
+	return bWasSuccessful;
 }
 
 bool FEOSWrapperSessionManager::CancelMatchmaking(const FUniqueNetId& SearchingPlayerId, FName SessionName)
 {
-	EOSSubsystem->ExecuteNextTick([this, SessionName]() {
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("CancelMatchmaking is not supported on this platform. Use CancelFindSessions."));
-		TriggerOnCancelMatchmakingCompleteDelegates(SessionName, false);
-	});
+	return CancelMatchmaking(EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(SearchingPlayerId), SessionName);
+}
 
-	return true;
+/** Search parameters the client evaluates itself, never sent to EOS as filters */
+static bool IsClientSideSearchParam(const FName& Key)
+{
+	return FEOSSessionSearchRanker::IsRankingSearchParam(Key) || Key == SEARCH_EOSWRAPPER_PARTITION_KEY || Key == SEARCH_EOSWRAPPER_PARTITION_VALUES;
+}
+
+/** Upper bound on the queries a single partitioned search sends */
+static constexpr int32 MaxSearchPartitions = 256;
+
+/** Reads SEARCH_EOSWRAPPER_PARTITION_KEY/VALUES, values are a comma separated list where "First..Last" expands to every integer in between */
+static bool ParseSearchPartitions(const FOnlineSessionSearch& SearchSettings, FName& OutKey, TArray<FVariantData>& OutValues)
+{
+	FString KeyString;
+	FString ValuesString;
+	if (!SearchSettings.QuerySettings.Get(SEARCH_EOSWRAPPER_PARTITION_KEY, KeyString) || KeyString.IsEmpty() ||
+		!SearchSettings.QuerySettings.Get(SEARCH_EOSWRAPPER_PARTITION_VALUES, ValuesString))
+	{
+		return false;
+	}
+
+	// Integers are compared as int64, which is what EOS turns every integer attribute into
+	TArray<FString> Values;
+	ValuesString.ParseIntoArray(Values, TEXT(","));
+	for (FString& Value : Values)
+	{
+		Value.TrimStartAndEndInline();
+
+		FString First;
+		FString Last;
+		if (Value.Split(TEXT(".."), &First, &Last) && First.IsNumeric() && Last.IsNumeric())
+		{
+			const int64 LastValue = FCString::Atoi64(*Last);
+			for (int64 RangeValue = FCString::Atoi64(*First); RangeValue <= LastValue && OutValues.Num() < MaxSearchPartitions; RangeValue++)
+			{
+				OutValues.Emplace(RangeValue);
+			}
+		}
+		else if (Value.IsNumeric())
+		{
+			OutValues.Emplace(FCString::Atoi64(*Value));
+		}
+		else if (!Value.IsEmpty())
+		{
+			OutValues.Emplace(Value);
+		}
+	}
+
+	if (OutValues.Num() > MaxSearchPartitions)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::FindSessions] Only the first %d of %d search partitions are searched"), MaxSearchPartitions, OutValues.Num());
+		OutValues.SetNum(MaxSearchPartitions);
+	}
+
+	OutKey = FName(*KeyString);
+	return OutValues.Num() > 0;
 }
 
 bool FEOSWrapperSessionManager::FindSessions(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
@@ -843,7 +1048,16 @@ bool FEOSWrapperSessionManager::FindSessions(int32 SearchingPlayerNum, const TSh
 		if (!SearchSettings->bIsLanQuery)
 		{
 			bool bUssLobbiesIfAvailable = false;
-			if (SearchSettings->QuerySettings.Get(SEARCH_LOBBIES, bUssLobbiesIfAvailable) && bUssLobbiesIfAvailable)
+			SearchSettings->QuerySettings.Get(SEARCH_LOBBIES, bUssLobbiesIfAvailable);
+
+			TSharedRef<FPartitionedSearch> PartitionedSearch = MakeShared<FPartitionedSearch>(SearchSettings);
+			if (SearchSettings->MaxSearchResults > EOS_SESSIONS_MAX_SEARCH_RESULTS && ParseSearchPartitions(*SearchSettings, PartitionedSearch->PartitionKey, PartitionedSearch->PartitionValues))
+			{
+				PartitionedSearch->SearchingPlayerNum = SearchingPlayerNum;
+				PartitionedSearch->bLobbies = bUssLobbiesIfAvailable;
+				Return = StartPartitionedSearch(PartitionedSearch);
+			}
+			else if (bUssLobbiesIfAvailable)
 			{
 				Return = FindLobbySession(SearchingPlayerNum, SearchSettings);
 			}
@@ -854,7 +1068,7 @@ bool FEOSWrapperSessionManager::FindSessions(int32 SearchingPlayerNum, const TSh
 		}
 		else
 		{
-			//	Return = FindLANSession();
+			Return = FindLANSession();
 		}
 
 		if (Return == ONLINE_IO_PENDING)
@@ -902,6 +1116,7 @@ bool FEOSWrapperSessionManager::FindSessionById(
 		// Then perform the search
 		CurrentSessionSearch = MakeShareable(new FOnlineSessionSearch());
 		CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::InProgress;
+		LobbySearchResultsCache.Reset();
 
 		StartLobbySearch(EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(SearchingUserId), LobbySearchHandle, CurrentSessionSearch.ToSharedRef(),
 			FOnSingleSessionResultCompleteDelegate::CreateLambda(
@@ -935,9 +1150,9 @@ bool FEOSWrapperSessionManager::CancelFindSessions()
 		// Make sure it's the right type
 		if (CurrentSessionSearch->bIsLanQuery)
 		{
-			// check(LANSession);
-			// Return = ONLINE_SUCCESS;
-			// LANSession->StopLANSession();
+			// Responses still on their way are dropped because the search nonce no longer matches
+			Return = ONLINE_SUCCESS;
+			LanSearchNonce = 0;
 			CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
 			CurrentSessionSearch = nullptr;
 		}
@@ -964,7 +1179,55 @@ bool FEOSWrapperSessionManager::CancelFindSessions()
 
 bool FEOSWrapperSessionManager::PingSearchResults(const FOnlineSessionSearchResult& SearchResult)
 {
-	return false;
+	// All results of the current search are pinged together, they share the socket and the timeout so this costs no more than pinging one
+	if (!CurrentSessionSearch.IsValid() || CurrentSessionSearch->SearchResults.Num() == 0)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::PingSearchResults] No search results to ping"));
+		return false;
+	}
+
+	if (QosProber->IsRunning())
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::PingSearchResults] Ping already in progress"));
+		return false;
+	}
+
+	TArray<TSharedPtr<FInternetAddr>> Targets;
+	TArray<FString> SessionIds;
+	Targets.Reserve(CurrentSessionSearch->SearchResults.Num());
+	SessionIds.Reserve(CurrentSessionSearch->SearchResults.Num());
+	for (const FOnlineSessionSearchResult& Result : CurrentSessionSearch->SearchResults)
+	{
+		Targets.Add(GetQosAddressFromSearchResult(Result));
+		SessionIds.Add(Result.GetSessionIdStr());
+	}
+
+	// Results are matched back by session id, a new search may have replaced or reordered them by the time the probe finished
+	TWeakPtr<FOnlineSessionSearch> PingedSearch = CurrentSessionSearch;
+	const bool bStarted = QosProber->Start(Targets, [this, PingedSearch, SessionIds = MoveTemp(SessionIds)](const TArray<int32>& PingsInMs) {
+		TSharedPtr<FOnlineSessionSearch> Search = PingedSearch.Pin();
+		if (Search.IsValid())
+		{
+			for (FOnlineSessionSearchResult& Result : Search->SearchResults)
+			{
+				const int32 Index = SessionIds.IndexOfByKey(Result.GetSessionIdStr());
+				if (Index != INDEX_NONE)
+				{
+					Result.PingInMs = PingsInMs[Index];
+				}
+			}
+
+			// The search was ranked without pings and kept whole, rank it again now that they are known and apply the top K
+			FEOSSessionSearchRanker::RankSearchResults(SearchRankingSettings, *Search);
+		}
+		TriggerOnPingSearchResultsCompleteDelegates(Search.IsValid());
+	});
+
+	if (!bStarted)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::PingSearchResults] Unable to start QoS probe"));
+	}
+	return bStarted;
 }
 
 bool FEOSWrapperSessionManager::JoinSession(int32 PlayerNum, FName SessionName, const FOnlineSessionSearchResult& DesiredSession)
@@ -1004,10 +1267,7 @@ bool FEOSWrapperSessionManager::JoinSession(int32 PlayerNum, FName SessionName,
 		}
 		else
 		{
-			// FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS();
-			// Session->SessionInfo = MakeShareable(NewSessionInfo);
-			//
-			// Return = JoinLANSession(PlayerNum, Session, &DesiredSession.Session);
+			Return = JoinLANSession(PlayerNum, Session, &DesiredSession.Session);
 		}
 
 		if (Return != ONLINE_IO_PENDING)
@@ -1044,49 +1304,113 @@ bool FEOSWrapperSessionManager::JoinSession(const FUniqueNetId& PlayerId, FName
 	return JoinSession(EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(PlayerId), SessionName, DesiredSession);
 }
 
-bool FEOSWrapperSessionManager::FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend)
+FString FEOSWrapperSessionManager::GetFriendJoinInfo(int32 LocalUserNum, const FUniqueNetId& Friend) const
 {
-	bool bResult = false;
+	// Presence enabled lobbies are published as the join info of their members' presence
+	EOS_Presence_GetJoinInfoOptions Options = {};
+	Options.ApiVersion = EOS_PRESENCE_GETJOININFO_API_LATEST;
+	Options.LocalUserId = EOSSubsystem->UserManager->GetLocalEpicAccountId(LocalUserNum);
+	Options.TargetUserId = FUniqueNetIdEOS::Cast(Friend).GetEpicAccountId();
+	if (Options.LocalUserId == nullptr || Options.TargetUserId == nullptr)
+	{
+		return FString();
+	}
+
+	char JoinInfo[EOS_PRESENCEMODIFICATION_JOININFO_MAX_LENGTH + 1];
+	int32_t JoinInfoLength = UE_ARRAY_COUNT(JoinInfo);
+	const EOS_EResult Result = EOS_Presence_GetJoinInfo(EOSSubsystem->GetPresenceHandle(), &Options, JoinInfo, &JoinInfoLength);
+	if (Result != EOS_EResult::EOS_Success)
+	{
+		// NotFound is the common case, the friend isn't in a presence enabled lobby
+		UE_LOG_ONLINE_SESSION(VeryVerbose, TEXT("[FOnlineSessionEOS::GetFriendJoinInfo] No join info for (%s). Finished with EOS_EResult %s"), *Friend.ToString(),
+			ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+		return FString();
+	}
+
+	return UTF8_TO_TCHAR(JoinInfo);
+}
+
+EOS_HLobbySearch FEOSWrapperSessionManager::CreateLobbySearchById(const FString& LobbyId)
+{
+	EOS_HLobbySearch LobbySearchHandle = nullptr;
+	EOS_Lobby_CreateLobbySearchOptions CreateLobbySearchOptions = {0};
+	CreateLobbySearchOptions.ApiVersion = EOS_LOBBY_CREATELOBBYSEARCH_API_LATEST;
+	CreateLobbySearchOptions.MaxResults = 1;
+
+	EOS_EResult CreateLobbySearchResult = EOS_Lobby_CreateLobbySearch(LobbyHandle, &CreateLobbySearchOptions, &LobbySearchHandle);
+	if (CreateLobbySearchResult != EOS_EResult::EOS_Success)
+	{
+		UE_LOG_ONLINE_SESSION(
+			Warning, TEXT("[FOnlineSessionEOS::FindFriendSession] CreateLobbySearch not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(CreateLobbySearchResult)));
+		return nullptr;
+	}
 
+	const FTCHARToUTF8 Utf8LobbyId(*LobbyId);
+	EOS_LobbySearch_SetLobbyIdOptions SetLobbyIdOptions = {0};
+	SetLobbyIdOptions.ApiVersion = EOS_LOBBYSEARCH_SETLOBBYID_API_LATEST;
+	SetLobbyIdOptions.LobbyId = (EOS_LobbyId)Utf8LobbyId.Get();
+	EOS_LobbySearch_SetLobbyId(LobbySearchHandle, &SetLobbyIdOptions);
+
+	return LobbySearchHandle;
+}
+
+EOS_HLobbySearch FEOSWrapperSessionManager::CreateFriendLobbySearch(int32 LocalUserNum, const FUniqueNetId& Friend)
+{
 	// So far there is only a lobby implementation for this
 
+	const FString JoinInfo = GetFriendJoinInfo(LocalUserNum, Friend);
+	if (!JoinInfo.IsEmpty())
+	{
+		return CreateLobbySearchById(JoinInfo);
+	}
+
 	// We create the search handle
-	EOS_HLobbySearch LobbySearchHandle;
+	EOS_HLobbySearch LobbySearchHandle = nullptr;
 	EOS_Lobby_CreateLobbySearchOptions CreateLobbySearchOptions = {0};
 	CreateLobbySearchOptions.ApiVersion = EOS_LOBBY_CREATELOBBYSEARCH_API_LATEST;
 	CreateLobbySearchOptions.MaxResults = EOS_SESSIONS_MAX_SEARCH_RESULTS;
 
 	EOS_EResult CreateLobbySearchResult = EOS_Lobby_CreateLobbySearch(LobbyHandle, &CreateLobbySearchOptions, &LobbySearchHandle);
-	if (CreateLobbySearchResult == EOS_EResult::EOS_Success)
+	if (CreateLobbySearchResult != EOS_EResult::EOS_Success)
 	{
-		const FUniqueNetIdEOS& FriendEOSId = FUniqueNetIdEOS::Cast(Friend);
+		UE_LOG_ONLINE_SESSION(
+			Warning, TEXT("[FOnlineSessionEOS::FindFriendSession] CreateLobbySearch not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(CreateLobbySearchResult)));
+		return nullptr;
+	}
 
-		// Set the user we wan to use to find lobbies
-		EOS_LobbySearch_SetTargetUserIdOptions SetTargetUserIdOptions = {0};
-		SetTargetUserIdOptions.ApiVersion = EOS_LOBBYSEARCH_SETTARGETUSERID_API_LATEST;
-		SetTargetUserIdOptions.TargetUserId = FriendEOSId.GetProductUserId();
+	const FUniqueNetIdEOS& FriendEOSId = FUniqueNetIdEOS::Cast(Friend);
 
-		// TODO: Using this as a search parameter only works if we use the owner's id (search for lobbies we're already in). Pending API fix so it works with other users too.
-		EOS_LobbySearch_SetTargetUserId(LobbySearchHandle, &SetTargetUserIdOptions);
+	// Set the user we wan to use to find lobbies
+	EOS_LobbySearch_SetTargetUserIdOptions SetTargetUserIdOptions = {0};
+	SetTargetUserIdOptions.ApiVersion = EOS_LOBBYSEARCH_SETTARGETUSERID_API_LATEST;
+	SetTargetUserIdOptions.TargetUserId = FriendEOSId.GetProductUserId();
 
-		// Then perform the search
-		CurrentSessionSearch = MakeShareable(new FOnlineSessionSearch());
-		CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::InProgress;
+	// TODO: Using this as a search parameter only works if we use the owner's id (search for lobbies we're already in). Pending API fix so it works with other users too.
+	// Friends without join info only get this, it still finds a lobby we share with them
+	EOS_LobbySearch_SetTargetUserId(LobbySearchHandle, &SetTargetUserIdOptions);
 
-		StartLobbySearch(LocalUserNum, LobbySearchHandle, CurrentSessionSearch.ToSharedRef(),
-			FOnSingleSessionResultCompleteDelegate::CreateLambda(
-				[this](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) { TriggerOnFindSessionsCompleteDelegates(bWasSuccessful); }));
+	return LobbySearchHandle;
+}
 
-		bResult = true;
-	}
-	else
+bool FEOSWrapperSessionManager::FindFriendSession(int32 LocalUserNum, const FUniqueNetId& Friend)
+{
+	EOS_HLobbySearch LobbySearchHandle = CreateFriendLobbySearch(LocalUserNum, Friend);
+	if (LobbySearchHandle == nullptr)
 	{
-		UE_LOG_ONLINE_SESSION(
-			Warning, TEXT("[FOnlineSessionEOS::FindFriendSession] CreateLobbySearch not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(CreateLobbySearchResult)));
 		EOSSubsystem->ExecuteNextTick([this]() { TriggerOnFindSessionsCompleteDelegates(false); });
+		return false;
 	}
 
-	return bResult;
+	// Then perform the search
+	CurrentSessionSearch = MakeShareable(new FOnlineSessionSearch());
+	CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::InProgress;
+	LobbySearchResultsCache.Reset();
+
+	StartLobbySearch(LocalUserNum, LobbySearchHandle, CurrentSessionSearch.ToSharedRef(),
+		FOnSingleSessionResultCompleteDelegate::CreateLambda(
+			[this](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) { TriggerOnFindSessionsCompleteDelegates(bWasSuccessful); }));
+
+	return true;
 }
 
 bool FEOSWrapperSessionManager::FindFriendSession(const FUniqueNetId& LocalUserId, const FUniqueNetId& Friend)
@@ -1096,15 +1420,78 @@ bool FEOSWrapperSessionManager::FindFriendSession(const FUniqueNetId& LocalUserI
 
 bool FEOSWrapperSessionManager::FindFriendSession(const FUniqueNetId& LocalUserId, const TArray<FUniqueNetIdRef>& FriendList)
 {
-	EOSSubsystem->ExecuteNextTick([this, LocalUserIdRef = LocalUserId.AsShared()]() {
-		// this function has to exist due to interface definition, but it does not have a meaningful implementation in EOS subsystem yet
-		TArray<FOnlineSessionSearchResult> EmptySearchResult;
-		TriggerOnFindFriendSessionCompleteDelegates(EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(*LocalUserIdRef), false, EmptySearchResult);
-	});
+	TSharedRef<FFriendSessionSearch> FriendSearch = MakeShared<FFriendSessionSearch>();
+	FriendSearch->LocalUserNum = EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(LocalUserId);
+	FriendSearch->LobbyIds.Reserve(FriendList.Num());
+
+	TSet<FString> QueuedLobbyIds;
+	for (const FUniqueNetIdRef& Friend : FriendList)
+	{
+		// Friends without join info are in no lobby we could find, friends in the same lobby share one search
+		const FString LobbyId = GetFriendJoinInfo(FriendSearch->LocalUserNum, *Friend);
+		bool bAlreadyQueued = false;
+		if (!LobbyId.IsEmpty())
+		{
+			QueuedLobbyIds.Add(LobbyId, &bAlreadyQueued);
+		}
+		if (LobbyId.IsEmpty() || bAlreadyQueued)
+		{
+			INC_DWORD_STAT(STAT_EOSWrapper_FriendSessionSearchesSkipped);
+			continue;
+		}
+		FriendSearch->LobbyIds.Add(LobbyId);
+	}
+
+	if (FriendSearch->LobbyIds.Num() == 0)
+	{
+		EOSSubsystem->ExecuteNextTick([this, LocalUserNum = FriendSearch->LocalUserNum]() { TriggerOnFindFriendSessionCompleteDelegates(LocalUserNum, true, TArray<FOnlineSessionSearchResult>()); });
+		return true;
+	}
 
+	StartFriendSessionSearches(FriendSearch);
 	return true;
 }
 
+void FEOSWrapperSessionManager::StartFriendSessionSearches(const TSharedRef<FFriendSessionSearch>& FriendSearch)
+{
+	while (FriendSearch->NumInFlight < FriendSessionSearchMaxParallelSearches && FriendSearch->NextLobbyIndex < FriendSearch->LobbyIds.Num())
+	{
+		EOS_HLobbySearch LobbySearchHandle = CreateLobbySearchById(FriendSearch->LobbyIds[FriendSearch->NextLobbyIndex++]);
+		if (LobbySearchHandle == nullptr)
+		{
+			continue;
+		}
+
+		// Every lobby gets its own search object, results are merged as the searches complete
+		TSharedRef<FOnlineSessionSearch> SearchSettings = MakeShared<FOnlineSessionSearch>();
+		SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+		FriendSearch->NumInFlight++;
+
+		StartLobbySearch(FriendSearch->LocalUserNum, LobbySearchHandle, SearchSettings,
+			FOnSingleSessionResultCompleteDelegate::CreateLambda([this, FriendSearch, SearchSettings](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) {
+				FriendSearch->NumInFlight--;
+				FriendSearch->bAnySucceeded |= bWasSuccessful;
+
+				// Lobby ids were deduplicated before searching, so every lobby comes back at most once
+				for (FOnlineSessionSearchResult& SearchResult : SearchSettings->SearchResults)
+				{
+					if (SearchResult.Session.SessionInfo.IsValid())
+					{
+						FriendSearch->Results.Add(MoveTemp(SearchResult));
+					}
+				}
+
+				StartFriendSessionSearches(FriendSearch);
+			}));
+	}
+
+	if (!FriendSearch->bCompleted && FriendSearch->NumInFlight == 0 && FriendSearch->NextLobbyIndex >= FriendSearch->LobbyIds.Num())
+	{
+		FriendSearch->bCompleted = true;
+		EOSSubsystem->ExecuteNextTick([this, FriendSearch]() { TriggerOnFindFriendSessionCompleteDelegates(FriendSearch->LocalUserNum, FriendSearch->bAnySucceeded, FriendSearch->Results); });
+	}
+}
+
 bool FEOSWrapperSessionManager::SendSessionInviteToFriend(int32 LocalUserNum, FName SessionName, const FUniqueNetId& Friend)
 {
 	EOS_ProductUserId LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(LocalUserNum);
@@ -1250,22 +1637,24 @@ bool FEOSWrapperSessionManager::RegisterPlayers(FName SessionName, const TArray<
 	FNamedOnlineSession* Session = GetNamedSession(SessionName);
 	if (Session)
 	{
-		TArray<EOS_ProductUserId> EOSIds;
 		bSuccess = true;
 		bool bRegisterEOS = !Session->SessionSettings.bUseLobbiesIfAvailable;
+		FUniqueNetIdRefIndexMap& RegisteredPlayerIndices = GetRegisteredPlayerIndices(*Session);
+		FPendingPlayerRegistrations* PendingRegistrations = bRegisterEOS ? &PendingPlayerRegistrations.FindOrAdd(SessionName) : nullptr;
 
 		for (int32 PlayerIdx = 0; PlayerIdx < Players.Num(); PlayerIdx++)
 		{
 			const FUniqueNetIdRef& PlayerId = Players[PlayerIdx];
-			const FUniqueNetIdEOS& PlayerEOSId = FUniqueNetIdEOS::Cast(*PlayerId);
-
-			FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-			if (Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch) == INDEX_NONE)
+			if (!RegisteredPlayerIndices.Contains(PlayerId))
 			{
-				Session->RegisteredPlayers.Add(PlayerId);
-				if (bRegisterEOS)
+				RegisteredPlayerIndices.Add(PlayerId, Session->RegisteredPlayers.Add(PlayerId));
+				if (PendingRegistrations)
 				{
-					EOSIds.Add(PlayerEOSId.GetProductUserId());
+					// Leaving and coming back before the flush cancels out, the backend never saw the player go
+					if (PendingRegistrations->PlayersToUnregister.Remove(PlayerId) == 0)
+					{
+						PendingRegistrations->PlayersToRegister.Add(PlayerId);
+					}
 				}
 
 				AddOnlineSessionMember(SessionName, PlayerId);
@@ -1276,21 +1665,10 @@ bool FEOSWrapperSessionManager::RegisterPlayers(FName SessionName, const TArray<
 			}
 		}
 
-		if (bRegisterEOS && EOSIds.Num() > 0)
+		if (PendingRegistrations)
 		{
-			EOS_Sessions_RegisterPlayersOptions Options = {};
-			Options.ApiVersion = EOS_SESSIONS_REGISTERPLAYERS_API_LATEST;
-			Options.PlayersToRegister = EOSIds.GetData();
-			Options.PlayersToRegisterCount = EOSIds.Num();
-			const FTCHARToUTF8 Utf8SessionName(*SessionName.ToString());
-			Options.SessionName = Utf8SessionName.Get();
-
-			FRegisterPlayersCallback* CallbackObj = new FRegisterPlayersCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-			CallbackObj->CallbackLambda = [this, SessionName, RegisteredPlayers = TArray<FUniqueNetIdRef>(Players)](const EOS_Sessions_RegisterPlayersCallbackInfo* Data) {
-				bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_NoChange;
-				TriggerOnRegisterPlayersCompleteDelegates(SessionName, RegisteredPlayers, bWasSuccessful);
-			};
-			EOS_Sessions_RegisterPlayers(EOSSubsystem->GetSessionsHandle(), &Options, CallbackObj, CallbackObj->GetCallbackPtr());
+			// Completed by TickPlayerRegistrations together with every other call for this session in the same frame
+			PendingRegistrations->RegisterCallers.Add(Players);
 			return true;
 		}
 	}
@@ -1321,21 +1699,28 @@ bool FEOSWrapperSessionManager::UnregisterPlayers(FName SessionName, const TArra
 	FNamedOnlineSession* Session = GetNamedSession(SessionName);
 	if (Session)
 	{
-		TArray<EOS_ProductUserId> EOSIds;
 		bool bUnregisterEOS = !Session->SessionSettings.bUseLobbiesIfAvailable;
+		FUniqueNetIdRefIndexMap& RegisteredPlayerIndices = GetRegisteredPlayerIndices(*Session);
+		FPendingPlayerRegistrations* PendingRegistrations = bUnregisterEOS ? &PendingPlayerRegistrations.FindOrAdd(SessionName) : nullptr;
+
 		for (int32 PlayerIdx = 0; PlayerIdx < Players.Num(); PlayerIdx++)
 		{
 			const FUniqueNetIdRef& PlayerId = Players[PlayerIdx];
-			const FUniqueNetIdEOS& PlayerEOSId = FUniqueNetIdEOS::Cast(*PlayerId);
-
-			FUniqueNetIdMatcher PlayerMatch(*PlayerId);
-			int32 RegistrantIndex = Session->RegisteredPlayers.IndexOfByPredicate(PlayerMatch);
-			if (RegistrantIndex != INDEX_NONE)
+			int32 RegistrantIndex = INDEX_NONE;
+			if (RegisteredPlayerIndices.RemoveAndCopyValue(PlayerId, RegistrantIndex))
 			{
-				Session->RegisteredPlayers.RemoveAtSwap(RegistrantIndex);
-				if (bUnregisterEOS)
+				// The last player is swapped into the freed slot, so only its index changes
+				Session->RegisteredPlayers.RemoveAtSwap(RegistrantIndex, 1, false);
+				if (RegistrantIndex < Session->RegisteredPlayers.Num())
 				{
-					EOSIds.Add(PlayerEOSId.GetProductUserId());
+					RegisteredPlayerIndices[Session->RegisteredPlayers[RegistrantIndex]] = RegistrantIndex;
+				}
+				if (PendingRegistrations)
+				{
+					if (PendingRegistrations->PlayersToRegister.Remove(PlayerId) == 0)
+					{
+						PendingRegistrations->PlayersToUnregister.Add(PlayerId);
+					}
 				}
 
 				RemoveOnlineSessionMember(SessionName, PlayerId);
@@ -1345,33 +1730,125 @@ bool FEOSWrapperSessionManager::UnregisterPlayers(FName SessionName, const TArra
 				UE_LOG_ONLINE_SESSION(Warning, TEXT("Player %s is not part of session (%s)"), *PlayerId->ToDebugString(), *SessionName.ToString());
 			}
 		}
-		if (bUnregisterEOS && EOSIds.Num() > 0)
+
+		if (PendingRegistrations)
 		{
+			PendingRegistrations->UnregisterCallers.Add(Players);
+			return true;
+		}
+	}
+	else
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("No game present to leave for session (%s)"), *SessionName.ToString());
+		bSuccess = false;
+	}
+
+	EOSSubsystem->ExecuteNextTick([this, SessionName, Players, bSuccess]() { TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, bSuccess); });
+
+	return true;
+}
+
+FUniqueNetIdRefIndexMap& FEOSWrapperSessionManager::GetRegisteredPlayerIndices(const FNamedOnlineSession& Session)
+{
+	FSessionState& State = SessionStates.FindOrAdd(Session.SessionName);
+	if (!State.RegisteredPlayerIndices.IsSet())
+	{
+		FUniqueNetIdRefIndexMap& Indices = State.RegisteredPlayerIndices.Emplace();
+		Indices.Reserve(Session.RegisteredPlayers.Num());
+		for (int32 PlayerIndex = 0; PlayerIndex < Session.RegisteredPlayers.Num(); PlayerIndex++)
+		{
+			Indices.Add(Session.RegisteredPlayers[PlayerIndex], PlayerIndex);
+		}
+	}
+	return State.RegisteredPlayerIndices.GetValue();
+}
+
+void FEOSWrapperSessionManager::TickPlayerRegistrations()
+{
+	if (PendingPlayerRegistrations.Num() == 0)
+	{
+		return;
+	}
+
+	// Callbacks may register more players, those wait for the next tick
+	TMap<FName, FPendingPlayerRegistrations> RegistrationsToSend = MoveTemp(PendingPlayerRegistrations);
+	PendingPlayerRegistrations.Reset();
+
+	for (TPair<FName, FPendingPlayerRegistrations>& Pair : RegistrationsToSend)
+	{
+		const FName SessionName = Pair.Key;
+		FPendingPlayerRegistrations& Registrations = Pair.Value;
+		const FTCHARToUTF8 Utf8SessionName(*SessionName.ToString());
+		const bool bHasSession = GetNamedSession(SessionName) != nullptr;
+		INC_DWORD_STAT_BY(STAT_EOSWrapper_PlayerRegistrationsBatched, FMath::Max(Registrations.RegisterCallers.Num() - 1, 0) + FMath::Max(Registrations.UnregisterCallers.Num() - 1, 0));
+
+		// Unregistrations go first so a slot freed and taken in the same frame doesn't overfill the session
+		if (bHasSession && Registrations.PlayersToUnregister.Num() > 0)
+		{
+			TArray<EOS_ProductUserId> EOSIds;
+			EOSIds.Reserve(Registrations.PlayersToUnregister.Num());
+			for (const FUniqueNetIdRef& PlayerId : Registrations.PlayersToUnregister)
+			{
+				EOSIds.Add(FUniqueNetIdEOS::Cast(*PlayerId).GetProductUserId());
+			}
+
 			EOS_Sessions_UnregisterPlayersOptions Options = {};
 			Options.ApiVersion = EOS_SESSIONS_UNREGISTERPLAYERS_API_LATEST;
 			Options.PlayersToUnregister = EOSIds.GetData();
 			Options.PlayersToUnregisterCount = EOSIds.Num();
-			const FTCHARToUTF8 Utf8SessionName(*SessionName.ToString());
 			Options.SessionName = Utf8SessionName.Get();
 
 			FUnregisterPlayersCallback* CallbackObj = new FUnregisterPlayersCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-			CallbackObj->CallbackLambda = [this, SessionName, UnregisteredPlayers = TArray<FUniqueNetIdRef>(Players)](const EOS_Sessions_UnregisterPlayersCallbackInfo* Data) {
+			CallbackObj->CallbackLambda = [this, SessionName, Callers = MoveTemp(Registrations.UnregisterCallers)](const EOS_Sessions_UnregisterPlayersCallbackInfo* Data) {
 				bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_NoChange;
-				TriggerOnUnregisterPlayersCompleteDelegates(SessionName, UnregisteredPlayers, bWasSuccessful);
+				for (const TArray<FUniqueNetIdRef>& UnregisteredPlayers : Callers)
+				{
+					TriggerOnUnregisterPlayersCompleteDelegates(SessionName, UnregisteredPlayers, bWasSuccessful);
+				}
 			};
 			EOS_Sessions_UnregisterPlayers(EOSSubsystem->GetSessionsHandle(), &Options, CallbackObj, CallbackObj->GetCallbackPtr());
-			return true;
 		}
-	}
-	else
-	{
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("No game present to leave for session (%s)"), *SessionName.ToString());
-		bSuccess = false;
-	}
+		else
+		{
+			for (const TArray<FUniqueNetIdRef>& UnregisteredPlayers : Registrations.UnregisterCallers)
+			{
+				TriggerOnUnregisterPlayersCompleteDelegates(SessionName, UnregisteredPlayers, bHasSession);
+			}
+		}
 
-	EOSSubsystem->ExecuteNextTick([this, SessionName, Players, bSuccess]() { TriggerOnUnregisterPlayersCompleteDelegates(SessionName, Players, bSuccess); });
+		if (bHasSession && Registrations.PlayersToRegister.Num() > 0)
+		{
+			TArray<EOS_ProductUserId> EOSIds;
+			EOSIds.Reserve(Registrations.PlayersToRegister.Num());
+			for (const FUniqueNetIdRef& PlayerId : Registrations.PlayersToRegister)
+			{
+				EOSIds.Add(FUniqueNetIdEOS::Cast(*PlayerId).GetProductUserId());
+			}
 
-	return true;
+			EOS_Sessions_RegisterPlayersOptions Options = {};
+			Options.ApiVersion = EOS_SESSIONS_REGISTERPLAYERS_API_LATEST;
+			Options.PlayersToRegister = EOSIds.GetData();
+			Options.PlayersToRegisterCount = EOSIds.Num();
+			Options.SessionName = Utf8SessionName.Get();
+
+			FRegisterPlayersCallback* CallbackObj = new FRegisterPlayersCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
+			CallbackObj->CallbackLambda = [this, SessionName, Callers = MoveTemp(Registrations.RegisterCallers)](const EOS_Sessions_RegisterPlayersCallbackInfo* Data) {
+				bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_NoChange;
+				for (const TArray<FUniqueNetIdRef>& RegisteredPlayers : Callers)
+				{
+					TriggerOnRegisterPlayersCompleteDelegates(SessionName, RegisteredPlayers, bWasSuccessful);
+				}
+			};
+			EOS_Sessions_RegisterPlayers(EOSSubsystem->GetSessionsHandle(), &Options, CallbackObj, CallbackObj->GetCallbackPtr());
+		}
+		else
+		{
+			for (const TArray<FUniqueNetIdRef>& RegisteredPlayers : Registrations.RegisterCallers)
+			{
+				TriggerOnRegisterPlayersCompleteDelegates(SessionName, RegisteredPlayers, bHasSession);
+			}
+		}
+	}
 }
 
 void FEOSWrapperSessionManager::RegisterLocalPlayer(const FUniqueNetId& PlayerId, FName SessionName, const FOnRegisterLocalPlayerCompleteDelegate& Delegate)
@@ -1413,144 +1890,912 @@ void FEOSWrapperSessionManager::RemovePlayerFromSession(int32 LocalUserNum, FNam
 
 		EOS_Lobby_KickMember(LobbyHandle, &KickMemberOptions, CallbackObj, CallbackObj->GetCallbackPtr());
 	}
-	else
+	else
+	{
+		UE_LOG_ONLINE(Warning, TEXT("[FEOSWrapperLobby::RemovePlayerFromSession] Unable to retrieve session named %s"), *SessionName.ToString());
+	}
+}
+
+int32 FEOSWrapperSessionManager::GetNumSessions()
+{
+	FScopeLock ScopeLock(&LobbyLock);
+	return LobbySessions.Num();
+}
+
+void FEOSWrapperSessionManager::DumpSessionState()
+{
+	FScopeLock ScopeLock(&LobbyLock);
+	for (int32 SessionIdx = 0; SessionIdx < LobbySessions.Num(); SessionIdx++)
+	{
+		DumpNamedSession(&LobbySessions[SessionIdx]);
+	}
+}
+
+bool FEOSWrapperSessionManager::SetLobbyParameter(const FName& LobbyName, const FName& Parameter, const FString& Value)
+{
+	// Only lobby owner can change lobby parameters!
+	FNamedOnlineSession* LobbySession = GetNamedSession(LobbyName);
+	if (!LobbySession || !LobbySession->SessionSettings.bUseLobbiesIfAvailable) return false;
+
+	// Kept on top of the session settings so later updates don't drop it, and sent with whatever else changes in this window
+	SessionStates.FindOrAdd(LobbySession->SessionName).LobbyParameters.Add(Parameter, Value);
+	QueueSessionUpdate(LobbySession->SessionName);
+	return true;
+}
+
+void FEOSWrapperSessionManager::QueueSessionUpdate(FName SessionName)
+{
+	FPendingSessionUpdate& PendingUpdate = PendingSessionUpdates.FindOrAdd(SessionName);
+	if (PendingUpdate.NumCallers == 0)
+	{
+		// The window starts with the first call, later calls ride along instead of pushing the flush back
+		PendingUpdate.FlushTimeInSeconds = FPlatformTime::Seconds() + SessionUpdateCoalescingWindowInSeconds;
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EOSWrapper_SessionUpdatesCoalesced);
+	}
+	PendingUpdate.NumCallers++;
+
+	if (SessionUpdateCoalescingWindowInSeconds <= 0.0 && CanSendSessionUpdate(SessionName))
+	{
+		SendSessionUpdate(SessionName);
+	}
+}
+
+void FEOSWrapperSessionManager::FlushSessionUpdate(FName SessionName)
+{
+	QueueSessionUpdate(SessionName);
+
+	if (FPendingSessionUpdate* PendingUpdate = PendingSessionUpdates.Find(SessionName))
+	{
+		PendingUpdate->FlushTimeInSeconds = 0.0;
+		if (CanSendSessionUpdate(SessionName))
+		{
+			SendSessionUpdate(SessionName);
+		}
+	}
+}
+
+bool FEOSWrapperSessionManager::CanSendSessionUpdate(FName SessionName)
+{
+	// Never race an update that is still on the wire, the pending one goes out once it completed
+	const FSessionState* State = SessionStates.Find(SessionName);
+	if (State && State->bUpdateInFlight)
+	{
+		return false;
+	}
+
+	// Creation pushes the settings itself, anything changed meanwhile goes out once it finished
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	return Session == nullptr || Session->SessionState != EOnlineSessionState::Creating;
+}
+
+void FEOSWrapperSessionManager::SendSessionUpdate(FName SessionName)
+{
+	FPendingSessionUpdate PendingUpdate;
+	PendingSessionUpdates.RemoveAndCopyValue(SessionName, PendingUpdate);
+	const int32 NumCallers = PendingUpdate.NumCallers;
+
+	uint32 Result = ONLINE_FAIL;
+	FNamedOnlineSession* Session = GetNamedSession(SessionName);
+	if (Session)
+	{
+		if (Session->SessionSettings.bUseLobbiesIfAvailable)
+		{
+			Result = UpdateLobbySession(Session, NumCallers);
+		}
+		else
+		{
+			Result = UpdateEOSSession(Session, NumCallers);
+		}
+	}
+	else
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("No session (%s) found for update!"), *SessionName.ToString());
+	}
+
+	if (Result == ONLINE_IO_PENDING)
+	{
+		SessionStates.FindOrAdd(SessionName).bUpdateInFlight = true;
+	}
+	else
+	{
+		EOSSubsystem->ExecuteNextTick([this, SessionName, Result, NumCallers]() { CompleteSessionUpdate(SessionName, Result == ONLINE_SUCCESS, NumCallers); });
+	}
+}
+
+void FEOSWrapperSessionManager::CompleteSessionUpdate(FName SessionName, bool bWasSuccessful, int32 NumCallers)
+{
+	if (FSessionState* State = SessionStates.Find(SessionName))
+	{
+		State->bUpdateInFlight = false;
+	}
+
+	// Every call merged into this update completes with its result
+	for (int32 CallerIndex = 0; CallerIndex < NumCallers; CallerIndex++)
+	{
+		TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+	}
+}
+
+void FEOSWrapperSessionManager::TickSessionUpdates()
+{
+	if (PendingSessionUpdates.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	TArray<FName, TInlineAllocator<4>> ReadySessionNames;
+	for (const TPair<FName, FPendingSessionUpdate>& PendingUpdate : PendingSessionUpdates)
+	{
+		if (PendingUpdate.Value.FlushTimeInSeconds <= Now && CanSendSessionUpdate(PendingUpdate.Key))
+		{
+			ReadySessionNames.Add(PendingUpdate.Key);
+		}
+	}
+
+	for (const FName& SessionName : ReadySessionNames)
+	{
+		SendSessionUpdate(SessionName);
+	}
+}
+
+void FEOSWrapperSessionManager::Initialize(const FString& InBucketId)
+{
+	FCStringAnsi::Strncpy(BucketIdAnsi, TCHAR_TO_UTF8(*InBucketId), EOS_OSS_STRING_BUFFER_LENGTH);
+
+	// Register for session invite notifications
+	FSessionInviteAcceptedCallback* SessionInviteAcceptedCallbackObj = new FSessionInviteAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
+	SessionInviteAcceptedCallback = SessionInviteAcceptedCallbackObj;
+	SessionInviteAcceptedCallbackObj->CallbackLambda = [this](const EOS_Sessions_SessionInviteAcceptedCallbackInfo* Data) {
+		FUniqueNetIdEOSPtr NetId = EOSSubsystem->UserManager->GetLocalUniqueNetIdEOS(Data->LocalUserId);
+		if (!NetId.IsValid())
+		{
+			UE_LOG_ONLINE_SESSION(Warning, TEXT("Cannot accept invite due to unknown user (%s)"), *LexToString(Data->LocalUserId));
+			TriggerOnSessionUserInviteAcceptedDelegates(false, 0, NetId, FOnlineSessionSearchResult());
+			return;
+		}
+		int32 LocalUserNum = EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(*NetId);
+
+		EOS_Sessions_CopySessionHandleByInviteIdOptions Options = {};
+		Options.ApiVersion = EOS_SESSIONS_COPYSESSIONHANDLEBYINVITEID_API_LATEST;
+		Options.InviteId = Data->InviteId;
+		EOS_HSessionDetails SessionDetails = nullptr;
+		EOS_EResult Result = EOS_Sessions_CopySessionHandleByInviteId(EOSSubsystem->GetSessionsHandle(), &Options, &SessionDetails);
+		if (Result == EOS_EResult::EOS_Success)
+		{
+			LastInviteSearch = MakeShared<FOnlineSessionSearch>();
+			AddSearchResult(SessionDetails, LastInviteSearch.ToSharedRef());
+			TriggerOnSessionUserInviteAcceptedDelegates(true, LocalUserNum, NetId, LastInviteSearch->SearchResults[0]);
+		}
+		else
+		{
+			UE_LOG_ONLINE_SESSION(Warning, TEXT("EOS_Sessions_CopySessionHandleByInviteId not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+			TriggerOnSessionUserInviteAcceptedDelegates(false, LocalUserNum, NetId, FOnlineSessionSearchResult());
+		}
+	};
+	EOS_Sessions_AddNotifySessionInviteAcceptedOptions Options = {};
+	Options.ApiVersion = EOS_SESSIONS_ADDNOTIFYSESSIONINVITEACCEPTED_API_LATEST;
+	SessionInviteAcceptedId =
+		EOS_Sessions_AddNotifySessionInviteAccepted(EOSSubsystem->GetSessionsHandle(), &Options, SessionInviteAcceptedCallbackObj, SessionInviteAcceptedCallbackObj->GetCallbackPtr());
+
+	LobbyHandle = EOS_Platform_GetLobbyInterface(*EOSSubsystem->EOSPlatformHandle);
+	RegisterLobbyNotifications();
+
+	bIsDedicatedServer = IsRunningDedicatedServer();
+
+	const FEOSWrapperSettings EOSSettings = UEOSWrapperSettings::GetSettings();
+	SessionUpdateCoalescingWindowInSeconds = EOSSettings.SessionUpdateCoalescingWindowInMilliseconds / 1000.0;
+	FriendSessionSearchMaxParallelSearches = FMath::Max(EOSSettings.FriendSessionSearchMaxParallelSearches, 1);
+	PartitionedSearchMaxParallelSearches = FMath::Max(EOSSettings.PartitionedSearchMaxParallelSearches, 1);
+
+	SearchRankingSettings.PingWeight = EOSSettings.SearchRankingPingWeight;
+	SearchRankingSettings.FillWeight = EOSSettings.SearchRankingFillWeight;
+	SearchRankingSettings.SkillWeight = EOSSettings.SearchRankingSkillWeight;
+	SearchRankingSettings.RegionWeight = EOSSettings.SearchRankingRegionWeight;
+	SearchRankingSettings.MaxPingInMs = EOSSettings.SearchRankingMaxPingInMs;
+	SearchRankingSettings.MaxSkillBandDifference = EOSSettings.SearchRankingMaxSkillBandDifference;
+	SearchRankingSettings.TopK = EOSSettings.SearchRankingTopK;
+
+	MatchmakingSettings.RoundIntervalInSeconds = EOSSettings.MatchmakingRoundIntervalInSeconds;
+	MatchmakingSettings.MaxSkillBandRadius = EOSSettings.MatchmakingMaxSkillBandRadius;
+	MatchmakingSettings.MaxParallelSearches = EOSSettings.MatchmakingMaxParallelSearches;
+	MatchmakingSettings.CreateLobbyAfterSeconds = EOSSettings.MatchmakingCreateLobbyAfterSeconds;
+	MatchmakingSettings.Ranking = SearchRankingSettings;
+	SetMatchmakingBackend(MakeShared<FEOSMatchmakingLobbyBackend>(FEOSWrapperSessionManagerWeakPtr(AsShared())));
+
+	LanBeaconPort = EOSSettings.LanBeaconPort;
+	LanQueryIntervalInSeconds = EOSSettings.LanQueryIntervalInMilliseconds / 1000.0;
+
+	QosProber = MakeUnique<FEOSQosProber>(EOSSettings.QosSamplesPerHost, EOSSettings.QosSampleIntervalInMilliseconds / 1000.0, EOSSettings.QosTimeoutInMilliseconds / 1000.0);
+	if (bIsDedicatedServer && EOSSettings.QosResponderPort > 0)
+	{
+		QosResponder = MakeUnique<FEOSQosResponder>();
+		if (!QosResponder->Start(EOSSettings.QosResponderPort))
+		{
+			QosResponder.Reset();
+		}
+	}
+
+	if (bIsDedicatedServer && !EOSSettings.SessionSnapshotPath.IsEmpty())
+	{
+		SessionSnapshotPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir(), EOSSettings.SessionSnapshotPath);
+		SessionSnapshotIntervalInSeconds = FMath::Max(EOSSettings.SessionSnapshotIntervalInSeconds, 0.f);
+		RestoreSessionSnapshot();
+	}
+}
+
+void FEOSWrapperSessionManager::Shutdown()
+{
+	SaveSessionSnapshot();
+}
+
+void FEOSWrapperSessionManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_Session_Interface);
+	TickLanTasks(DeltaTime);
+	TickSessionUpdates();
+	TickPlayerRegistrations();
+	TickMemberStatuses();
+	Matchmaker->Tick();
+	QosProber->Tick();
+	TickSessionSnapshot();
+}
+
+void FEOSWrapperSessionManager::TickLanTasks(float DeltaTime)
+{
+	if (!LanBeacon.IsValid())
+	{
+		return;
+	}
+
+	const bool bIsLanSearching = CurrentSessionSearch.IsValid() && CurrentSessionSearch->bIsLanQuery && CurrentSessionSearch->SearchState == EOnlineAsyncTaskState::InProgress;
+	if (!bIsLanSearching && !HasAdvertisedLanSession())
+	{
+		LanBeacon.Reset();
+		return;
+	}
+
+	// Everything that arrived since the last tick is handled in one go, queries are only collected so each client gets a single answer
+	const double Now = FPlatformTime::Seconds();
+	const int32 BuildUniqueId = GetBuildUniqueId();
+	PendingLanQueries.Reset();
+	LanBeacon->Poll([this, Now, BuildUniqueId, bIsLanSearching](const uint8* Packet, int32 PacketSize, const FInternetAddr& FromAddress) {
+		FEOSLanPacketReader Reader(Packet, PacketSize);
+		FEOSLanPacketHeader Header;
+		if (!Header.Read(Reader) || Header.BuildUniqueId != BuildUniqueId)
+		{
+			return;
+		}
+
+		if (Header.Type == FEOSLanPacketHeader::EType::Query)
+		{
+			AddPendingLanQuery(Header, FromAddress);
+		}
+		else if (bIsLanSearching && Header.Nonce == LanSearchNonce)
+		{
+			OnLanResponseReceived(Header, Reader, FromAddress, Now);
+		}
+	});
+
+	if (PendingLanQueries.Num() > 0)
+	{
+		SendLanResponses();
+	}
+
+	if (bIsLanSearching)
+	{
+		const int32 MaxSearchResults = CurrentSessionSearch->MaxSearchResults;
+		if (Now - SessionSearchStartInSeconds >= CurrentSessionSearch->TimeoutInSeconds || (MaxSearchResults > 0 && CurrentSessionSearch->SearchResults.Num() >= MaxSearchResults))
+		{
+			CompleteLanSearch();
+		}
+		else if (Now >= LanNextQueryTimeInSeconds)
+		{
+			SendLanQuery(Now);
+		}
+	}
+}
+
+bool FEOSWrapperSessionManager::StartLanBeacon()
+{
+	if (LanBeacon.IsValid())
+	{
+		return true;
+	}
+
+	TUniquePtr<FEOSLanBeacon> NewBeacon = MakeUnique<FEOSLanBeacon>();
+	if (!NewBeacon->Init(LanBeaconPort))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::StartLanBeacon] Unable to open LAN beacon on port %d"), LanBeaconPort);
+		return false;
+	}
+
+	LanBeacon = MoveTemp(NewBeacon);
+	return true;
+}
+
+bool FEOSWrapperSessionManager::IsLanSessionAdvertised(const FNamedOnlineSession& Session) const
+{
+	if (!Session.SessionSettings.bIsLANMatch || !Session.SessionSettings.bShouldAdvertise || !Session.bHosting || !Session.SessionInfo.IsValid() || !Session.SessionInfo->IsValid())
+	{
+		return false;
+	}
+
+	const bool bIsJoinable = Session.SessionState == EOnlineSessionState::Pending || Session.SessionState == EOnlineSessionState::Ended ||
+		(Session.SessionState == EOnlineSessionState::InProgress && Session.SessionSettings.bAllowJoinInProgress);
+	return bIsJoinable && Session.NumOpenPublicConnections > 0;
+}
+
+bool FEOSWrapperSessionManager::HasAdvertisedLanSession() const
+{
+	FScopeLock ScopeLock(&LobbyLock);
+	for (const FNamedOnlineSession& Session : LobbySessions)
+	{
+		if (Session.SessionSettings.bIsLANMatch && Session.SessionSettings.bShouldAdvertise && Session.bHosting)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32 FEOSWrapperSessionManager::CreateLANSession(int32 HostingPlayerNum, FNamedOnlineSession* Session)
+{
+	check(Session);
+
+	FOnlineSessionInfoEOS* NewSessionInfo = new FOnlineSessionInfoEOS();
+	NewSessionInfo->InitLAN(EOSSubsystem);
+	Session->SessionInfo = MakeShareable(NewSessionInfo);
+	Session->bHosting = true;
+
+	if (Session->SessionSettings.bShouldAdvertise && !StartLanBeacon())
+	{
+		return ONLINE_FAIL;
+	}
+	return ONLINE_SUCCESS;
+}
+
+uint32 FEOSWrapperSessionManager::JoinLANSession(int32 PlayerNum, FNamedOnlineSession* Session, const FOnlineSession* SearchSession)
+{
+	check(Session);
+
+	if (SearchSession == nullptr || !SearchSession->SessionInfo.IsValid() || !SearchSession->SessionInfo->IsValid())
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::JoinLANSession] Invalid session info on search result"));
+		return ONLINE_FAIL;
+	}
+
+	// Nothing to tell the host, the connect string is all the travel needs
+	TSharedPtr<const FOnlineSessionInfoEOS> SearchSessionInfo = StaticCastSharedPtr<const FOnlineSessionInfoEOS>(SearchSession->SessionInfo);
+	Session->SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(*SearchSessionInfo));
+	return ONLINE_SUCCESS;
+}
+
+uint32 FEOSWrapperSessionManager::FindLANSession()
+{
+	if (!StartLanBeacon())
+	{
+		return ONLINE_FAIL;
+	}
+
+	LanSearchNonce = ((uint64)FMath::Rand() << 32) ^ FPlatformTime::Cycles64();
+	LanQuerySendTimes.Reset();
+	LanSearchResultIndices.Reset();
+	bLanSessionDiscovered = false;
+	SendLanQuery(FPlatformTime::Seconds());
+	return ONLINE_IO_PENDING;
+}
+
+void FEOSWrapperSessionManager::SendLanQuery(double Now)
+{
+	if (LanQuerySendTimes.Num() >= MAX_uint16)
+	{
+		return;
+	}
+
+	FEOSLanPacketHeader Header;
+	Header.Type = FEOSLanPacketHeader::EType::Query;
+	Header.BuildUniqueId = GetBuildUniqueId();
+	Header.Nonce = LanSearchNonce;
+	Header.Sequence = (uint16)LanQuerySendTimes.Num();
+
+	LanQueryBuffer.Reset();
+	FEOSLanPacketWriter Writer(LanQueryBuffer);
+	Header.Write(Writer);
+
+	LanQuerySendTimes.Add(Now);
+	LanNextQueryTimeInSeconds = Now + LanQueryIntervalInSeconds;
+	if (!LanBeacon->Broadcast(LanQueryBuffer.GetData(), LanQueryBuffer.Num()))
+	{
+		UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FOnlineSessionEOS::SendLanQuery] Broadcast failed"));
+	}
+}
+
+void FEOSWrapperSessionManager::AddPendingLanQuery(const FEOSLanPacketHeader& Header, const FInternetAddr& FromAddress)
+{
+	uint32 Ip = 0;
+	FromAddress.GetIp(Ip);
+	const int32 Port = FromAddress.GetPort();
+
+	// Clients resend queries, one answer per client and search is enough
+	for (FPendingLanQuery& Query : PendingLanQueries)
+	{
+		if (Query.Ip == Ip && Query.Port == Port && Query.Nonce == Header.Nonce)
+		{
+			Query.Sequence = Header.Sequence;
+			return;
+		}
+	}
+
+	FPendingLanQuery& Query = PendingLanQueries.AddDefaulted_GetRef();
+	Query.Ip = Ip;
+	Query.Port = Port;
+	Query.Nonce = Header.Nonce;
+	Query.Sequence = Header.Sequence;
+}
+
+void FEOSWrapperSessionManager::SendLanResponses()
+{
+	FEOSLanPacketHeader Header;
+	Header.Type = FEOSLanPacketHeader::EType::Response;
+	Header.BuildUniqueId = GetBuildUniqueId();
+
+	// Sessions are packed into as few packets as fit, each packet is a header and a session count followed by the sessions
+	LanResponseBuffer.Reset();
+	LanResponsePacketOffsets.Reset();
+	int32 CountOffset = INDEX_NONE;
+	{
+		FEOSLanPacketWriter ResponseWriter(LanResponseBuffer);
+		FScopeLock ScopeLock(&LobbyLock);
+		for (const FNamedOnlineSession& Session : LobbySessions)
+		{
+			if (!IsLanSessionAdvertised(Session))
+			{
+				continue;
+			}
+
+			LanSessionBuffer.Reset();
+			FEOSLanPacketWriter SessionWriter(LanSessionBuffer);
+			AppendSessionToPacket(SessionWriter, Session);
+
+			const int32 PacketStart = LanResponsePacketOffsets.Num() > 0 ? LanResponsePacketOffsets.Last() : 0;
+			if (LanSessionBuffer.Num() + FEOSLanPacketHeader::Size + 1 > FEOSLanBeacon::MaxPacketSize)
+			{
+				UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::SendLanResponses] Session (%s) doesn't fit in a LAN packet"), *Session.SessionName.ToString());
+				continue;
+			}
+
+			if (CountOffset == INDEX_NONE || LanResponseBuffer.Num() - PacketStart + LanSessionBuffer.Num() > FEOSLanBeacon::MaxPacketSize ||
+				LanResponseBuffer[CountOffset] == MAX_uint8)
+			{
+				LanResponsePacketOffsets.Add(LanResponseBuffer.Num());
+				Header.Write(ResponseWriter);
+				CountOffset = LanResponseBuffer.Num();
+				ResponseWriter.Write((uint8)0);
+			}
+
+			LanResponseBuffer.Append(LanSessionBuffer);
+			LanResponseBuffer[CountOffset]++;
+		}
+	}
+
+	if (LanResponsePacketOffsets.Num() == 0)
+	{
+		return;
+	}
+
+	// Only the nonce and sequence differ between clients, they're patched in place before each send
+	for (const FPendingLanQuery& Query : PendingLanQueries)
+	{
+		for (int32 PacketIndex = 0; PacketIndex < LanResponsePacketOffsets.Num(); PacketIndex++)
+		{
+			const int32 PacketStart = LanResponsePacketOffsets[PacketIndex];
+			const int32 PacketEnd = PacketIndex + 1 < LanResponsePacketOffsets.Num() ? LanResponsePacketOffsets[PacketIndex + 1] : LanResponseBuffer.Num();
+			uint8* Packet = LanResponseBuffer.GetData() + PacketStart;
+			FMemory::Memcpy(Packet + FEOSLanPacketHeader::NonceOffset, &Query.Nonce, sizeof(Query.Nonce));
+			FMemory::Memcpy(Packet + FEOSLanPacketHeader::SequenceOffset, &Query.Sequence, sizeof(Query.Sequence));
+			LanBeacon->SendTo(Packet, PacketEnd - PacketStart, Query.Ip, Query.Port);
+		}
+	}
+}
+
+void FEOSWrapperSessionManager::OnLanResponseReceived(const FEOSLanPacketHeader& Header, FEOSLanPacketReader& Reader, const FInternetAddr& FromAddress, double Now)
+{
+	// Measured against the query this answers, so resent queries don't inflate the ping. Still includes up to a frame spent waiting for the tick
+	const double SendTime = LanQuerySendTimes.IsValidIndex(Header.Sequence) ? LanQuerySendTimes[Header.Sequence] : SessionSearchStartInSeconds;
+	const int32 PingInMs = FMath::Clamp(FMath::RoundToInt((Now - SendTime) * 1000.0), 0, MAX_QUERY_PING);
+
+	uint8 NumSessions = 0;
+	Reader.Read(NumSessions);
+	TArray<FOnlineSessionSearchResult>& SearchResults = CurrentSessionSearch->SearchResults;
+	for (int32 SessionIndex = 0; SessionIndex < NumSessions; SessionIndex++)
+	{
+		FOnlineSessionSearchResult& NewResult = SearchResults.AddDefaulted_GetRef();
+		if (!ReadSessionFromPacket(Reader, FromAddress, NewResult.Session))
+		{
+			UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FOnlineSessionEOS::OnLanResponseReceived] Malformed response from %s"), *FromAddress.ToString(true));
+			SearchResults.Pop();
+			return;
+		}
+		NewResult.PingInMs = PingInMs;
+
+		// Hosts answer every resent query, later answers refresh the session but keep the best ping
+		const int32 NewIndex = SearchResults.Num() - 1;
+		const int32 ExistingIndex = LanSearchResultIndices.FindOrAdd(NewResult.GetSessionIdStr(), NewIndex);
+		if (ExistingIndex != NewIndex)
+		{
+			FOnlineSessionSearchResult& ExistingResult = SearchResults[ExistingIndex];
+			ExistingResult.Session = MoveTemp(NewResult.Session);
+			ExistingResult.PingInMs = FMath::Min(ExistingResult.PingInMs, PingInMs);
+			SearchResults.Pop();
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_EOSWrapper_LanSessionsDiscovered);
+		if (!bLanSessionDiscovered)
+		{
+			bLanSessionDiscovered = true;
+			const float DiscoveryLatencyInMs = (float)((Now - SessionSearchStartInSeconds) * 1000.0);
+			SET_FLOAT_STAT(STAT_EOSWrapper_LanDiscoveryLatency, DiscoveryLatencyInMs);
+			UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FOnlineSessionEOS::OnLanResponseReceived] First LAN session found after %.2f ms"), DiscoveryLatencyInMs);
+		}
+	}
+}
+
+void FEOSWrapperSessionManager::RankCompletedSearch(FOnlineSessionSearch& Search)
+{
+	// Results have no measured ping yet, cutting them down to the top K now would rank them on ping before it is known
+	const bool bKeepAllResults = SearchRankingSettings.PingWeight != 0.f;
+	FEOSSessionSearchRanker::RankSearchResults(SearchRankingSettings, Search, bKeepAllResults);
+}
+
+void FEOSWrapperSessionManager::CompleteLanSearch()
+{
+	TSharedRef<FOnlineSessionSearch> SearchSettings = CurrentSessionSearch.ToSharedRef();
+	UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FOnlineSessionEOS::CompleteLanSearch] Found %d sessions with %d queries"), SearchSettings->SearchResults.Num(), LanQuerySendTimes.Num());
+
+	LanSearchNonce = 0;
+	RankCompletedSearch(*SearchSettings);
+	SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+	TriggerOnFindSessionsCompleteDelegates(true);
+}
+
+/** Boolean session settings as sent in LAN packets and stored in session snapshots */
+static uint16 PackSessionSettingsFlags(const FOnlineSessionSettings& Settings)
+{
+	return (Settings.bShouldAdvertise ? 1 << 0 : 0) | (Settings.bAllowJoinInProgress ? 1 << 1 : 0) | (Settings.bIsDedicated ? 1 << 2 : 0) | (Settings.bUsesStats ? 1 << 3 : 0) |
+		(Settings.bAllowInvites ? 1 << 4 : 0) | (Settings.bUsesPresence ? 1 << 5 : 0) | (Settings.bAllowJoinViaPresence ? 1 << 6 : 0) |
+		(Settings.bAllowJoinViaPresenceFriendsOnly ? 1 << 7 : 0) | (Settings.bAntiCheatProtected ? 1 << 8 : 0);
+}
+
+static void UnpackSessionSettingsFlags(uint16 Flags, FOnlineSessionSettings& OutSettings)
+{
+	OutSettings.bShouldAdvertise = (Flags & (1 << 0)) != 0;
+	OutSettings.bAllowJoinInProgress = (Flags & (1 << 1)) != 0;
+	OutSettings.bIsDedicated = (Flags & (1 << 2)) != 0;
+	OutSettings.bUsesStats = (Flags & (1 << 3)) != 0;
+	OutSettings.bAllowInvites = (Flags & (1 << 4)) != 0;
+	OutSettings.bUsesPresence = (Flags & (1 << 5)) != 0;
+	OutSettings.bAllowJoinViaPresence = (Flags & (1 << 6)) != 0;
+	OutSettings.bAllowJoinViaPresenceFriendsOnly = (Flags & (1 << 7)) != 0;
+	OutSettings.bAntiCheatProtected = (Flags & (1 << 8)) != 0;
+}
+
+void FEOSWrapperSessionManager::AppendSessionToPacket(FEOSLanPacketWriter& Writer, const FNamedOnlineSession& Session) const
+{
+	const FOnlineSessionInfoEOS* SessionInfo = (const FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
+	const FOnlineSessionSettings& Settings = Session.SessionSettings;
+
+	Writer.WriteString(SessionInfo->SessionId->ToString());
+	// Clients take the host IP from the packet, only the game port travels
+	Writer.Write((uint16)SessionInfo->HostAddr->GetPort());
+	Writer.WriteString(Session.OwningUserId.IsValid() ? Session.OwningUserId->ToString() : FString());
+	Writer.WriteString(Session.OwningUserName);
+	Writer.Write(Session.NumOpenPrivateConnections);
+	Writer.Write(Session.NumOpenPublicConnections);
+
+	Writer.Write(Settings.NumPublicConnections);
+	Writer.Write(Settings.NumPrivateConnections);
+	Writer.Write(Settings.BuildUniqueId);
+	Writer.Write(PackSessionSettingsFlags(Settings));
+
+	uint16 NumAdvertisedSettings = 0;
+	for (const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings)
+	{
+		NumAdvertisedSettings += Setting.Value.AdvertisementType >= EOnlineDataAdvertisementType::ViaOnlineService ? 1 : 0;
+	}
+	Writer.Write(NumAdvertisedSettings);
+	for (const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings)
+	{
+		if (Setting.Value.AdvertisementType >= EOnlineDataAdvertisementType::ViaOnlineService)
+		{
+			Writer.WriteName(Setting.Key);
+			Writer.Write((uint8)Setting.Value.AdvertisementType);
+			Writer.WriteVariant(Setting.Value.Data);
+		}
+	}
+}
+
+bool FEOSWrapperSessionManager::ReadSessionFromPacket(FEOSLanPacketReader& Reader, const FInternetAddr& FromAddress, FOnlineSession& OutSession) const
+{
+	FString SessionId;
+	uint16 HostPort = 0;
+	FString OwningUserId;
+	Reader.ReadString(SessionId);
+	Reader.Read(HostPort);
+	Reader.ReadString(OwningUserId);
+	Reader.ReadString(OutSession.OwningUserName);
+	Reader.Read(OutSession.NumOpenPrivateConnections);
+	Reader.Read(OutSession.NumOpenPublicConnections);
+
+	FOnlineSessionSettings& Settings = OutSession.SessionSettings;
+	uint16 Flags = 0;
+	Reader.Read(Settings.NumPublicConnections);
+	Reader.Read(Settings.NumPrivateConnections);
+	Reader.Read(Settings.BuildUniqueId);
+	Reader.Read(Flags);
+	Settings.bIsLANMatch = true;
+	UnpackSessionSettingsFlags(Flags, Settings);
+
+	uint16 NumSettings = 0;
+	Reader.Read(NumSettings);
+	for (int32 SettingIndex = 0; SettingIndex < NumSettings && !Reader.HasError(); SettingIndex++)
+	{
+		FName Key;
+		uint8 AdvertisementType = 0;
+		FOnlineSessionSetting Setting;
+		Reader.ReadName(Key);
+		Reader.Read(AdvertisementType);
+		Reader.ReadVariant(Setting.Data);
+		Setting.AdvertisementType = (EOnlineDataAdvertisementType::Type)AdvertisementType;
+		Settings.Settings.Add(Key, MoveTemp(Setting));
+	}
+
+	if (Reader.HasError() || SessionId.IsEmpty())
+	{
+		return false;
+	}
+
+	if (!OwningUserId.IsEmpty())
 	{
-		UE_LOG_ONLINE(Warning, TEXT("[FEOSWrapperLobby::RemovePlayerFromSession] Unable to retrieve session named %s"), *SessionName.ToString());
+		OutSession.OwningUserId = EOSSubsystem->UserManager->CreateUniquePlayerId(OwningUserId);
 	}
+
+	FOnlineSessionInfoEOS* SessionInfo = new FOnlineSessionInfoEOS();
+	SessionInfo->HostAddr = FromAddress.Clone();
+	SessionInfo->HostAddr->SetPort(HostPort);
+	SessionInfo->SessionId = FUniqueNetIdEOSSession::Create(SessionId);
+	OutSession.SessionInfo = MakeShareable(SessionInfo);
+	return true;
 }
 
-int32 FEOSWrapperSessionManager::GetNumSessions()
+/** Snapshot file layout, the version is bumped whenever it changes and older files are ignored */
+static constexpr uint32 SessionSnapshotMagic = 0x534E5345;  // "ESNS"
+static constexpr uint8 SessionSnapshotVersion = 1;
+
+bool FEOSWrapperSessionManager::ShouldSnapshotSession(const FNamedOnlineSession& Session) const
 {
-	FScopeLock ScopeLock(&LobbyLock);
-	return LobbySessions.Num();
+	// Lobbies belong to a logged in user and LAN sessions live and die with the process, only dedicated server EOS sessions can be recreated
+	return Session.bHosting && !Session.SessionSettings.bIsLANMatch && !Session.SessionSettings.bUseLobbiesIfAvailable && Session.SessionInfo.IsValid() &&
+		   Session.SessionState != EOnlineSessionState::NoSession && Session.SessionState != EOnlineSessionState::Destroying;
 }
 
-void FEOSWrapperSessionManager::DumpSessionState()
+void FEOSWrapperSessionManager::WriteSessionSnapshot(FEOSLanPacketWriter& Writer) const
 {
-	FScopeLock ScopeLock(&LobbyLock);
-	for (int32 SessionIdx = 0; SessionIdx < LobbySessions.Num(); SessionIdx++)
+	TArray<const FNamedOnlineSession*, TInlineAllocator<8>> Sessions;
+	for (const FNamedOnlineSession& Session : LobbySessions)
 	{
-		DumpNamedSession(&LobbySessions[SessionIdx]);
+		const FOnlineSessionInfoEOS* SessionInfo = (const FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
+		if (ShouldSnapshotSession(Session) && SessionInfo->SessionId.IsValid() && !SessionInfo->SessionId->ToString().IsEmpty())
+		{
+			Sessions.Add(&Session);
+		}
+	}
+
+	Writer.Write(SessionSnapshotMagic);
+	Writer.Write(SessionSnapshotVersion);
+	Writer.Write((uint16)Sessions.Num());
+	for (const FNamedOnlineSession* Session : Sessions)
+	{
+		const FOnlineSessionInfoEOS* SessionInfo = (const FOnlineSessionInfoEOS*)Session->SessionInfo.Get();
+		const FOnlineSessionSettings& Settings = Session->SessionSettings;
+
+		Writer.WriteName(Session->SessionName);
+		Writer.WriteString(SessionInfo->SessionId->ToString());
+		Writer.Write(Session->HostingPlayerNum);
+		const bool bStarted = Session->SessionState == EOnlineSessionState::Starting || Session->SessionState == EOnlineSessionState::InProgress;
+		Writer.Write((uint8)(bStarted ? 1 : 0));
+		Writer.Write(Session->NumOpenPrivateConnections);
+		Writer.Write(Session->NumOpenPublicConnections);
+
+		Writer.Write(Settings.NumPublicConnections);
+		Writer.Write(Settings.NumPrivateConnections);
+		Writer.Write(PackSessionSettingsFlags(Settings));
+
+		// Unlike LAN packets the snapshot keeps settings that are never advertised, the game may rely on them after the restart
+		Writer.Write((uint16)Settings.Settings.Num());
+		for (const TPair<FName, FOnlineSessionSetting>& Setting : Settings.Settings)
+		{
+			Writer.WriteName(Setting.Key);
+			Writer.Write((uint8)Setting.Value.AdvertisementType);
+			Writer.WriteVariant(Setting.Value.Data);
+		}
+
+		Writer.Write((uint16)Session->RegisteredPlayers.Num());
+		for (const FUniqueNetIdRef& PlayerId : Session->RegisteredPlayers)
+		{
+			Writer.WriteString(PlayerId->ToString());
+		}
 	}
 }
 
-bool FEOSWrapperSessionManager::SetLobbyParameter(const FName& LobbyName, const FName& Parameter, const FString& Value)
+void FEOSWrapperSessionManager::TickSessionSnapshot()
 {
-	// Only lobby owner can change lobby parameters!
-	FNamedOnlineSession* LobbySession = GetNamedSession(LobbyName);
-	if (!LobbySession) return false;
-
-	EOS_Lobby_UpdateLobbyModificationOptions UpdateLobbyModificationOptions = {0};
-	UpdateLobbyModificationOptions.ApiVersion = EOS_LOBBY_UPDATELOBBYMODIFICATION_API_LATEST;
-	const FTCHARToUTF8 Utf8LobbyId(*LobbySession->SessionInfo->GetSessionId().ToString());
-	UpdateLobbyModificationOptions.LobbyId = static_cast<EOS_LobbyId>(Utf8LobbyId.Get());
-	UpdateLobbyModificationOptions.LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(EOSSubsystem->UserManager->GetDefaultLocalUser());  // Maybe not split screen friendly
-
-	EOS_HLobbyModification LobbyModificationHandle;
-	EOS_EResult LobbyModificationResult = EOS_Lobby_UpdateLobbyModification(LobbyHandle, &UpdateLobbyModificationOptions, &LobbyModificationHandle);
-	if (LobbyModificationResult == EOS_EResult::EOS_Success)
-	{
-		const FString AttributeKey(Parameter.ToString());
-		const FLobbyAttributeOptions UpdatedAttribute(TCHAR_TO_UTF8(*AttributeKey), TCHAR_TO_UTF8(*Value));
-		AddLobbyAttribute(LobbyModificationHandle, &UpdatedAttribute);
-
-		EOS_Lobby_UpdateLobbyOptions UpdateLobbyOptions = {0};
-		UpdateLobbyOptions.ApiVersion = EOS_LOBBY_UPDATELOBBY_API_LATEST;
-		UpdateLobbyOptions.LobbyModificationHandle = LobbyModificationHandle;
-
-		FName SessionName = LobbySession->SessionName;
-		FLobbyUpdatedCallback* CallbackObj = new FLobbyUpdatedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-		CallbackObj->CallbackLambda = [this, SessionName](const EOS_Lobby_UpdateLobbyCallbackInfo* Data) {
-			FNamedOnlineSession* Session = GetNamedSession(SessionName);
-			if (Session)
-			{
-				bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
-				if (!bWasSuccessful)
-				{
-					Session->SessionState = EOnlineSessionState::NoSession;
-					UE_LOG_ONLINE_SESSION(
-						Warning, TEXT("[FEOSWrapperLobby::SetLobbyParameter] UpdateLobby not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
-				}
+	if (SessionSnapshotPath.IsEmpty())
+	{
+		return;
+	}
 
-				TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
-			}
-			else
-			{
-				UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::UpdateLobbySession] Unable to find session %s"), *SessionName.ToString());
-				TriggerOnUpdateSessionCompleteDelegates(SessionName, false);
-			}
-		};
+	const double Now = FPlatformTime::Seconds();
+	if (Now < NextSessionSnapshotTimeInSeconds)
+	{
+		return;
+	}
+	NextSessionSnapshotTimeInSeconds = Now + SessionSnapshotIntervalInSeconds;
 
-		EOS_Lobby_UpdateLobby(LobbyHandle, &UpdateLobbyOptions, CallbackObj, CallbackObj->GetCallbackPtr());
-		EOS_LobbyModification_Release(LobbyModificationHandle);
-		return true;
+	SaveSessionSnapshot();
+}
+
+void FEOSWrapperSessionManager::SaveSessionSnapshot()
+{
+	if (SessionSnapshotPath.IsEmpty() || bRestoringSessionSnapshot)
+	{
+		return;
 	}
-	else
+
+	SCOPE_CYCLE_COUNTER(STAT_EOSWrapper_WriteSessionSnapshot);
+	SessionSnapshotBuffer.Reset();
+	FEOSLanPacketWriter Writer(SessionSnapshotBuffer);
+	WriteSessionSnapshot(Writer);
+	if (SessionSnapshotBuffer == LastSessionSnapshot)
 	{
-		UE_LOG_ONLINE_SESSION(
-			Warning, TEXT("[FEOSWrapperLobby::SetLobbyParameter] UpdateLobbyModification not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(LobbyModificationResult)));
+		return;
 	}
-	return false;
+
+	// Written next to the snapshot and moved over it, a crash mid write leaves the previous snapshot intact
+	const FString TempPath = SessionSnapshotPath + TEXT(".tmp");
+	if (!FFileHelper::SaveArrayToFile(SessionSnapshotBuffer, *TempPath) || !IFileManager::Get().Move(*SessionSnapshotPath, *TempPath, true))
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::SaveSessionSnapshot] Failed to write session snapshot %s"), *SessionSnapshotPath);
+		return;
+	}
+
+	Swap(LastSessionSnapshot, SessionSnapshotBuffer);
 }
 
-void FEOSWrapperSessionManager::Initialize(const FString& InBucketId)
+void FEOSWrapperSessionManager::RestoreSessionSnapshot()
 {
-	FCStringAnsi::Strncpy(BucketIdAnsi, TCHAR_TO_UTF8(*InBucketId), EOS_OSS_STRING_BUFFER_LENGTH);
+	TArray<uint8> Snapshot;
+	if (!FFileHelper::LoadFileToArray(Snapshot, *SessionSnapshotPath, FILEREAD_Silent))
+	{
+		return;
+	}
 
-	// Register for session invite notifications
-	FSessionInviteAcceptedCallback* SessionInviteAcceptedCallbackObj = new FSessionInviteAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	SessionInviteAcceptedCallback = SessionInviteAcceptedCallbackObj;
-	SessionInviteAcceptedCallbackObj->CallbackLambda = [this](const EOS_Sessions_SessionInviteAcceptedCallbackInfo* Data) {
-		FUniqueNetIdEOSPtr NetId = EOSSubsystem->UserManager->GetLocalUniqueNetIdEOS(Data->LocalUserId);
-		if (!NetId.IsValid())
-		{
-			UE_LOG_ONLINE_SESSION(Warning, TEXT("Cannot accept invite due to unknown user (%s)"), *LexToString(Data->LocalUserId));
-			TriggerOnSessionUserInviteAcceptedDelegates(false, 0, NetId, FOnlineSessionSearchResult());
-			return;
-		}
-		int32 LocalUserNum = EOSSubsystem->UserManager->GetLocalUserNumFromUniqueNetId(*NetId);
+	FEOSLanPacketReader Reader(Snapshot.GetData(), Snapshot.Num());
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	uint16 NumSessions = 0;
+	Reader.Read(Magic);
+	Reader.Read(Version);
+	Reader.Read(NumSessions);
+	if (Reader.HasError() || Magic != SessionSnapshotMagic || Version != SessionSnapshotVersion)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::RestoreSessionSnapshot] Ignoring unreadable session snapshot %s"), *SessionSnapshotPath);
+		return;
+	}
 
-		EOS_Sessions_CopySessionHandleByInviteIdOptions Options = {};
-		Options.ApiVersion = EOS_SESSIONS_COPYSESSIONHANDLEBYINVITEID_API_LATEST;
-		Options.InviteId = Data->InviteId;
-		EOS_HSessionDetails SessionDetails = nullptr;
-		EOS_EResult Result = EOS_Sessions_CopySessionHandleByInviteId(EOSSubsystem->GetSessionsHandle(), &Options, &SessionDetails);
-		if (Result == EOS_EResult::EOS_Success)
+	TGuardValue<bool> RestoringGuard(bRestoringSessionSnapshot, true);
+	int32 NumRestored = 0;
+	for (int32 SessionIndex = 0; SessionIndex < NumSessions; SessionIndex++)
+	{
+		if (Reader.HasError())
 		{
-			LastInviteSearch = MakeShared<FOnlineSessionSearch>();
-			AddSearchResult(SessionDetails, LastInviteSearch.ToSharedRef());
-			TriggerOnSessionUserInviteAcceptedDelegates(true, LocalUserNum, NetId, LastInviteSearch->SearchResults[0]);
+			UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::RestoreSessionSnapshot] Session snapshot %s is truncated"), *SessionSnapshotPath);
+			break;
 		}
-		else
+		NumRestored += RestoreSession(Reader) ? 1 : 0;
+	}
+
+	UE_LOG_ONLINE_SESSION(Log, TEXT("[FOnlineSessionEOS::RestoreSessionSnapshot] Recreating %d of %d sessions from %s"), NumRestored, NumSessions, *SessionSnapshotPath);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_SessionsRestored, NumRestored);
+}
+
+bool FEOSWrapperSessionManager::RestoreSession(FEOSLanPacketReader& Reader)
+{
+	FName SessionName;
+	FString SessionId;
+	int32 HostingPlayerNum = 0;
+	uint8 bStarted = 0;
+	int32 NumOpenPrivateConnections = 0;
+	int32 NumOpenPublicConnections = 0;
+	Reader.ReadName(SessionName);
+	Reader.ReadString(SessionId);
+	Reader.Read(HostingPlayerNum);
+	Reader.Read(bStarted);
+	Reader.Read(NumOpenPrivateConnections);
+	Reader.Read(NumOpenPublicConnections);
+
+	FOnlineSessionSettings Settings;
+	uint16 Flags = 0;
+	Reader.Read(Settings.NumPublicConnections);
+	Reader.Read(Settings.NumPrivateConnections);
+	Reader.Read(Flags);
+	UnpackSessionSettingsFlags(Flags, Settings);
+
+	uint16 NumSettings = 0;
+	Reader.Read(NumSettings);
+	for (int32 SettingIndex = 0; SettingIndex < NumSettings && !Reader.HasError(); SettingIndex++)
+	{
+		FName Key;
+		uint8 AdvertisementType = 0;
+		FOnlineSessionSetting Setting;
+		Reader.ReadName(Key);
+		Reader.Read(AdvertisementType);
+		Reader.ReadVariant(Setting.Data);
+		Setting.AdvertisementType = (EOnlineDataAdvertisementType::Type)AdvertisementType;
+		Settings.Settings.Add(Key, MoveTemp(Setting));
+	}
+
+	uint16 NumPlayers = 0;
+	Reader.Read(NumPlayers);
+	TArray<FUniqueNetIdRef> Players;
+	for (int32 PlayerIndex = 0; PlayerIndex < NumPlayers && !Reader.HasError(); PlayerIndex++)
+	{
+		FString PlayerId;
+		Reader.ReadString(PlayerId);
+		FUniqueNetIdPtr PlayerNetId = EOSSubsystem->UserManager->CreateUniquePlayerId(PlayerId);
+		if (PlayerNetId.IsValid())
 		{
-			UE_LOG_ONLINE_SESSION(Warning, TEXT("EOS_Sessions_CopySessionHandleByInviteId not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
-			TriggerOnSessionUserInviteAcceptedDelegates(false, LocalUserNum, NetId, FOnlineSessionSearchResult());
+			Players.Add(PlayerNetId.ToSharedRef());
 		}
-	};
-	EOS_Sessions_AddNotifySessionInviteAcceptedOptions Options = {};
-	Options.ApiVersion = EOS_SESSIONS_ADDNOTIFYSESSIONINVITEACCEPTED_API_LATEST;
-	SessionInviteAcceptedId =
-		EOS_Sessions_AddNotifySessionInviteAccepted(EOSSubsystem->GetSessionsHandle(), &Options, SessionInviteAcceptedCallbackObj, SessionInviteAcceptedCallbackObj->GetCallbackPtr());
+	}
 
-	LobbyHandle = EOS_Platform_GetLobbyInterface(*EOSSubsystem->EOSPlatformHandle);
-	RegisterLobbyNotifications();
+	if (Reader.HasError() || SessionId.IsEmpty() || GetNamedSession(SessionName) != nullptr)
+	{
+		return false;
+	}
 
-	bIsDedicatedServer = IsRunningDedicatedServer();
-}
+	FNamedOnlineSession* Session = AddNamedSession(SessionName, Settings);
+	Session->SessionState = EOnlineSessionState::Creating;
+	Session->HostingPlayerNum = HostingPlayerNum;
+	Session->NumOpenPrivateConnections = NumOpenPrivateConnections;
+	Session->NumOpenPublicConnections = NumOpenPublicConnections;
+	// A rolling update restarts the server on a new build, the session is advertised as that one
+	Session->SessionSettings.BuildUniqueId = GetBuildUniqueId();
+	if (QosResponder.IsValid())
+	{
+		Session->SessionSettings.Set(SETTING_EOSWRAPPER_QOSPORT, QosResponder->GetPort(), EOnlineDataAdvertisementType::ViaOnlineService);
+	}
+	Session->RegisteredPlayers = Players;
 
-void FEOSWrapperSessionManager::Tick(float DeltaTime)
-{
-	SCOPE_CYCLE_COUNTER(STAT_Session_Interface);
-	TickLanTasks(DeltaTime);
-}
+	FSessionState& SessionState = SessionStates.FindOrAdd(SessionName);
+	SessionState.RestoredPlayers = MoveTemp(Players);
+	SessionState.bRestoreStarted = bStarted != 0;
+	SessionState.bRestored = true;
 
-void FEOSWrapperSessionManager::TickLanTasks(float DeltaTime)
-{
-	// if (LANSession.IsValid() &&
-	// 	LANSession->GetBeaconState() > ELanBeaconState::NotUsingLanBeacon)
-	// {
-	// 	LANSession->Tick(DeltaTime);
-	// }
+	// Same id as before the restart, clients holding it keep finding the session.
+	// EOS can't hand a backend session over to a new process, if the old one is still around the create fails and is retried under a new id
+	if (CreateEOSSession(HostingPlayerNum, Session, SessionId) != ONLINE_IO_PENDING && CreateEOSSession(HostingPlayerNum, Session) != ONLINE_IO_PENDING)
+	{
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::RestoreSession] Failed to recreate session %s (%s)"), *SessionName.ToString(), *SessionId);
+		RemoveNamedSession(SessionName);
+		return false;
+	}
+
+	return true;
 }
 
 template <typename BaseStruct>
@@ -1574,7 +2819,7 @@ struct FSessionCreateOptions : public TNamedSessionOptions<EOS_Sessions_CreateSe
 	}
 };
 
-uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineSession* Session)
+uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineSession* Session, const FString& SessionId)
 {
 	check(Session != nullptr);
 
@@ -1587,6 +2832,8 @@ uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FName
 								   Session->SessionSettings.bAllowInvites)
 								   ? EOS_TRUE
 								   : EOS_FALSE;
+	const FTCHARToUTF8 Utf8SessionId(*SessionId);
+	Options.SessionId = SessionId.IsEmpty() ? nullptr : Utf8SessionId.Get();
 
 	EOS_EResult ResultCode = EOS_Sessions_CreateSessionModification(EOSSubsystem->GetSessionsHandle(), &Options, &SessionModHandle);
 	if (ResultCode != EOS_EResult::EOS_Success)
@@ -1621,18 +2868,38 @@ uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FName
 		// This is basically ignored
 		HostAddr = TEXT("127.0.0.1");
 	}
-	Session->SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(HostAddr, FUniqueNetIdEOSSession::Create(FString()), nullptr));
+	Session->SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(HostAddr, FUniqueNetIdEOSSession::Create(SessionId), nullptr));
 
 	FName SessionName = Session->SessionName;
 
+	// A new session starts with nothing on the backend, so everything is sent
+	SessionStates.FindOrAdd(SessionName).CommittedState.Reset();
+	TSharedRef<FSessionAttributeState> StagedState = MakeShared<FSessionAttributeState>();
+	MakeSessionAttributeState(Session, *StagedState);
+
 	FUpdateSessionCallback* CallbackObj = new FUpdateSessionCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	CallbackObj->CallbackLambda = [this, SessionName](const EOS_Sessions_UpdateSessionCallbackInfo* Data) {
+	CallbackObj->CallbackLambda = [this, SessionName, StagedState, HostingPlayerNum, SessionId](const EOS_Sessions_UpdateSessionCallbackInfo* Data) {
 		bool bWasSuccessful = false;
+		// Read before a failure removes the session state along with the session
+		const FSessionState* RestoredState = SessionStates.Find(SessionName);
+		const bool bRestored = RestoredState && RestoredState->bRestored;
 
 		FNamedOnlineSession* Session = GetNamedSession(SessionName);
 		if (Session)
 		{
 			bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
+			CommitSessionAttributeState(SessionName, *StagedState, bWasSuccessful);
+			if (!bWasSuccessful && Data->ResultCode == EOS_EResult::EOS_Sessions_SessionAlreadyExists && !SessionId.IsEmpty())
+			{
+				// The backend still has the session of the process we are replacing, and ownership can't be taken over.
+				// It expires on its own, so we advertise under a new id rather than not at all. Restored players and state carry over
+				UE_LOG_ONLINE_SESSION(Warning, TEXT("Session (%s) id (%s) is still held on the backend, recreating it under a new id"), *SessionName.ToString(), *SessionId);
+				if (CreateEOSSession(HostingPlayerNum, Session) == ONLINE_IO_PENDING)
+				{
+					return;
+				}
+			}
+
 			if (bWasSuccessful)
 			{
 				TSharedPtr<FOnlineSessionInfoEOS> SessionInfo = StaticCastSharedPtr<FOnlineSessionInfoEOS>(Session->SessionInfo);
@@ -1645,6 +2912,20 @@ uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FName
 				BeginSessionAnalytics(Session);
 
 				RegisterLocalPlayers(Session);
+
+				// Sessions recreated from a snapshot get their players and started state back, nobody is waiting on these calls
+				FSessionState& SessionState = SessionStates.FindOrAdd(SessionName);
+				if (SessionState.RestoredPlayers.Num() > 0)
+				{
+					FPendingPlayerRegistrations& Registrations = PendingPlayerRegistrations.FindOrAdd(SessionName);
+					Registrations.PlayersToRegister.Append(SessionState.RestoredPlayers);
+					SessionState.RestoredPlayers.Empty();
+				}
+				if (SessionState.bRestoreStarted)
+				{
+					SessionState.bRestoreStarted = false;
+					StartEOSSession(Session);
+				}
 			}
 			else
 			{
@@ -1656,10 +2937,17 @@ uint32 FEOSWrapperSessionManager::CreateEOSSession(int32 HostingPlayerNum, FName
 			}
 		}
 
+		if (bRestored)
+		{
+			// The game never asked for this session, it learns about it through GetNamedSession rather than a create completion it didn't expect
+			UE_LOG_ONLINE_SESSION(Log, TEXT("Session (%s) %s from the snapshot"), *SessionName.ToString(), bWasSuccessful ? TEXT("recreated") : TEXT("could not be recreated"));
+			return;
+		}
+
 		TriggerOnCreateSessionCompleteDelegates(SessionName, bWasSuccessful);
 	};
 
-	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj);
+	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj, *StagedState);
 }
 
 struct FJoinSessionOptions : public TNamedSessionOptions<EOS_Sessions_JoinSessionOptions>
@@ -1778,13 +3066,25 @@ struct FSessionUpdateOptions : public TNamedSessionOptions<EOS_Sessions_UpdateSe
 	}
 };
 
-uint32 FEOSWrapperSessionManager::UpdateEOSSession(FNamedOnlineSession* Session)
+uint32 FEOSWrapperSessionManager::UpdateEOSSession(FNamedOnlineSession* Session, int32 NumCallers)
 {
 	if (Session->SessionState == EOnlineSessionState::Creating)
 	{
 		return ONLINE_IO_PENDING;
 	}
 
+	TSharedRef<FSessionAttributeState> StagedState = MakeShared<FSessionAttributeState>();
+	MakeSessionAttributeState(Session, *StagedState);
+
+	const FSessionAttributeState* CommittedState = FindCommittedSessionState(Session->SessionName);
+	if (CommittedState && CommittedState->Equals(*StagedState))
+	{
+		// Nothing changed since the last acknowledged update, so there is nothing to send
+		UE_LOG_ONLINE_SESSION(Verbose, TEXT("Session (%s) unchanged, skipping EOS_Sessions_UpdateSession()"), *Session->SessionName.ToString());
+		INC_DWORD_STAT(STAT_EOSWrapper_SessionUpdatesSkipped);
+		return ONLINE_SUCCESS;
+	}
+
 	EOS_HSessionModification SessionModHandle = NULL;
 	FSessionUpdateOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
 
@@ -1796,12 +3096,13 @@ uint32 FEOSWrapperSessionManager::UpdateEOSSession(FNamedOnlineSession* Session)
 	}
 
 	FUpdateSessionCallback* CallbackObj = new FUpdateSessionCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	CallbackObj->CallbackLambda = [this, SessionName = Session->SessionName](const EOS_Sessions_UpdateSessionCallbackInfo* Data) {
+	CallbackObj->CallbackLambda = [this, SessionName = Session->SessionName, StagedState, NumCallers](const EOS_Sessions_UpdateSessionCallbackInfo* Data) {
 		bool bWasSuccessful = false;
 
 		if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
 		{
 			bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
+			CommitSessionAttributeState(SessionName, *StagedState, bWasSuccessful);
 			if (!bWasSuccessful)
 			{
 				Session->SessionState = EOnlineSessionState::NoSession;
@@ -1813,10 +3114,10 @@ uint32 FEOSWrapperSessionManager::UpdateEOSSession(FNamedOnlineSession* Session)
 			UE_LOG_ONLINE_SESSION(Verbose, TEXT("Session [%s] not found"), *SessionName.ToString());
 		}
 
-		TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+		CompleteSessionUpdate(SessionName, bWasSuccessful, NumCallers);
 	};
 
-	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj);
+	return SharedSessionUpdate(SessionModHandle, Session, CallbackObj, *StagedState);
 }
 
 struct FSessionEndOptions : public TNamedSessionOptions<EOS_Sessions_EndSessionOptions>
@@ -1875,7 +3176,7 @@ uint32 FEOSWrapperSessionManager::DestroyEOSSession(FNamedOnlineSession* Session
 	FSessionDestroyOptions Options(TCHAR_TO_UTF8(*Session->SessionName.ToString()));
 	FDestroySessionCallback* CallbackObj = new FDestroySessionCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
 	CallbackObj->CallbackLambda = [this, SessionName = Session->SessionName](const EOS_Sessions_DestroySessionCallbackInfo* Data) {
-		EndSessionAnalytics();
+		EndSessionAnalytics(SessionName);
 
 		bool bWasSuccessful = false;
 		if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
@@ -1905,6 +3206,18 @@ uint32 FEOSWrapperSessionManager::DestroyEOSSession(FNamedOnlineSession* Session
 typedef TEOSCallback<EOS_SessionSearch_OnFindCallback, EOS_SessionSearch_FindCallbackInfo, FEOSWrapperSessionManager> FFindSessionsCallback;
 
 uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	return StartEOSSessionSearch(SearchingPlayerNum, SearchSettings,
+		FOnSingleSessionResultCompleteDelegate::CreateLambda([this, SearchSettings](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) {
+			if (bWasSuccessful)
+			{
+				RankCompletedSearch(*SearchSettings);
+			}
+			TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+		}));
+}
+
+uint32 FEOSWrapperSessionManager::StartEOSSessionSearch(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
 {
 	EOS_HSessionSearch SearchHandle = nullptr;
 	EOS_Sessions_CreateSessionSearchOptions HandleOptions = {};
@@ -1917,8 +3230,8 @@ uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const
 		UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_Sessions_CreateSessionSearch() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
 		return ONLINE_FAIL;
 	}
-	// Store our search handle for use/cleanup later
-	CurrentSearchHandle = MakeShareable(new FSessionSearchEOS(SearchHandle));
+	// Owned by this search, so searches running side by side don't read each other's results
+	TSharedRef<FSessionSearchEOS> SessionSearch = MakeShared<FSessionSearchEOS>(SearchHandle);
 
 	FAttributeOptions Opt1("NumPublicConnections", 1);
 	AddSearchAttribute(SearchHandle, &Opt1, EOS_EOnlineComparisonOp::EOS_OCO_GREATERTHANOREQUAL);
@@ -1932,7 +3245,7 @@ uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const
 		const FName Key = It.Key();
 		const FOnlineSessionSearchParam& SearchParam = It.Value();
 
-		if (!IsSessionSettingTypeSupported(SearchParam.Data.GetType()))
+		if (IsClientSideSearchParam(Key) || !IsSessionSettingTypeSupported(SearchParam.Data.GetType()))
 		{
 			continue;
 		}
@@ -1940,19 +3253,19 @@ uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const
 #if UE_BUILD_DEBUG
 		UE_LOG_ONLINE_SESSION(Log, TEXT("Adding search param named (%s), (%s)"), *Key.ToString(), *SearchParam.ToString());
 #endif
-		FString ParamName(Key.ToString());
-		FAttributeOptions Attribute(TCHAR_TO_UTF8(*ParamName), SearchParam.Data);
+		FAttributeOptions Attribute(AttributeArena.Store(Key), SearchParam.Data, AttributeArena);
 		AddSearchAttribute(SearchHandle, &Attribute, ToEOSSearchOp(SearchParam.ComparisonOp));
 	}
+	AttributeArena.Reset();
 
 	FFindSessionsCallback* CallbackObj = new FFindSessionsCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	CallbackObj->CallbackLambda = [this, SearchSettings](const EOS_SessionSearch_FindCallbackInfo* Data) {
+	CallbackObj->CallbackLambda = [this, SearchingPlayerNum, SearchSettings, SessionSearch, CompletionDelegate](const EOS_SessionSearch_FindCallbackInfo* Data) {
 		bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
 		if (bWasSuccessful)
 		{
 			EOS_SessionSearch_GetSearchResultCountOptions SearchResultOptions = {};
 			SearchResultOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
-			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(CurrentSearchHandle->SearchHandle, &SearchResultOptions);
+			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(SessionSearch->SearchHandle, &SearchResultOptions);
 
 			EOS_SessionSearch_CopySearchResultByIndexOptions IndexOptions = {};
 			IndexOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
@@ -1960,7 +3273,7 @@ uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const
 			{
 				EOS_HSessionDetails SessionHandle = nullptr;
 				IndexOptions.SessionIndex = Index;
-				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(CurrentSearchHandle->SearchHandle, &IndexOptions, &SessionHandle);
+				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(SessionSearch->SearchHandle, &IndexOptions, &SessionHandle);
 				if (Result == EOS_EResult::EOS_Success)
 				{
 					AddSearchResult(SessionHandle, SearchSettings);
@@ -1973,7 +3286,7 @@ uint32 FEOSWrapperSessionManager::FindEOSSession(int32 SearchingPlayerNum, const
 			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
 			UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_SessionSearch_Find() failed with EOS result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 		}
-		TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+		CompletionDelegate.ExecuteIfBound(SearchingPlayerNum, bWasSuccessful, FOnlineSessionSearchResult());
 	};
 
 	SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
@@ -2041,11 +3354,11 @@ void FEOSWrapperSessionManager::FindEOSSessionById(int32 LocalUserNum, const FUn
 		return;
 	}
 
-	// Store our search handle for use/cleanup later
-	CurrentSearchHandle = MakeShareable(new FSessionSearchEOS(SearchHandle));
+	// Owned by this search, so searches running side by side don't read each other's results
+	TSharedRef<FSessionSearchEOS> SessionSearch = MakeShared<FSessionSearchEOS>(SearchHandle);
 
 	FFindSessionsCallback* CallbackObj = new FFindSessionsCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	CallbackObj->CallbackLambda = [this, LocalUserNum, OnComplete = FOnSingleSessionResultCompleteDelegate(CompletionDelegate)](const EOS_SessionSearch_FindCallbackInfo* Data) {
+	CallbackObj->CallbackLambda = [this, LocalUserNum, SessionSearch, OnComplete = FOnSingleSessionResultCompleteDelegate(CompletionDelegate)](const EOS_SessionSearch_FindCallbackInfo* Data) {
 		TSharedRef<FOnlineSessionSearch> LocalSessionSearch = MakeShareable(new FOnlineSessionSearch());
 		LocalSessionSearch->SearchState = EOnlineAsyncTaskState::InProgress;
 
@@ -2054,7 +3367,7 @@ void FEOSWrapperSessionManager::FindEOSSessionById(int32 LocalUserNum, const FUn
 		{
 			EOS_SessionSearch_GetSearchResultCountOptions SearchResultOptions = {};
 			SearchResultOptions.ApiVersion = EOS_SESSIONSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
-			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(CurrentSearchHandle->SearchHandle, &SearchResultOptions);
+			int32 NumSearchResults = EOS_SessionSearch_GetSearchResultCount(SessionSearch->SearchHandle, &SearchResultOptions);
 
 			EOS_SessionSearch_CopySearchResultByIndexOptions IndexOptions = {};
 			IndexOptions.ApiVersion = EOS_SESSIONSEARCH_COPYSEARCHRESULTBYINDEX_API_LATEST;
@@ -2062,7 +3375,7 @@ void FEOSWrapperSessionManager::FindEOSSessionById(int32 LocalUserNum, const FUn
 			{
 				EOS_HSessionDetails SessionHandle = nullptr;
 				IndexOptions.SessionIndex = Index;
-				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(CurrentSearchHandle->SearchHandle, &IndexOptions, &SessionHandle);
+				EOS_EResult Result = EOS_SessionSearch_CopySearchResultByIndex(SessionSearch->SearchHandle, &IndexOptions, &SessionHandle);
 				if (Result == EOS_EResult::EOS_Success)
 				{
 					AddSearchResult(SessionHandle, LocalSessionSearch);
@@ -2087,18 +3400,41 @@ void FEOSWrapperSessionManager::FindEOSSessionById(int32 LocalUserNum, const FUn
 	EOS_SessionSearch_Find(SearchHandle, &FindOptions, CallbackObj, CallbackObj->GetCallbackPtr());
 }
 
-uint32 FEOSWrapperSessionManager::SharedSessionUpdate(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session, FUpdateSessionCallback* Callback)
+uint32 FEOSWrapperSessionManager::SharedSessionUpdate(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session, FUpdateSessionCallback* Callback, const FSessionAttributeState& DesiredState)
 {
+	// Whatever EOS already acknowledged for this session stays out of the modification
+	const FSessionAttributeState* CommittedState = FindCommittedSessionState(Session->SessionName);
+	int32 NumAttributesSent = 0;
+
 	// Set joinability flags
-	SetPermissionLevel(SessionModHandle, Session);
+	if (!CommittedState || CommittedState->PermissionLevel != DesiredState.PermissionLevel)
+	{
+		SetPermissionLevel(SessionModHandle, Session);
+		NumAttributesSent++;
+	}
 	// Set max players
-	SetMaxPlayers(SessionModHandle, Session);
+	if (!CommittedState || CommittedState->MaxPlayers != DesiredState.MaxPlayers)
+	{
+		SetMaxPlayers(SessionModHandle, Session);
+		NumAttributesSent++;
+	}
 	// Set invite flags
-	SetInvitesAllowed(SessionModHandle, Session);
+	if (!CommittedState || CommittedState->bInvitesAllowed != DesiredState.bInvitesAllowed)
+	{
+		SetInvitesAllowed(SessionModHandle, Session);
+		NumAttributesSent++;
+	}
 	// Set JIP flag
-	SetJoinInProgress(SessionModHandle, Session);
+	if (!CommittedState || CommittedState->bAllowJoinInProgress != DesiredState.bAllowJoinInProgress)
+	{
+		SetJoinInProgress(SessionModHandle, Session);
+		NumAttributesSent++;
+	}
 	// Add any attributes for filtering by searchers
-	SetAttributes(SessionModHandle, Session);
+	NumAttributesSent += SetAttributes(SessionModHandle, DesiredState, CommittedState);
+
+	UE_LOG_ONLINE_SESSION(Verbose, TEXT("Session (%s) update sends (%d) changed attributes"), *Session->SessionName.ToString(), NumAttributesSent);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_SessionAttributesSent, NumAttributesSent);
 
 	// Commit the session changes
 	EOS_Sessions_UpdateSessionOptions CreateOptions = {};
@@ -2114,41 +3450,56 @@ uint32 FEOSWrapperSessionManager::SharedSessionUpdate(EOS_HSessionModification S
 FNamedOnlineSession* FEOSWrapperSessionManager::GetNamedSession(FName SessionName)
 {
 	FScopeLock ScopeLock(&LobbyLock);
-	for (int32 SearchIndex = 0; SearchIndex < LobbySessions.Num(); SearchIndex++)
-	{
-		if (LobbySessions[SearchIndex].SessionName == SessionName)
-		{
-			return &LobbySessions[SearchIndex];
-		}
-	}
-	return nullptr;
+	const int32* SessionIndex = SessionIndexByName.Find(SessionName);
+	return SessionIndex ? &LobbySessions[*SessionIndex] : nullptr;
 }
 
 void FEOSWrapperSessionManager::RemoveNamedSession(FName SessionName)
 {
 	FScopeLock ScopeLock(&LobbyLock);
-	for (int32 SearchIndex = 0; SearchIndex < LobbySessions.Num(); SearchIndex++)
+	int32 SessionIndex = INDEX_NONE;
+	if (!SessionIndexByName.RemoveAndCopyValue(SessionName, SessionIndex))
 	{
-		if (LobbySessions[SearchIndex].SessionName == SessionName)
-		{
-			LobbySessions.RemoveAtSwap(SearchIndex);
-			return;
-		}
+		return;
+	}
+
+	LobbySessions.RemoveAtSwap(SessionIndex);
+	if (LobbySessions.IsValidIndex(SessionIndex))
+	{
+		// The last session took the freed slot
+		SessionIndexByName.Add(LobbySessions[SessionIndex].SessionName, SessionIndex);
+	}
+
+	// Sessions that never got to end their metrics session do it here, so the shared player session doesn't stay open
+	EndSessionAnalytics(SessionName);
+	SessionStates.Remove(SessionName);
+	SET_DWORD_STAT(STAT_EOSWrapper_NamedSessions, LobbySessions.Num());
+
+	// Without this a server that exits before the next interval would bring the removed session back on restart
+	SaveSessionSnapshot();
+
+	// Registrations still queued for this session must not leak into a new session created under the same name, their callers are failed instead
+	FPendingPlayerRegistrations Registrations;
+	if (PendingPlayerRegistrations.RemoveAndCopyValue(SessionName, Registrations) && (Registrations.RegisterCallers.Num() > 0 || Registrations.UnregisterCallers.Num() > 0))
+	{
+		EOSSubsystem->ExecuteNextTick([this, SessionName, Registrations = MoveTemp(Registrations)]() {
+			for (const TArray<FUniqueNetIdRef>& UnregisteredPlayers : Registrations.UnregisterCallers)
+			{
+				TriggerOnUnregisterPlayersCompleteDelegates(SessionName, UnregisteredPlayers, false);
+			}
+			for (const TArray<FUniqueNetIdRef>& RegisteredPlayers : Registrations.RegisterCallers)
+			{
+				TriggerOnRegisterPlayersCompleteDelegates(SessionName, RegisteredPlayers, false);
+			}
+		});
 	}
 }
 
 EOnlineSessionState::Type FEOSWrapperSessionManager::GetSessionState(FName SessionName) const
 {
 	FScopeLock ScopeLock(&LobbyLock);
-	for (int32 SearchIndex = 0; SearchIndex < LobbySessions.Num(); SearchIndex++)
-	{
-		if (LobbySessions[SearchIndex].SessionName == SessionName)
-		{
-			return LobbySessions[SearchIndex].SessionState;
-		}
-	}
-
-	return EOnlineSessionState::NoSession;
+	const int32* SessionIndex = SessionIndexByName.Find(SessionName);
+	return SessionIndex ? LobbySessions[*SessionIndex].SessionState : EOnlineSessionState::NoSession;
 }
 
 bool FEOSWrapperSessionManager::HasPresenceSession()
@@ -2168,12 +3519,16 @@ bool FEOSWrapperSessionManager::HasPresenceSession()
 FNamedOnlineSession* FEOSWrapperSessionManager::AddNamedSession(FName SessionName, const FOnlineSessionSettings& SessionSettings)
 {
 	FScopeLock ScopeLock(&LobbyLock);
+	SessionIndexByName.Add(SessionName, LobbySessions.Num());
+	SET_DWORD_STAT(STAT_EOSWrapper_NamedSessions, LobbySessions.Num() + 1);
 	return new (LobbySessions) FNamedOnlineSession(SessionName, SessionSettings);
 }
 
 FNamedOnlineSession* FEOSWrapperSessionManager::AddNamedSession(FName SessionName, const FOnlineSession& Session)
 {
 	FScopeLock ScopeLock(&LobbyLock);
+	SessionIndexByName.Add(SessionName, LobbySessions.Num());
+	SET_DWORD_STAT(STAT_EOSWrapper_NamedSessions, LobbySessions.Num() + 1);
 	return new (LobbySessions) FNamedOnlineSession(SessionName, Session);
 }
 
@@ -2215,35 +3570,167 @@ void FEOSWrapperSessionManager::RegisterLobbyNotifications()
 		OnMemberStatusReceived(Data->LobbyId, Data->TargetUserId, Data->CurrentStatus);
 	};
 
-	LobbyMemberStatusReceivedId = EOS_Lobby_AddNotifyLobbyMemberStatusReceived(
-		LobbyHandle, &AddNotifyLobbyMemberStatusReceivedOptions, LobbyMemberStatusReceivedCallbackObj, LobbyMemberStatusReceivedCallbackObj->GetCallbackPtr());
+	LobbyMemberStatusReceivedId = EOS_Lobby_AddNotifyLobbyMemberStatusReceived(
+		LobbyHandle, &AddNotifyLobbyMemberStatusReceivedOptions, LobbyMemberStatusReceivedCallbackObj, LobbyMemberStatusReceivedCallbackObj->GetCallbackPtr());
+
+	// LobbyInviteReceived we can skip, since it will pop up as system UI
+
+	// Accepted lobby invite notifications
+	EOS_Lobby_AddNotifyLobbyInviteAcceptedOptions AddNotifyLobbyInviteAcceptedOptions = {0};
+	AddNotifyLobbyInviteAcceptedOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYLOBBYINVITEACCEPTED_API_LATEST;
+
+	FLobbyInviteAcceptedCallback* LobbyInviteAcceptedCallbackObj = new FLobbyInviteAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
+	LobbyInviteAcceptedCallback = LobbyInviteAcceptedCallbackObj;
+	LobbyInviteAcceptedCallbackObj->CallbackLambda = [this](const EOS_Lobby_LobbyInviteAcceptedCallbackInfo* Data) { OnLobbyInviteAccepted(Data->InviteId, Data->LocalUserId, Data->TargetUserId); };
+
+	LobbyInviteAcceptedId = EOS_Lobby_AddNotifyLobbyInviteAccepted(LobbyHandle, &AddNotifyLobbyInviteAcceptedOptions, LobbyInviteAcceptedCallbackObj, LobbyInviteAcceptedCallbackObj->GetCallbackPtr());
+
+	// Accepted lobby join notifications
+	EOS_Lobby_AddNotifyJoinLobbyAcceptedOptions AddNotifyJoinLobbyAcceptedOptions = {0};
+	AddNotifyJoinLobbyAcceptedOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYJOINLOBBYACCEPTED_API_LATEST;
+
+	FJoinLobbyAcceptedCallback* JoinLobbyAcceptedCallbackObj = new FJoinLobbyAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
+	JoinLobbyAcceptedCallback = JoinLobbyAcceptedCallbackObj;
+	JoinLobbyAcceptedCallbackObj->CallbackLambda = [this](const EOS_Lobby_JoinLobbyAcceptedCallbackInfo* Data) { OnJoinLobbyAccepted(Data->LocalUserId, Data->UiEventId); };
+
+	JoinLobbyAcceptedId = EOS_Lobby_AddNotifyJoinLobbyAccepted(LobbyHandle, &AddNotifyJoinLobbyAcceptedOptions, JoinLobbyAcceptedCallbackObj, JoinLobbyAcceptedCallbackObj->GetCallbackPtr());
+}
+
+void FEOSWrapperSessionManager::RegisterLocalPlayers(FNamedOnlineSession* Session) {}
+
+uint32 FEOSWrapperSessionManager::FindLobbySession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+{
+	// When starting a new search, we'll reset the cache
+	LobbySearchResultsCache.Reset();
+
+	return StartLobbySessionSearch(SearchingPlayerNum, SearchSettings,
+		FOnSingleSessionResultCompleteDelegate::CreateLambda([this, SearchSettings](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) {
+			if (bWasSuccessful)
+			{
+				RankCompletedSearch(*SearchSettings);
+			}
+			TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
+		}));
+}
+
+uint32 FEOSWrapperSessionManager::StartPartitionedSearch(const TSharedRef<FPartitionedSearch>& PartitionedSearch)
+{
+	PartitionedSearch->StartTimeInSeconds = FPlatformTime::Seconds();
+	PartitionedSearch->SearchSettings->SearchState = EOnlineAsyncTaskState::InProgress;
+	if (PartitionedSearch->bLobbies)
+	{
+		// When starting a new search, we'll reset the cache
+		LobbySearchResultsCache.Reset();
+	}
+
+	StartSearchPartitions(PartitionedSearch);
+	PartitionedSearch->bStarted = true;
+
+	if (PartitionedSearch->NumInFlight == 0)
+	{
+		PartitionedSearch->SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
+		return ONLINE_FAIL;
+	}
+	return ONLINE_IO_PENDING;
+}
+
+void FEOSWrapperSessionManager::StartSearchPartitions(const TSharedRef<FPartitionedSearch>& PartitionedSearch)
+{
+	FOnlineSessionSearch& SearchSettings = *PartitionedSearch->SearchSettings;
+
+	// Stop asking for more pages once we have as many results as wanted, or the search was cancelled
+	const bool bWantsMore = SearchSettings.SearchState == EOnlineAsyncTaskState::InProgress && SearchSettings.SearchResults.Num() < SearchSettings.MaxSearchResults;
+	while (bWantsMore && PartitionedSearch->NumInFlight < PartitionedSearchMaxParallelSearches && PartitionedSearch->NextPartitionIndex < PartitionedSearch->PartitionValues.Num())
+	{
+		// Every partition is a regular search narrowed down to one value of the partition key
+		TSharedRef<FOnlineSessionSearch> Page = MakeShared<FOnlineSessionSearch>();
+		Page->QuerySettings = SearchSettings.QuerySettings;
+		Page->QuerySettings.SearchParams.Add(PartitionedSearch->PartitionKey, FOnlineSessionSearchParam(PartitionedSearch->PartitionValues[PartitionedSearch->NextPartitionIndex++], EOnlineComparisonOp::Equals));
+		Page->MaxSearchResults = EOS_SESSIONS_MAX_SEARCH_RESULTS;
+		Page->TimeoutInSeconds = SearchSettings.TimeoutInSeconds;
+
+		const FOnSingleSessionResultCompleteDelegate OnPageComplete = FOnSingleSessionResultCompleteDelegate::CreateLambda(
+			[this, PartitionedSearch, Page](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) {
+				PartitionedSearch->NumInFlight--;
+				if (bWasSuccessful)
+				{
+					PartitionedSearch->NumPagesFetched++;
+					INC_DWORD_STAT(STAT_EOSWrapper_SearchPagesFetched);
+
+					TArray<FOnlineSessionSearchResult>& SearchResults = PartitionedSearch->SearchSettings->SearchResults;
+					for (FOnlineSessionSearchResult& SearchResult : Page->SearchResults)
+					{
+						// Sessions advertising several values of the key show up in more than one partition
+						bool bAlreadyFound = false;
+						PartitionedSearch->FoundSessionIds.Add(SearchResult.GetSessionIdStr(), &bAlreadyFound);
+						if (!bAlreadyFound)
+						{
+							SearchResults.Add(MoveTemp(SearchResult));
+						}
+					}
+				}
+				else
+				{
+					PartitionedSearch->NumPagesFailed++;
+				}
+
+				StartSearchPartitions(PartitionedSearch);
+			});
 
-	// LobbyInviteReceived we can skip, since it will pop up as system UI
+		const uint32 Result = PartitionedSearch->bLobbies ? StartLobbySessionSearch(PartitionedSearch->SearchingPlayerNum, Page, OnPageComplete)
+														  : StartEOSSessionSearch(PartitionedSearch->SearchingPlayerNum, Page, OnPageComplete);
+		if (Result == ONLINE_IO_PENDING)
+		{
+			PartitionedSearch->NumInFlight++;
+		}
+		else
+		{
+			PartitionedSearch->NumPagesFailed++;
+		}
+	}
 
-	// Accepted lobby invite notifications
-	EOS_Lobby_AddNotifyLobbyInviteAcceptedOptions AddNotifyLobbyInviteAcceptedOptions = {0};
-	AddNotifyLobbyInviteAcceptedOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYLOBBYINVITEACCEPTED_API_LATEST;
+	if (PartitionedSearch->bStarted && PartitionedSearch->NumInFlight == 0)
+	{
+		CompletePartitionedSearch(PartitionedSearch);
+	}
+}
 
-	FLobbyInviteAcceptedCallback* LobbyInviteAcceptedCallbackObj = new FLobbyInviteAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	LobbyInviteAcceptedCallback = LobbyInviteAcceptedCallbackObj;
-	LobbyInviteAcceptedCallbackObj->CallbackLambda = [this](const EOS_Lobby_LobbyInviteAcceptedCallbackInfo* Data) { OnLobbyInviteAccepted(Data->InviteId, Data->LocalUserId, Data->TargetUserId); };
+void FEOSWrapperSessionManager::CompletePartitionedSearch(const TSharedRef<FPartitionedSearch>& PartitionedSearch)
+{
+	FOnlineSessionSearch& SearchSettings = *PartitionedSearch->SearchSettings;
+	if (SearchSettings.SearchState != EOnlineAsyncTaskState::InProgress)
+	{
+		// Cancelled, CancelFindSessions already reported it
+		return;
+	}
 
-	LobbyInviteAcceptedId = EOS_Lobby_AddNotifyLobbyInviteAccepted(LobbyHandle, &AddNotifyLobbyInviteAcceptedOptions, LobbyInviteAcceptedCallbackObj, LobbyInviteAcceptedCallbackObj->GetCallbackPtr());
+	const bool bWasSuccessful = PartitionedSearch->NumPagesFetched > 0;
+	if (SearchSettings.SearchResults.Num() > SearchSettings.MaxSearchResults)
+	{
+		SearchSettings.SearchResults.SetNum(SearchSettings.MaxSearchResults);
+	}
+	if (bWasSuccessful)
+	{
+		RankCompletedSearch(SearchSettings);
+	}
+	SearchSettings.SearchState = bWasSuccessful ? EOnlineAsyncTaskState::Done : EOnlineAsyncTaskState::Failed;
 
-	// Accepted lobby join notifications
-	EOS_Lobby_AddNotifyJoinLobbyAcceptedOptions AddNotifyJoinLobbyAcceptedOptions = {0};
-	AddNotifyJoinLobbyAcceptedOptions.ApiVersion = EOS_LOBBY_ADDNOTIFYJOINLOBBYACCEPTED_API_LATEST;
+	const double TimeToCompleteInSeconds = FPlatformTime::Seconds() - PartitionedSearch->StartTimeInSeconds;
+	LastPartitionedSearchMetrics.NumPartitions = PartitionedSearch->PartitionValues.Num();
+	LastPartitionedSearchMetrics.NumPagesFetched = PartitionedSearch->NumPagesFetched;
+	LastPartitionedSearchMetrics.NumPagesFailed = PartitionedSearch->NumPagesFailed;
+	LastPartitionedSearchMetrics.NumResults = SearchSettings.SearchResults.Num();
+	LastPartitionedSearchMetrics.TimeToCompleteInSeconds = TimeToCompleteInSeconds;
+	SET_FLOAT_STAT(STAT_EOSWrapper_PartitionedSearchTimeMs, (float)(TimeToCompleteInSeconds * 1000.0));
 
-	FJoinLobbyAcceptedCallback* JoinLobbyAcceptedCallbackObj = new FJoinLobbyAcceptedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	JoinLobbyAcceptedCallback = JoinLobbyAcceptedCallbackObj;
-	JoinLobbyAcceptedCallbackObj->CallbackLambda = [this](const EOS_Lobby_JoinLobbyAcceptedCallbackInfo* Data) { OnJoinLobbyAccepted(Data->LocalUserId, Data->UiEventId); };
+	UE_LOG_ONLINE_SESSION(Log, TEXT("[FOnlineSessionEOS::CompletePartitionedSearch] %d results from %d pages (%d failed) over %d partitions of %s in %.1f ms"), SearchSettings.SearchResults.Num(),
+		PartitionedSearch->NumPagesFetched, PartitionedSearch->NumPagesFailed, PartitionedSearch->PartitionValues.Num(), *PartitionedSearch->PartitionKey.ToString(), TimeToCompleteInSeconds * 1000.0);
 
-	JoinLobbyAcceptedId = EOS_Lobby_AddNotifyJoinLobbyAccepted(LobbyHandle, &AddNotifyJoinLobbyAcceptedOptions, JoinLobbyAcceptedCallbackObj, JoinLobbyAcceptedCallbackObj->GetCallbackPtr());
+	TriggerOnFindSessionsCompleteDelegates(bWasSuccessful);
 }
 
-void FEOSWrapperSessionManager::RegisterLocalPlayers(FNamedOnlineSession* Session) {}
-
-uint32 FEOSWrapperSessionManager::FindLobbySession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings)
+uint32 FEOSWrapperSessionManager::StartLobbySessionSearch(
+	int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
 {
 	uint32 Result = ONLINE_FAIL;
 
@@ -2262,27 +3749,25 @@ uint32 FEOSWrapperSessionManager::FindLobbySession(int32 SearchingPlayerNum, con
 			const FName Key = It.Key();
 			const FOnlineSessionSearchParam& SearchParam = It.Value();
 
-			if (!IsSessionSettingTypeSupported(SearchParam.Data.GetType()))
+			if (IsClientSideSearchParam(Key) || !IsSessionSettingTypeSupported(SearchParam.Data.GetType()))
 			{
 				continue;
 			}
 
-			UE_LOG_ONLINE_SESSION(VeryVerbose, TEXT("[FOnlineSessionEOS::FindLobbySession] Adding lobby search param named (%s), (%s)"), *Key.ToString(), *SearchParam.ToString());
+			UE_LOG_ONLINE_SESSION(VeryVerbose, TEXT("[FOnlineSessionEOS::StartLobbySessionSearch] Adding lobby search param named (%s), (%s)"), *Key.ToString(), *SearchParam.ToString());
 
-			FString ParamName(Key.ToString());
-			FLobbyAttributeOptions Attribute(TCHAR_TO_UTF8(*ParamName), SearchParam.Data);
+			FLobbyAttributeOptions Attribute(AttributeArena.Store(Key), SearchParam.Data, AttributeArena);
 			AddLobbySearchAttribute(LobbySearchHandle, &Attribute, ToEOSSearchOp(SearchParam.ComparisonOp));
 		}
+		AttributeArena.Reset();
 
-		StartLobbySearch(SearchingPlayerNum, LobbySearchHandle, SearchSettings,
-			FOnSingleSessionResultCompleteDelegate::CreateLambda(
-				[this](int32 LocalUserNum, bool bWasSuccessful, const FOnlineSessionSearchResult& EOSResult) { TriggerOnFindSessionsCompleteDelegates(bWasSuccessful); }));
+		StartLobbySearch(SearchingPlayerNum, LobbySearchHandle, SearchSettings, CompletionDelegate);
 
 		Result = ONLINE_IO_PENDING;
 	}
 	else
 	{
-		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::FindLobbySession] CreateLobbySearch not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(SearchResult)));
+		UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::StartLobbySessionSearch] CreateLobbySearch not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(SearchResult)));
 	}
 
 	return Result;
@@ -2291,23 +3776,29 @@ uint32 FEOSWrapperSessionManager::FindLobbySession(int32 SearchingPlayerNum, con
 void FEOSWrapperSessionManager::StartLobbySearch(
 	int32 SearchingPlayerNum, EOS_HLobbySearch LobbySearchHandle, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate)
 {
-	// When starting a new search, we'll reset the cache
-	LobbySearchResultsCache.Reset();
-
-	SessionSearchStartInSeconds = FPlatformTime::Seconds();
+	const double SearchStartInSeconds = FPlatformTime::Seconds();
 
 	EOS_LobbySearch_FindOptions FindOptions = {0};
 	FindOptions.ApiVersion = EOS_LOBBYSEARCH_FIND_API_LATEST;
 	FindOptions.LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(SearchingPlayerNum);
 
 	FLobbySearchFindCallback* CallbackObj = new FLobbySearchFindCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	LobbySearchFindCallback = CallbackObj;
-	CallbackObj->CallbackLambda = [this, SearchingPlayerNum, LobbySearchHandle, SearchSettings, CompletionDelegate](const EOS_LobbySearch_FindCallbackInfo* Data) {
+	CallbackObj->CallbackLambda = [this, SearchingPlayerNum, LobbySearchHandle, SearchSettings, CompletionDelegate, SearchStartInSeconds](const EOS_LobbySearch_FindCallbackInfo* Data) {
 		if (Data->ResultCode == EOS_EResult::EOS_Success)
 		{
 			UE_LOG_ONLINE_SESSION(Log, TEXT("[FOnlineSessionEOS::StartLobbySearch] LobbySearch_Find was successful."));
 
-			CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Done;
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Done;
+
+			// Tracked per search, several lobby searches can be copying their results at the same time.
+			// The enumeration below holds one count of its own, so results copied synchronously can't complete the search early
+			TSharedRef<int32> NumPendingLobbySearchResults = MakeShared<int32>(1);
+			auto CompleteIfLastPending = [CompletionDelegate, SearchingPlayerNum, SearchSettings, NumPendingLobbySearchResults]() {
+				if (--(*NumPendingLobbySearchResults) == 0)
+				{
+					CompletionDelegate.ExecuteIfBound(SearchingPlayerNum, true, SearchSettings->SearchResults.Num() > 0 ? SearchSettings->SearchResults.Last() : FOnlineSessionSearchResult());
+				}
+			};
 
 			EOS_LobbySearch_GetSearchResultCountOptions GetSearchResultCountOptions = {0};
 			GetSearchResultCountOptions.ApiVersion = EOS_LOBBYSEARCH_GETSEARCHRESULTCOUNT_API_LATEST;
@@ -2332,16 +3823,10 @@ void FEOSWrapperSessionManager::StartLobbySearch(
 
 						UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FOnlineSessionEOS::StartLobbySearch::FLobbySearchFindCallback] LobbySearch_CopySearchResultByIndex was successful."));
 
-						PendingLobbySearchResults.Add(LobbyDetails);
+						++(*NumPendingLobbySearchResults);
 
-						AddLobbySearchResult(LobbyDetails, SearchSettings, [this, LobbyDetails, CompletionDelegate, SearchingPlayerNum, SearchSettings](bool bWasSuccessful) {
-							PendingLobbySearchResults.Remove(LobbyDetails);
-
-							if (PendingLobbySearchResults.IsEmpty())
-							{
-								// If we fail to copy the lobby data, we won't add a new search result, so we'll return an empty one
-								CompletionDelegate.ExecuteIfBound(SearchingPlayerNum, bWasSuccessful, bWasSuccessful ? SearchSettings->SearchResults.Last() : FOnlineSessionSearchResult());
-							}
+						AddLobbySearchResult(LobbyDetails, SearchSettings, SearchStartInSeconds, [CompleteIfLastPending](bool bWasSuccessful) {
+							CompleteIfLastPending();
 						});
 					}
 					else
@@ -2352,10 +3837,7 @@ void FEOSWrapperSessionManager::StartLobbySearch(
 					}
 				}
 
-				if (PendingLobbySearchResults.IsEmpty())
-				{
-					CompletionDelegate.ExecuteIfBound(SearchingPlayerNum, true, SearchSettings->SearchResults.Last());
-				}
+				CompleteIfLastPending();
 			}
 			else
 			{
@@ -2369,7 +3851,7 @@ void FEOSWrapperSessionManager::StartLobbySearch(
 			UE_LOG_ONLINE_SESSION(Warning, TEXT("[FOnlineSessionEOS::StartLobbySearch::FLobbySearchFindCallback] LobbySearch_Find not successful. Finished with EOS_EResult %s"),
 				ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 
-			CurrentSessionSearch->SearchState = EOnlineAsyncTaskState::Failed;
+			SearchSettings->SearchState = EOnlineAsyncTaskState::Failed;
 
 			CompletionDelegate.ExecuteIfBound(SearchingPlayerNum, false, FOnlineSessionSearchResult());
 		}
@@ -2420,7 +3902,6 @@ uint32 FEOSWrapperSessionManager::CreateLobbySession(int32 HostingPlayerNum, FNa
 
 	FName SessionName = Session->SessionName;
 	FLobbyCreatedCallback* CallbackObj = new FLobbyCreatedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	LobbyCreatedCallback = CallbackObj;
 	CallbackObj->CallbackLambda = [this, SessionName, LocalProductUserId, LocalUserNetId](const EOS_Lobby_CreateLobbyCallbackInfo* Data) {
 		FNamedOnlineSession* Session = GetNamedSession(SessionName);
 		if (Session)
@@ -2439,6 +3920,9 @@ uint32 FEOSWrapperSessionManager::CreateLobbySession(int32 HostingPlayerNum, FNa
 
 				Session->SessionInfo = MakeShareable(new FOnlineSessionInfoEOS(HostAddr, FUniqueNetIdEOSLobby::Create(Data->LobbyId), nullptr));
 
+				// A new lobby starts with nothing on the backend, so the first update sends everything
+				SessionStates.FindOrAdd(SessionName).CommittedState.Reset();
+
 				// #if WITH_EOS_RTC
 				// 				if (FEOSVoiceChatUser* VoiceChatUser = static_cast<FEOSVoiceChatUser*>(EOSSubsystem->GetEOSVoiceChatUserInterface(*LocalUserNetId)))
 				// 				{
@@ -2448,7 +3932,8 @@ uint32 FEOSWrapperSessionManager::CreateLobbySession(int32 HostingPlayerNum, FNa
 
 				BeginSessionAnalytics(Session);
 
-				UpdateLobbySession(Session);
+				// Pushes the settings along with anything queued while the lobby was being created
+				FlushSessionUpdate(SessionName);
 			}
 			else
 			{
@@ -2469,16 +3954,31 @@ uint32 FEOSWrapperSessionManager::CreateLobbySession(int32 HostingPlayerNum, FNa
 	return ONLINE_IO_PENDING;
 }
 
-uint32 FEOSWrapperSessionManager::UpdateLobbySession(FNamedOnlineSession* Session)
+uint32 FEOSWrapperSessionManager::UpdateLobbySession(FNamedOnlineSession* Session, int32 NumCallers)
 {
 	check(Session != nullptr);
 
 	uint32 Result = ONLINE_FAIL;
 
+	TSharedRef<FSessionAttributeState> StagedState = MakeShared<FSessionAttributeState>();
+	const FSessionAttributeState* CommittedState = nullptr;
+	if (Session->SessionState != EOnlineSessionState::Creating)
+	{
+		MakeLobbyAttributeState(Session, *StagedState);
+		CommittedState = FindCommittedSessionState(Session->SessionName);
+	}
+
 	if (Session->SessionState == EOnlineSessionState::Creating)
 	{
 		Result = ONLINE_IO_PENDING;
 	}
+	else if (CommittedState && CommittedState->Equals(*StagedState))
+	{
+		// Nothing changed since the last acknowledged update, so there is nothing to send
+		UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FEOSWrapperLobby::UpdateLobbySession] Lobby session (%s) unchanged, skipping UpdateLobby"), *Session->SessionName.ToString());
+		INC_DWORD_STAT(STAT_EOSWrapper_SessionUpdatesSkipped);
+		Result = ONLINE_SUCCESS;
+	}
 	else
 	{
 		EOS_Lobby_UpdateLobbyModificationOptions UpdateLobbyModificationOptions = {0};
@@ -2492,9 +3992,21 @@ uint32 FEOSWrapperSessionManager::UpdateLobbySession(FNamedOnlineSession* Sessio
 		EOS_EResult LobbyModificationResult = EOS_Lobby_UpdateLobbyModification(LobbyHandle, &UpdateLobbyModificationOptions, &LobbyModificationHandle);
 		if (LobbyModificationResult == EOS_EResult::EOS_Success)
 		{
-			SetLobbyPermissionLevel(LobbyModificationHandle, Session);
-			SetLobbyMaxMembers(LobbyModificationHandle, Session);
-			SetLobbyAttributes(LobbyModificationHandle, Session);
+			int32 NumAttributesSent = 0;
+			if (!CommittedState || CommittedState->PermissionLevel != StagedState->PermissionLevel)
+			{
+				SetLobbyPermissionLevel(LobbyModificationHandle, Session);
+				NumAttributesSent++;
+			}
+			if (!CommittedState || CommittedState->MaxPlayers != StagedState->MaxPlayers)
+			{
+				SetLobbyMaxMembers(LobbyModificationHandle, Session);
+				NumAttributesSent++;
+			}
+			NumAttributesSent += SetLobbyAttributes(LobbyModificationHandle, *StagedState, CommittedState);
+
+			UE_LOG_ONLINE_SESSION(Verbose, TEXT("[FEOSWrapperLobby::UpdateLobbySession] Lobby session (%s) update sends (%d) changed attributes"), *Session->SessionName.ToString(), NumAttributesSent);
+			INC_DWORD_STAT_BY(STAT_EOSWrapper_SessionAttributesSent, NumAttributesSent);
 
 			EOS_Lobby_UpdateLobbyOptions UpdateLobbyOptions = {0};
 			UpdateLobbyOptions.ApiVersion = EOS_LOBBY_UPDATELOBBY_API_LATEST;
@@ -2502,11 +4014,12 @@ uint32 FEOSWrapperSessionManager::UpdateLobbySession(FNamedOnlineSession* Sessio
 
 			FName SessionName = Session->SessionName;
 			FLobbyUpdatedCallback* CallbackObj = new FLobbyUpdatedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-			CallbackObj->CallbackLambda = [this, SessionName](const EOS_Lobby_UpdateLobbyCallbackInfo* Data) {
+			CallbackObj->CallbackLambda = [this, SessionName, StagedState, NumCallers](const EOS_Lobby_UpdateLobbyCallbackInfo* Data) {
 				FNamedOnlineSession* Session = GetNamedSession(SessionName);
 				if (Session)
 				{
 					bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success || Data->ResultCode == EOS_EResult::EOS_Sessions_OutOfSync;
+					CommitSessionAttributeState(SessionName, *StagedState, bWasSuccessful);
 					if (!bWasSuccessful)
 					{
 						Session->SessionState = EOnlineSessionState::NoSession;
@@ -2514,12 +4027,12 @@ uint32 FEOSWrapperSessionManager::UpdateLobbySession(FNamedOnlineSession* Sessio
 							Warning, TEXT("[FEOSWrapperLobby::UpdateLobbySession] UpdateLobby not successful. Finished with EOS_EResult %s"), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
 					}
 
-					TriggerOnUpdateSessionCompleteDelegates(SessionName, bWasSuccessful);
+					CompleteSessionUpdate(SessionName, bWasSuccessful, NumCallers);
 				}
 				else
 				{
 					UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSWrapperLobby::UpdateLobbySession] Unable to find session %s"), *SessionName.ToString());
-					TriggerOnUpdateSessionCompleteDelegates(SessionName, false);
+					CompleteSessionUpdate(SessionName, false, NumCallers);
 				}
 			};
 
@@ -2565,14 +4078,18 @@ uint32 FEOSWrapperSessionManager::JoinLobbySession(int32 PlayerNum, FNamedOnline
 			JoinLobbyOptions.LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(PlayerNum);
 			JoinLobbyOptions.bPresenceEnabled = Session->SessionSettings.bUsesPresence;
 
-			TSharedRef<FLobbyDetailsEOS> LobbyDetails = LobbySearchResultsCache[Session->SessionInfo->GetSessionId().ToString()];
-			JoinLobbyOptions.LobbyDetailsHandle = LobbyDetails->LobbyDetailsHandle;
+			const TSharedRef<FLobbyDetailsEOS>* LobbyDetails = LobbySearchResultsCache.Find(Session->SessionInfo->GetSessionId().ToString());
+			if (LobbyDetails == nullptr)
+			{
+				UE_LOG_ONLINE_SESSION(Warning, TEXT("[FEOSWrapperLobby::JoinLobbySession] Lobby %s is not a result of the last lobby search"), *Session->SessionInfo->GetSessionId().ToString());
+				return ONLINE_FAIL;
+			}
+			JoinLobbyOptions.LobbyDetailsHandle = (*LobbyDetails)->LobbyDetailsHandle;
 
 			FName SessionName = Session->SessionName;
 			FUniqueNetIdPtr LocalUserNetId = EOSSubsystem->UserManager->GetLocalUniqueNetIdEOS(PlayerNum);
 
 			FLobbyJoinedCallback* CallbackObj = new FLobbyJoinedCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-			LobbyJoinedCallback = CallbackObj;
 			CallbackObj->CallbackLambda = [this, SessionName, LocalUserNetId](const EOS_Lobby_JoinLobbyCallbackInfo* Data) {
 				FNamedOnlineSession* Session = GetNamedSession(SessionName);
 				if (Session)
@@ -2693,7 +4210,6 @@ uint32 FEOSWrapperSessionManager::DestroyLobbySession(FNamedOnlineSession* Sessi
 
 		FName SessionName = Session->SessionName;
 		FLobbyLeftCallback* LeaveCallbackObj = new FLobbyLeftCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-		LobbyLeftCallback = LeaveCallbackObj;
 		LeaveCallbackObj->CallbackLambda = [this, SessionName, CompletionDelegate](const EOS_Lobby_LeaveLobbyCallbackInfo* Data) {
 			FNamedOnlineSession* LobbySession = GetNamedSession(SessionName);
 			if (LobbySession)
@@ -2717,7 +4233,7 @@ uint32 FEOSWrapperSessionManager::DestroyLobbySession(FNamedOnlineSession* Sessi
 				// 				}
 				// #endif
 
-				EndSessionAnalytics();
+				EndSessionAnalytics(SessionName);
 
 				LobbySession->SessionState = EOnlineSessionState::NoSession;
 
@@ -2803,7 +4319,6 @@ bool FEOSWrapperSessionManager::SendLobbyInvite(FName SessionName, EOS_ProductUs
 	SendInviteOptions.TargetUserId = ReceiverId;
 
 	FLobbySendInviteCallback* CallbackObj = new FLobbySendInviteCallback(FEOSWrapperSessionManagerWeakPtr(AsShared()));
-	LobbySendInviteCallback = CallbackObj;
 	CallbackObj->CallbackLambda = [this](const EOS_Lobby_SendInviteCallbackInfo* Data) {
 		if (Data->ResultCode == EOS_EResult::EOS_Success)
 		{
@@ -2820,28 +4335,44 @@ bool FEOSWrapperSessionManager::SendLobbyInvite(FName SessionName, EOS_ProductUs
 	return true;
 }
 
-FNamedOnlineSession* FEOSWrapperSessionManager::GetNamedSessionFromLobbyId(const FUniqueNetIdEOSLobby& LobbyId)
+static bool IsSessionForLobbyId(const FNamedOnlineSession& Session, const FUniqueNetIdEOSLobby& LobbyId)
 {
-	FNamedOnlineSession* Result = nullptr;
+	if (Session.SessionInfo.IsValid())
+	{
+		FOnlineSessionInfoEOS* SessionInfo = (FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
+
+		// We'll check if the session is a Lobby session before comparing the ids
+		return !Session.SessionSettings.bIsLANMatch && Session.SessionSettings.bUseLobbiesIfAvailable && *SessionInfo->SessionId == LobbyId;
+	}
+	return false;
+}
 
+FNamedOnlineSession* FEOSWrapperSessionManager::GetNamedSessionFromLobbyId(const FUniqueNetIdEOSLobby& LobbyId)
+{
 	FScopeLock ScopeLock(&LobbyLock);
-	for (int32 SearchIndex = 0; SearchIndex < LobbySessions.Num(); SearchIndex++)
+
+	// Lobby notifications come in for every session we host, remember where each lobby lives instead of scanning them all every time
+	const FString LobbyIdStr = LobbyId.ToString();
+	if (const FName* SessionName = SessionNamesByLobbyId.Find(LobbyIdStr))
 	{
-		FNamedOnlineSession& Session = LobbySessions[SearchIndex];
-		if (Session.SessionInfo.IsValid())
+		const int32* SessionIndex = SessionIndexByName.Find(*SessionName);
+		if (SessionIndex && IsSessionForLobbyId(LobbySessions[*SessionIndex], LobbyId))
 		{
-			FOnlineSessionInfoEOS* SessionInfo = (FOnlineSessionInfoEOS*)Session.SessionInfo.Get();
+			return &LobbySessions[*SessionIndex];
+		}
+		SessionNamesByLobbyId.Remove(LobbyIdStr);
+	}
 
-			// We'll check if the session is a Lobby session before comparing the ids
-			if (!Session.SessionSettings.bIsLANMatch && Session.SessionSettings.bUseLobbiesIfAvailable && *SessionInfo->SessionId == LobbyId)
-			{
-				Result = &LobbySessions[SearchIndex];
-				break;
-			}
+	for (FNamedOnlineSession& Session : LobbySessions)
+	{
+		if (IsSessionForLobbyId(Session, LobbyId))
+		{
+			SessionNamesByLobbyId.Add(LobbyIdStr, Session.SessionName);
+			return &Session;
 		}
 	}
 
-	return Result;
+	return nullptr;
 }
 
 FOnlineSessionSearchResult* FEOSWrapperSessionManager::GetSearchResultFromLobbyId(const FUniqueNetIdEOSLobby& LobbyId)
@@ -2909,6 +4440,7 @@ bool FEOSWrapperSessionManager::AddOnlineSessionMember(FName SessionName, const
 			}
 
 			Session->SessionSettings.MemberSettings.Add(PlayerId, FSessionSettings());
+			EOSSubsystem->UserManager->RecordRecentPlayer(*PlayerId);
 			return true;
 		}
 	}
@@ -2936,6 +4468,7 @@ bool FEOSWrapperSessionManager::RemoveOnlineSessionMember(FName SessionName, con
 		}
 
 		Session->SessionSettings.MemberSettings.Remove(PlayerId);
+		EOSSubsystem->UserManager->RecordRecentPlayer(*PlayerId);
 
 		return true;
 	}
@@ -3030,6 +4563,169 @@ void FEOSWrapperSessionManager::CopySearchResult(EOS_HSessionDetails SessionHand
 	CopyAttributes(SessionHandle, OutSession);
 }
 
+/** FNV-1a over the raw UTF-8 attribute key. Usable in constant expressions so the well known keys below can be switch labels */
+static constexpr uint32 HashAttributeKey(const char* Key)
+{
+	uint32 Hash = 2166136261u;
+	while (*Key)
+	{
+		Hash = (Hash ^ uint32(uint8(*Key++))) * 16777619u;
+	}
+	return Hash;
+}
+
+/** Attributes written by SetAttributes/SetLobbyAttributes that map onto FOnlineSession fields instead of FSessionSettings entries */
+enum class EWellKnownSessionAttribute : uint8
+{
+	NumPublicConnections,
+	NumPrivateConnections,
+	OwningUserId,
+	OwningUserName,
+	bAntiCheatProtected,
+	bUsesStats,
+	bIsDedicated,
+	BuildUniqueId,
+	Unknown
+};
+
+static const char* const WellKnownSessionAttributeKeys[] = {
+	"NumPublicConnections", "NumPrivateConnections", "OwningUserId", "OwningUserName", "bAntiCheatProtected", "bUsesStats", "bIsDedicated", "BuildUniqueId",
+};
+
+static EWellKnownSessionAttribute FindWellKnownSessionAttribute(const char* Key)
+{
+	EWellKnownSessionAttribute Found;
+	// Duplicate case labels don't compile, so the hash is guaranteed to be perfect over this key set
+	switch (HashAttributeKey(Key))
+	{
+		case HashAttributeKey("NumPublicConnections"): Found = EWellKnownSessionAttribute::NumPublicConnections; break;
+		case HashAttributeKey("NumPrivateConnections"): Found = EWellKnownSessionAttribute::NumPrivateConnections; break;
+		case HashAttributeKey("OwningUserId"): Found = EWellKnownSessionAttribute::OwningUserId; break;
+		case HashAttributeKey("OwningUserName"): Found = EWellKnownSessionAttribute::OwningUserName; break;
+		case HashAttributeKey("bAntiCheatProtected"): Found = EWellKnownSessionAttribute::bAntiCheatProtected; break;
+		case HashAttributeKey("bUsesStats"): Found = EWellKnownSessionAttribute::bUsesStats; break;
+		case HashAttributeKey("bIsDedicated"): Found = EWellKnownSessionAttribute::bIsDedicated; break;
+		case HashAttributeKey("BuildUniqueId"): Found = EWellKnownSessionAttribute::BuildUniqueId; break;
+		default: return EWellKnownSessionAttribute::Unknown;
+	}
+	// A single compare rejects foreign keys that happen to share a hash
+	return FCStringAnsi::Strcmp(Key, WellKnownSessionAttributeKeys[(int32)Found]) == 0 ? Found : EWellKnownSessionAttribute::Unknown;
+}
+
+template <typename ValueType>
+static bool AssignIfChanged(ValueType& Target, const ValueType& Value)
+{
+	if (Target == Value)
+	{
+		return false;
+	}
+	Target = Value;
+	return true;
+}
+
+/** Works for both EOS_Sessions_AttributeData and EOS_Lobby_AttributeData since they share the same layout. Returns whether the session changed */
+template <typename AttributeDataType>
+static bool CopyWellKnownSessionAttribute(EWellKnownSessionAttribute Attribute, const AttributeDataType* Data, FOnlineSession& OutSession)
+{
+	switch (Attribute)
+	{
+		case EWellKnownSessionAttribute::NumPublicConnections:
+		{
+			// Adjust the public connections based upon this
+			return AssignIfChanged(OutSession.SessionSettings.NumPublicConnections, (int32)Data->Value.AsInt64);
+		}
+		case EWellKnownSessionAttribute::NumPrivateConnections:
+		{
+			// Adjust the private connections based upon this
+			return AssignIfChanged(OutSession.SessionSettings.NumPrivateConnections, (int32)Data->Value.AsInt64);
+		}
+		case EWellKnownSessionAttribute::OwningUserId:
+		{
+			// The registry hands out one instance per id, so comparing pointers is enough
+			const FUniqueNetIdPtr OwningUserId = FUniqueNetIdEOSRegistry::FindOrAdd(UTF8_TO_TCHAR(Data->Value.AsUtf8));
+			return AssignIfChanged(OutSession.OwningUserId, OwningUserId);
+		}
+		case EWellKnownSessionAttribute::OwningUserName:
+		{
+			return AssignIfChanged(OutSession.OwningUserName, FString(UTF8_TO_TCHAR(Data->Value.AsUtf8)));
+		}
+		case EWellKnownSessionAttribute::bAntiCheatProtected:
+		{
+			return AssignIfChanged(OutSession.SessionSettings.bAntiCheatProtected, Data->Value.AsBool == EOS_TRUE);
+		}
+		case EWellKnownSessionAttribute::bUsesStats:
+		{
+			return AssignIfChanged(OutSession.SessionSettings.bUsesStats, Data->Value.AsBool == EOS_TRUE);
+		}
+		case EWellKnownSessionAttribute::bIsDedicated:
+		{
+			return AssignIfChanged(OutSession.SessionSettings.bIsDedicated, Data->Value.AsBool == EOS_TRUE);
+		}
+		case EWellKnownSessionAttribute::BuildUniqueId:
+		{
+			return AssignIfChanged(OutSession.SessionSettings.BuildUniqueId, (int32)Data->Value.AsInt64);
+		}
+	}
+	return false;
+}
+
+template <typename AttributeDataType>
+static FOnlineSessionSetting MakeSessionSettingFromAttribute(const AttributeDataType* Data)
+{
+	FOnlineSessionSetting Setting;
+	switch (Data->ValueType)
+	{
+		case EOS_ESessionAttributeType::EOS_SAT_Boolean:
+		{
+			Setting.Data.SetValue(Data->Value.AsBool == EOS_TRUE);
+			break;
+		}
+		case EOS_ESessionAttributeType::EOS_SAT_Int64:
+		{
+			Setting.Data.SetValue(int64(Data->Value.AsInt64));
+			break;
+		}
+		case EOS_ESessionAttributeType::EOS_SAT_Double:
+		{
+			Setting.Data.SetValue(Data->Value.AsDouble);
+			break;
+		}
+		case EOS_ESessionAttributeType::EOS_SAT_String:
+		{
+			Setting.Data.SetValue(UTF8_TO_TCHAR(Data->Value.AsUtf8));
+			break;
+		}
+	}
+	return Setting;
+}
+
+/** Cached UTF-8 key to FName mapping for game defined attributes. Only touched from EOS callbacks on the game thread */
+struct FInternedAttributeKey
+{
+	TArray<ANSICHAR> Utf8Key;
+	FName Name;
+};
+static TMap<uint32, FInternedAttributeKey> InternedAttributeKeys;
+
+static FName InternAttributeKey(const char* Key)
+{
+	const uint32 KeyHash = HashAttributeKey(Key);
+	if (const FInternedAttributeKey* Interned = InternedAttributeKeys.Find(KeyHash))
+	{
+		if (FCStringAnsi::Strcmp(Interned->Utf8Key.GetData(), Key) == 0)
+		{
+			return Interned->Name;
+		}
+		// Hash collision with a different key, don't evict the cached one
+		return FName(UTF8_TO_TCHAR(Key));
+	}
+
+	FInternedAttributeKey& NewKey = InternedAttributeKeys.Add(KeyHash);
+	NewKey.Utf8Key.Append(Key, FCStringAnsi::Strlen(Key) + 1);
+	NewKey.Name = FName(UTF8_TO_TCHAR(Key));
+	return NewKey.Name;
+}
+
 void FEOSWrapperSessionManager::CopyAttributes(EOS_HSessionDetails SessionHandle, FOnlineSession& OutSession)
 {
 	EOS_SessionDetails_GetSessionAttributeCountOptions CountOptions = {};
@@ -3046,69 +4742,15 @@ void FEOSWrapperSessionManager::CopyAttributes(EOS_HSessionDetails SessionHandle
 		EOS_EResult ResultCode = EOS_SessionDetails_CopySessionAttributeByIndex(SessionHandle, &AttrOptions, &Attribute);
 		if (ResultCode == EOS_EResult::EOS_Success)
 		{
-			FString Key = Attribute->Data->Key;
-			if (Key == TEXT("NumPublicConnections"))
-			{
-				// Adjust the public connections based upon this
-				OutSession.SessionSettings.NumPublicConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("NumPrivateConnections"))
-			{
-				// Adjust the private connections based upon this
-				OutSession.SessionSettings.NumPrivateConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("OwningUserId"))
-			{
-				OutSession.OwningUserId = FUniqueNetIdEOSRegistry::FindOrAdd(UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-			}
-			else if (Key == TEXT("OwningUserName"))
-			{
-				OutSession.OwningUserName = UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8);
-			}
-			else if (Key == TEXT("bAntiCheatProtected"))
+			const EWellKnownSessionAttribute WellKnownAttribute = FindWellKnownSessionAttribute(Attribute->Data->Key);
+			if (WellKnownAttribute != EWellKnownSessionAttribute::Unknown)
 			{
-				OutSession.SessionSettings.bAntiCheatProtected = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bUsesStats"))
-			{
-				OutSession.SessionSettings.bUsesStats = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bIsDedicated"))
-			{
-				OutSession.SessionSettings.bIsDedicated = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("BuildUniqueId"))
-			{
-				OutSession.SessionSettings.BuildUniqueId = Attribute->Data->Value.AsInt64;
+				CopyWellKnownSessionAttribute(WellKnownAttribute, Attribute->Data, OutSession);
 			}
 			// Handle FOnlineSessionSetting settings
 			else
 			{
-				FOnlineSessionSetting Setting;
-				switch (Attribute->Data->ValueType)
-				{
-					case EOS_ESessionAttributeType::EOS_SAT_Boolean:
-					{
-						Setting.Data.SetValue(Attribute->Data->Value.AsBool == EOS_TRUE);
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_Int64:
-					{
-						Setting.Data.SetValue(int64(Attribute->Data->Value.AsInt64));
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_Double:
-					{
-						Setting.Data.SetValue(Attribute->Data->Value.AsDouble);
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_String:
-					{
-						Setting.Data.SetValue(UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-						break;
-					}
-				}
-				OutSession.SessionSettings.Settings.Add(FName(Key), Setting);
+				OutSession.SessionSettings.Settings.Add(InternAttributeKey(Attribute->Data->Key), MakeSessionSettingFromAttribute(Attribute->Data));
 			}
 		}
 
@@ -3116,22 +4758,24 @@ void FEOSWrapperSessionManager::CopyAttributes(EOS_HSessionDetails SessionHandle
 	}
 }
 
-void FEOSWrapperSessionManager::SetPermissionLevel(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session)
+static EOS_EOnlineSessionPermissionLevel GetSessionPermissionLevelFromSessionSettings(const FOnlineSessionSettings& SessionSettings)
 {
-	EOS_SessionModification_SetPermissionLevelOptions Options = {};
-	Options.ApiVersion = EOS_SESSIONMODIFICATION_SETPERMISSIONLEVEL_API_LATEST;
-	if (Session->SessionSettings.NumPublicConnections > 0)
-	{
-		Options.PermissionLevel = EOS_EOnlineSessionPermissionLevel::EOS_OSPF_PublicAdvertised;
-	}
-	else if (Session->SessionSettings.bAllowJoinViaPresence)
+	if (SessionSettings.NumPublicConnections > 0)
 	{
-		Options.PermissionLevel = EOS_EOnlineSessionPermissionLevel::EOS_OSPF_JoinViaPresence;
+		return EOS_EOnlineSessionPermissionLevel::EOS_OSPF_PublicAdvertised;
 	}
-	else
+	else if (SessionSettings.bAllowJoinViaPresence)
 	{
-		Options.PermissionLevel = EOS_EOnlineSessionPermissionLevel::EOS_OSPF_InviteOnly;
+		return EOS_EOnlineSessionPermissionLevel::EOS_OSPF_JoinViaPresence;
 	}
+	return EOS_EOnlineSessionPermissionLevel::EOS_OSPF_InviteOnly;
+}
+
+void FEOSWrapperSessionManager::SetPermissionLevel(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session)
+{
+	EOS_SessionModification_SetPermissionLevelOptions Options = {};
+	Options.ApiVersion = EOS_SESSIONMODIFICATION_SETPERMISSIONLEVEL_API_LATEST;
+	Options.PermissionLevel = GetSessionPermissionLevelFromSessionSettings(Session->SessionSettings);
 
 	UE_LOG_ONLINE_SESSION(Log, TEXT("EOS_SessionModification_SetPermissionLevel() set to (%d) for session (%s)"), (int32)Options.PermissionLevel, *Session->SessionName.ToString());
 
@@ -3203,23 +4847,95 @@ void FEOSWrapperSessionManager::AddAttribute(EOS_HSessionModification SessionMod
 	}
 }
 
-void FEOSWrapperSessionManager::SetAttributes(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session)
+void FEOSWrapperSessionManager::RemoveAttribute(EOS_HSessionModification SessionModHandle, const FName& Key)
 {
-	// The first will let us find it on session searches
-	const FString SearchPresence(SEARCH_PRESENCE.ToString());
-	const FAttributeOptions SearchPresenceAttribute(TCHAR_TO_UTF8(*SearchPresence), true);
-	AddAttribute(SessionModHandle, &SearchPresenceAttribute);
+	EOS_SessionModification_RemoveAttributeOptions Options = {};
+	Options.ApiVersion = EOS_SESSIONMODIFICATION_REMOVEATTRIBUTE_API_LATEST;
+	Options.Key = AttributeArena.Store(Key);
+
+	UE_LOG_ONLINE_SESSION(Log, TEXT("EOS_SessionModification_RemoveAttribute() named (%s)"), *Key.ToString());
+
+	EOS_EResult ResultCode = EOS_SessionModification_RemoveAttribute(SessionModHandle, &Options);
+	if (ResultCode != EOS_EResult::EOS_Success)
+	{
+		UE_LOG_ONLINE_SESSION(Error, TEXT("EOS_SessionModification_RemoveAttribute() failed for attribute name (%s) with EOS result code (%s)"), *Key.ToString(), *LexToString(ResultCode));
+	}
+}
+
+bool FEOSWrapperSessionManager::FSessionAttributeState::Equals(const FSessionAttributeState& Other) const
+{
+	return PermissionLevel == Other.PermissionLevel && MaxPlayers == Other.MaxPlayers && bInvitesAllowed == Other.bInvitesAllowed && bAllowJoinInProgress == Other.bAllowJoinInProgress &&
+		   Attributes.OrderIndependentCompareEqual(Other.Attributes) && MemberAttributes.OrderIndependentCompareEqual(Other.MemberAttributes);
+}
+
+/**
+ * Walks the desired attributes against the ones EOS already has. Changed or new entries go to AddFunc, entries EOS has that are no longer wanted go to RemoveFunc.
+ * A null committed map means nothing was acknowledged yet, so everything is sent.
+ *
+ * @return number of attributes added or removed
+ */
+template <typename AddFuncType, typename RemoveFuncType>
+static int32 DiffSessionAttributes(const TMap<FName, FVariantData>& Desired, const TMap<FName, FVariantData>* Committed, AddFuncType&& AddFunc, RemoveFuncType&& RemoveFunc)
+{
+	int32 NumChanged = 0;
+	for (const TPair<FName, FVariantData>& Attribute : Desired)
+	{
+		const FVariantData* CommittedValue = Committed ? Committed->Find(Attribute.Key) : nullptr;
+		if (CommittedValue == nullptr || !(*CommittedValue == Attribute.Value))
+		{
+			AddFunc(Attribute.Key, Attribute.Value);
+			NumChanged++;
+		}
+	}
+	if (Committed)
+	{
+		for (const TPair<FName, FVariantData>& Attribute : *Committed)
+		{
+			if (!Desired.Contains(Attribute.Key))
+			{
+				RemoveFunc(Attribute.Key);
+				NumChanged++;
+			}
+		}
+	}
+	return NumChanged;
+}
+
+/** Adds the custom settings that are advertised through the online service */
+static void AddAdvertisedSessionSettings(const FSessionSettings& Settings, TMap<FName, FVariantData>& OutAttributes)
+{
+	for (FSessionSettings::TConstIterator It(Settings); It; ++It)
+	{
+		const FOnlineSessionSetting& Setting = It.Value();
+
+		// Skip unsupported types or non session advertised settings
+		if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || !IsSessionSettingTypeSupported(Setting.Data.GetType()))
+		{
+			continue;
+		}
+
+		OutAttributes.Add(It.Key(), Setting.Data);
+	}
+}
+
+void FEOSWrapperSessionManager::MakeSessionAttributeState(FNamedOnlineSession* Session, FSessionAttributeState& OutState)
+{
+	OutState.PermissionLevel = (int32)GetSessionPermissionLevelFromSessionSettings(Session->SessionSettings);
+	OutState.MaxPlayers = Session->SessionSettings.NumPrivateConnections + Session->SessionSettings.NumPublicConnections;
+	OutState.bInvitesAllowed = Session->SessionSettings.bAllowInvites;
+	OutState.bAllowJoinInProgress = Session->SessionSettings.bAllowJoinInProgress;
+
+	TMap<FName, FVariantData>& Attributes = OutState.Attributes;
 
-	FAttributeOptions Opt1("NumPrivateConnections", Session->SessionSettings.NumPrivateConnections);
-	AddAttribute(SessionModHandle, &Opt1);
+	// The first will let us find it on session searches
+	Attributes.Add(SEARCH_PRESENCE, FVariantData(true));
 
-	FAttributeOptions Opt2("NumPublicConnections", Session->SessionSettings.NumPublicConnections);
-	AddAttribute(SessionModHandle, &Opt2);
+	Attributes.Add(TEXT("NumPrivateConnections"), FVariantData(Session->SessionSettings.NumPrivateConnections));
+	Attributes.Add(TEXT("NumPublicConnections"), FVariantData(Session->SessionSettings.NumPublicConnections));
 
 	if (Session->OwningUserId.IsValid() && Session->OwningUserId->IsValid())
 	{
-		FAttributeOptions OwningUserId("OwningUserId", TCHAR_TO_UTF8(*Session->OwningUserId->ToString()));
-		AddAttribute(SessionModHandle, &OwningUserId);
+		Attributes.Add(TEXT("OwningUserId"), FVariantData(Session->OwningUserId->ToString()));
 	}
 
 	// Handle auto generation of dedicated server names
@@ -3240,40 +4956,70 @@ void FEOSWrapperSessionManager::SetAttributes(EOS_HSessionModification SessionMo
 		Session->OwningUserName = OwningPlayerName;
 	}
 
-	FAttributeOptions OwningUserName("OwningUserName", TCHAR_TO_UTF8(*Session->OwningUserName));
-	AddAttribute(SessionModHandle, &OwningUserName);
-
-	FAttributeOptions Opt5("bAntiCheatProtected", Session->SessionSettings.bAntiCheatProtected);
-	AddAttribute(SessionModHandle, &Opt5);
-
-	FAttributeOptions Opt6("bUsesStats", Session->SessionSettings.bUsesStats);
-	AddAttribute(SessionModHandle, &Opt6);
-
-	FAttributeOptions Opt7("bIsDedicated", Session->SessionSettings.bIsDedicated);
-	AddAttribute(SessionModHandle, &Opt7);
-
-	FAttributeOptions Opt8("BuildUniqueId", Session->SessionSettings.BuildUniqueId);
-	AddAttribute(SessionModHandle, &Opt8);
+	Attributes.Add(TEXT("OwningUserName"), FVariantData(Session->OwningUserName));
+	Attributes.Add(TEXT("bAntiCheatProtected"), FVariantData(Session->SessionSettings.bAntiCheatProtected));
+	Attributes.Add(TEXT("bUsesStats"), FVariantData(Session->SessionSettings.bUsesStats));
+	Attributes.Add(TEXT("bIsDedicated"), FVariantData(Session->SessionSettings.bIsDedicated));
+	Attributes.Add(TEXT("BuildUniqueId"), FVariantData(Session->SessionSettings.BuildUniqueId));
 
 	// Add all of the session settings
-	for (FSessionSettings::TConstIterator It(Session->SessionSettings.Settings); It; ++It)
-	{
-		const FName KeyName = It.Key();
-		const FOnlineSessionSetting& Setting = It.Value();
+	AddAdvertisedSessionSettings(Session->SessionSettings.Settings, Attributes);
+}
 
-		// Skip unsupported types or non session advertised settings
-		if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || !IsSessionSettingTypeSupported(Setting.Data.GetType()))
+void FEOSWrapperSessionManager::CommitSessionAttributeState(FName SessionName, const FSessionAttributeState& StagedState, bool bWasSuccessful)
+{
+	if (bWasSuccessful)
+	{
+		// A session destroyed while the update was on the wire doesn't get its state back
+		if (GetNamedSession(SessionName))
 		{
-			continue;
+			SessionStates.FindOrAdd(SessionName).CommittedState = StagedState;
 		}
-
-		FAttributeOptions Attribute(TCHAR_TO_UTF8(*KeyName.ToString()), Setting.Data);
-		AddAttribute(SessionModHandle, &Attribute);
 	}
+	else if (FSessionState* State = SessionStates.Find(SessionName))
+	{
+		// We don't know what EOS kept, so the next update sends everything again
+		State->CommittedState.Reset();
+	}
+}
+
+const FEOSWrapperSessionManager::FSessionAttributeState* FEOSWrapperSessionManager::FindCommittedSessionState(FName SessionName) const
+{
+	const FSessionState* State = SessionStates.Find(SessionName);
+	return State && State->CommittedState.IsSet() ? &State->CommittedState.GetValue() : nullptr;
+}
+
+int32 FEOSWrapperSessionManager::SetAttributes(EOS_HSessionModification SessionModHandle, const FSessionAttributeState& DesiredState, const FSessionAttributeState* CommittedState)
+{
+	const int32 NumChanged = DiffSessionAttributes(
+		DesiredState.Attributes, CommittedState ? &CommittedState->Attributes : nullptr,
+		[this, SessionModHandle](const FName& Key, const FVariantData& Value)
+		{
+			const FAttributeOptions Attribute(AttributeArena.Store(Key), Value, AttributeArena);
+			AddAttribute(SessionModHandle, &Attribute);
+		},
+		[this, SessionModHandle](const FName& Key) { RemoveAttribute(SessionModHandle, Key); });
+
+	// EOS copied everything into the modification handle
+	AttributeArena.Reset();
+
+	return NumChanged;
 }
 
 void FEOSWrapperSessionManager::BeginSessionAnalytics(FNamedOnlineSession* Session)
 {
+	// EOS tracks one player session per local user, it's shared by every session of this process
+	FSessionState& State = SessionStates.FindOrAdd(Session->SessionName);
+	if (State.bAnalyticsStarted)
+	{
+		return;
+	}
+	State.bAnalyticsStarted = true;
+	if (NumAnalyticsSessions++ > 0)
+	{
+		return;
+	}
+
 	int32 LocalUserNum = EOSSubsystem->UserManager->GetDefaultLocalUser();
 	FOnlineUserPtr LocalUser = EOSSubsystem->UserManager->GetLocalOnlineUser(LocalUserNum);
 	if (LocalUser.IsValid())
@@ -3295,8 +5041,19 @@ void FEOSWrapperSessionManager::BeginSessionAnalytics(FNamedOnlineSession* Sessi
 	}
 }
 
-void FEOSWrapperSessionManager::EndSessionAnalytics()
+void FEOSWrapperSessionManager::EndSessionAnalytics(FName SessionName)
 {
+	FSessionState* State = SessionStates.Find(SessionName);
+	if (!State || !State->bAnalyticsStarted)
+	{
+		return;
+	}
+	State->bAnalyticsStarted = false;
+	if (--NumAnalyticsSessions > 0)
+	{
+		return;
+	}
+
 	int32 LocalUserNum = EOSSubsystem->UserManager->GetDefaultLocalUser();
 	FOnlineUserPtr LocalUser = EOSSubsystem->UserManager->GetLocalOnlineUser(LocalUserNum);
 	if (LocalUser.IsValid())
@@ -3338,15 +5095,7 @@ void FEOSWrapperSessionManager::OnLobbyUpdateReceived(const EOS_LobbyId& LobbyId
 			EOS_EResult CopyInfoResult = EOS_LobbyDetails_CopyInfo(LobbyDetails->LobbyDetailsHandle, &CopyOptions, &LobbyDetailsInfo);
 			if (CopyInfoResult == EOS_EResult::EOS_Success)
 			{
-				CopyLobbyData(LobbyDetails, LobbyDetailsInfo, *Session, [this, SessionName = Session->SessionName, LobbyDetails](bool bWasSuccessful) {
-					if (bWasSuccessful)
-					{
-						if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
-						{
-							TriggerOnSessionSettingsUpdatedDelegates(SessionName, Session->SessionSettings);
-						}
-					}
-				});
+				ApplyLobbyUpdate(LobbyDetails, LobbyDetailsInfo, *Session);
 
 				EOS_LobbyDetails_Info_Release(LobbyDetailsInfo);
 			}
@@ -3384,76 +5133,15 @@ void FEOSWrapperSessionManager::OnMemberStatusReceived(const EOS_LobbyId& LobbyI
 		switch (CurrentStatus)
 		{
 			case EOS_ELobbyMemberStatus::EOS_LMS_JOINED:
-			{
-				EOSSubsystem->UserManager->ResolveUniqueNetId(TargetUserId, [this, LobbyNetId](FUniqueNetIdEOSRef ResolvedUniqueNetId) { UpdateOrAddLobbyMember(LobbyNetId, ResolvedUniqueNetId); });
-			}
-
-			break;
 			case EOS_ELobbyMemberStatus::EOS_LMS_LEFT:
-			{
-				EOSSubsystem->UserManager->ResolveUniqueNetId(TargetUserId, [this, LobbyNetId](FUniqueNetIdEOSRef ResolvedUniqueNetId) {
-					FNamedOnlineSession* Session = GetNamedSessionFromLobbyId(*LobbyNetId);
-					if (Session)
-					{
-						RemoveOnlineSessionMember(Session->SessionName, ResolvedUniqueNetId);
-
-						TriggerOnSessionParticipantsChangeDelegates(Session->SessionName, *ResolvedUniqueNetId, false);
-					}
-					else
-					{
-						UE_LOG_ONLINE(Warning, TEXT("[FOnlineSessionEOS::OnMemberStatusReceived] EOS_LMS_LEFT: Unable to retrieve session with LobbyId %s"), *LobbyNetId->ToString());
-					}
-				});
-			}
-			break;
+			case EOS_ELobbyMemberStatus::EOS_LMS_KICKED:
+			case EOS_ELobbyMemberStatus::EOS_LMS_PROMOTED:
+				// Resolved together with every other status change of this tick by TickMemberStatuses
+				PendingMemberStatuses.Add({LobbyNetId, TargetUserId, CurrentStatus});
+				break;
 			case EOS_ELobbyMemberStatus::EOS_LMS_DISCONNECTED:
 				// OSS Session will end
 				break;
-			case EOS_ELobbyMemberStatus::EOS_LMS_KICKED:
-			{
-				EOSSubsystem->UserManager->ResolveUniqueNetId(TargetUserId, [this, LobbyNetId](FUniqueNetIdEOSRef ResolvedUniqueNetId) {
-					FNamedOnlineSession* Session = GetNamedSessionFromLobbyId(*LobbyNetId);
-					if (Session)
-					{
-						RemoveOnlineSessionMember(Session->SessionName, ResolvedUniqueNetId);
-
-						TriggerOnSessionParticipantRemovedDelegates(Session->SessionName, *ResolvedUniqueNetId);
-					}
-					else
-					{
-						UE_LOG_ONLINE(Warning, TEXT("[FOnlineSessionEOS::OnMemberStatusReceived] EOS_LMS_KICKED: Unable to retrieve session with LobbyId %s"), *LobbyNetId->ToString());
-					}
-				});
-			}
-			break;
-			case EOS_ELobbyMemberStatus::EOS_LMS_PROMOTED:
-			{
-				EOSSubsystem->UserManager->ResolveUniqueNetId(TargetUserId, [this, LobbyNetId](FUniqueNetIdEOSRef ResolvedUniqueNetId) {
-					FNamedOnlineSession* Session = GetNamedSessionFromLobbyId(*LobbyNetId);
-					if (Session)
-					{
-						int32 DefaultLocalUser = EOSSubsystem->UserManager->GetDefaultLocalUser();
-						FUniqueNetIdPtr LocalPlayerUniqueNetId = EOSSubsystem->UserManager->GetUniquePlayerId(DefaultLocalUser);
-
-						if (*LocalPlayerUniqueNetId == *ResolvedUniqueNetId)
-						{
-							Session->OwningUserId = LocalPlayerUniqueNetId;
-							Session->OwningUserName = EOSSubsystem->UserManager->GetPlayerNickname(DefaultLocalUser);
-							;
-							Session->bHosting = true;
-
-							UpdateLobbySession(Session);
-						}
-
-						// If we are not the new owner, the new owner will update the session and we'll receive the notification, updating ours as well
-					}
-					else
-					{
-						UE_LOG_ONLINE(Warning, TEXT("[FOnlineSessionEOS::OnMemberStatusReceived] EOS_LMS_PROMOTED: Unable to retrieve session with LobbyId %s"), *LobbyNetId->ToString());
-					}
-				});
-			}
-			break;
 			case EOS_ELobbyMemberStatus::EOS_LMS_CLOSED:
 				// OSS Session will end
 				break;
@@ -3465,6 +5153,90 @@ void FEOSWrapperSessionManager::OnMemberStatusReceived(const EOS_LobbyId& LobbyI
 	}
 }
 
+void FEOSWrapperSessionManager::TickMemberStatuses()
+{
+	// A batch still resolving keeps the next one waiting, so statuses are applied in the order they were received
+	if (PendingMemberStatuses.Num() == 0 || bMemberStatusResolveInFlight)
+	{
+		return;
+	}
+
+	TArray<FPendingMemberStatus> MemberStatuses = MoveTemp(PendingMemberStatuses);
+	PendingMemberStatuses.Reset();
+
+	TArray<EOS_ProductUserId> TargetUserIds;
+	TargetUserIds.Reserve(MemberStatuses.Num());
+	for (const FPendingMemberStatus& MemberStatus : MemberStatuses)
+	{
+		TargetUserIds.AddUnique(MemberStatus.TargetUserId);
+	}
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_MemberStatusesBatched, MemberStatuses.Num() - 1);
+
+	bMemberStatusResolveInFlight = true;
+	EOSSubsystem->UserManager->ResolveUniqueNetIds(TargetUserIds, [this, MemberStatuses = MoveTemp(MemberStatuses)](TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds) {
+		bMemberStatusResolveInFlight = false;
+
+		for (const FPendingMemberStatus& MemberStatus : MemberStatuses)
+		{
+			if (const FUniqueNetIdEOSRef* ResolvedUniqueNetId = ResolvedUniqueNetIds.Find(MemberStatus.TargetUserId))
+			{
+				ApplyMemberStatus(MemberStatus, *ResolvedUniqueNetId);
+			}
+			else
+			{
+				UE_LOG_ONLINE(Warning, TEXT("[FOnlineSessionEOS::TickMemberStatuses] Unable to resolve member %s of LobbyId %s"), *LexToString(MemberStatus.TargetUserId),
+					*MemberStatus.LobbyNetId->ToString());
+			}
+		}
+	});
+}
+
+void FEOSWrapperSessionManager::ApplyMemberStatus(const FPendingMemberStatus& MemberStatus, const FUniqueNetIdEOSRef& ResolvedUniqueNetId)
+{
+	FNamedOnlineSession* Session = GetNamedSessionFromLobbyId(*MemberStatus.LobbyNetId);
+	if (!Session)
+	{
+		UE_LOG_ONLINE(Warning, TEXT("[FOnlineSessionEOS::ApplyMemberStatus] Unable to retrieve session with LobbyId %s"), *MemberStatus.LobbyNetId->ToString());
+		return;
+	}
+
+	switch (MemberStatus.Status)
+	{
+		case EOS_ELobbyMemberStatus::EOS_LMS_JOINED:
+			UpdateOrAddLobbyMember(MemberStatus.LobbyNetId, ResolvedUniqueNetId);
+			break;
+		case EOS_ELobbyMemberStatus::EOS_LMS_LEFT:
+			RemoveOnlineSessionMember(Session->SessionName, ResolvedUniqueNetId);
+
+			TriggerOnSessionParticipantsChangeDelegates(Session->SessionName, *ResolvedUniqueNetId, false);
+			break;
+		case EOS_ELobbyMemberStatus::EOS_LMS_KICKED:
+			RemoveOnlineSessionMember(Session->SessionName, ResolvedUniqueNetId);
+
+			TriggerOnSessionParticipantRemovedDelegates(Session->SessionName, *ResolvedUniqueNetId);
+			break;
+		case EOS_ELobbyMemberStatus::EOS_LMS_PROMOTED:
+		{
+			int32 DefaultLocalUser = EOSSubsystem->UserManager->GetDefaultLocalUser();
+			FUniqueNetIdPtr LocalPlayerUniqueNetId = EOSSubsystem->UserManager->GetUniquePlayerId(DefaultLocalUser);
+
+			if (*LocalPlayerUniqueNetId == *ResolvedUniqueNetId)
+			{
+				Session->OwningUserId = LocalPlayerUniqueNetId;
+				Session->OwningUserName = EOSSubsystem->UserManager->GetPlayerNickname(DefaultLocalUser);
+				Session->bHosting = true;
+
+				FlushSessionUpdate(Session->SessionName);
+			}
+
+			// If we are not the new owner, the new owner will update the session and we'll receive the notification, updating ours as well
+		}
+		break;
+		default:
+			break;
+	}
+}
+
 void FEOSWrapperSessionManager::OnLobbyInviteAccepted(const char* InviteId, const EOS_ProductUserId& LocalUserId, const EOS_ProductUserId& TargetUserId)
 {
 	FUniqueNetIdEOSPtr NetId = EOSSubsystem->UserManager->GetLocalUniqueNetIdEOS(LocalUserId);
@@ -3488,7 +5260,7 @@ void FEOSWrapperSessionManager::OnLobbyInviteAccepted(const char* InviteId, cons
 		TSharedRef<FLobbyDetailsEOS> LobbyDetails = MakeShared<FLobbyDetailsEOS>(LobbyDetailsHandle);
 
 		LastInviteSearch = MakeShared<FOnlineSessionSearch>();
-		AddLobbySearchResult(LobbyDetails, LastInviteSearch.ToSharedRef(), [this, LocalUserNum, NetId](bool bWasSuccessful) {
+		AddLobbySearchResult(LobbyDetails, LastInviteSearch.ToSharedRef(), SessionSearchStartInSeconds, [this, LocalUserNum, NetId](bool bWasSuccessful) {
 			// If we fail to copy the lobby data, we won't add a new search result, so we'll return an empty one
 			TriggerOnSessionUserInviteAcceptedDelegates(bWasSuccessful, LocalUserNum, NetId, bWasSuccessful ? LastInviteSearch->SearchResults.Last() : FOnlineSessionSearchResult());
 		});
@@ -3523,7 +5295,7 @@ void FEOSWrapperSessionManager::OnJoinLobbyAccepted(const EOS_ProductUserId& Loc
 		TSharedRef<FLobbyDetailsEOS> LobbyDetails = MakeShared<FLobbyDetailsEOS>(LobbyDetailsHandle);
 
 		LastInviteSearch = MakeShared<FOnlineSessionSearch>();
-		AddLobbySearchResult(LobbyDetails, LastInviteSearch.ToSharedRef(), [this, LocalUserNum, NetId](bool bWasSuccessful) {
+		AddLobbySearchResult(LobbyDetails, LastInviteSearch.ToSharedRef(), SessionSearchStartInSeconds, [this, LocalUserNum, NetId](bool bWasSuccessful) {
 			// If we fail to copy the lobby data, we won't add a new search result, so we'll return an empty one
 			TriggerOnSessionUserInviteAcceptedDelegates(bWasSuccessful, LocalUserNum, NetId, bWasSuccessful ? LastInviteSearch->SearchResults.Last() : FOnlineSessionSearchResult());
 		});
@@ -3568,87 +5340,83 @@ void FEOSWrapperSessionManager::SetLobbyMaxMembers(EOS_HLobbyModification LobbyM
 	}
 }
 
-void FEOSWrapperSessionManager::SetLobbyAttributes(EOS_HLobbyModification LobbyModificationHandle, FNamedOnlineSession* Session)
+void FEOSWrapperSessionManager::MakeLobbyAttributeState(FNamedOnlineSession* Session, FSessionAttributeState& OutState)
 {
 	check(Session != nullptr);
 
+	OutState.PermissionLevel = (int32)GetLobbyPermissionLevelFromSessionSettings(Session->SessionSettings);
+	OutState.MaxPlayers = GetLobbyMaxMembersFromSessionSettings(Session->SessionSettings);
+
+	TMap<FName, FVariantData>& Attributes = OutState.Attributes;
+
 	// The first will let us find it on session searches
-	const FString SearchPresence(SEARCH_PRESENCE.ToString());
-	const FLobbyAttributeOptions SearchPresenceAttribute(TCHAR_TO_UTF8(*SearchPresence), true);
-	AddLobbyAttribute(LobbyModificationHandle, &SearchPresenceAttribute);
+	Attributes.Add(SEARCH_PRESENCE, FVariantData(true));
 
 	// The second will let us find it on lobby searches
-	const FString SearchLobbies(SEARCH_LOBBIES.ToString());
-	const FLobbyAttributeOptions SearchLobbiesAttribute(TCHAR_TO_UTF8(*SearchLobbies), true);
-	AddLobbyAttribute(LobbyModificationHandle, &SearchLobbiesAttribute);
+	Attributes.Add(SEARCH_LOBBIES, FVariantData(true));
 
 	// We set the session's owner id and name
-	const FLobbyAttributeOptions OwnerId("OwningUserId", TCHAR_TO_UTF8(*Session->OwningUserId->ToString()));
-	AddLobbyAttribute(LobbyModificationHandle, &OwnerId);
-
-	const FLobbyAttributeOptions OwnerName("OwningUserName", TCHAR_TO_UTF8(*Session->OwningUserName));
-	AddLobbyAttribute(LobbyModificationHandle, &OwnerName);
+	Attributes.Add(TEXT("OwningUserId"), FVariantData(Session->OwningUserId->ToString()));
+	Attributes.Add(TEXT("OwningUserName"), FVariantData(Session->OwningUserName));
 
 	// Now the session settings
-	const FLobbyAttributeOptions Opt1("NumPrivateConnections", Session->SessionSettings.NumPrivateConnections);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt1);
-
-	const FLobbyAttributeOptions Opt2("NumPublicConnections", Session->SessionSettings.NumPublicConnections);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt2);
-
-	const FLobbyAttributeOptions Opt5("bAntiCheatProtected", Session->SessionSettings.bAntiCheatProtected);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt5);
-
-	const FLobbyAttributeOptions Opt6("bUsesStats", Session->SessionSettings.bUsesStats);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt6);
-
+	Attributes.Add(TEXT("NumPrivateConnections"), FVariantData(Session->SessionSettings.NumPrivateConnections));
+	Attributes.Add(TEXT("NumPublicConnections"), FVariantData(Session->SessionSettings.NumPublicConnections));
+	Attributes.Add(TEXT("bAntiCheatProtected"), FVariantData(Session->SessionSettings.bAntiCheatProtected));
+	Attributes.Add(TEXT("bUsesStats"), FVariantData(Session->SessionSettings.bUsesStats));
 	// Likely unnecessary for lobbies
-	const FLobbyAttributeOptions Opt7("bIsDedicated", Session->SessionSettings.bIsDedicated);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt7);
-
-	const FLobbyAttributeOptions Opt8("BuildUniqueId", Session->SessionSettings.BuildUniqueId);
-	AddLobbyAttribute(LobbyModificationHandle, &Opt8);
+	Attributes.Add(TEXT("bIsDedicated"), FVariantData(Session->SessionSettings.bIsDedicated));
+	Attributes.Add(TEXT("BuildUniqueId"), FVariantData(Session->SessionSettings.BuildUniqueId));
 
 	// Add all of the custom settings
-	for (FSessionSettings::TConstIterator It(Session->SessionSettings.Settings); It; ++It)
-	{
-		const FName KeyName = It.Key();
-		const FOnlineSessionSetting& Setting = It.Value();
+	AddAdvertisedSessionSettings(Session->SessionSettings.Settings, Attributes);
 
-		// Skip unsupported types or non session advertised settings
-		if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || !IsSessionSettingTypeSupported(Setting.Data.GetType()))
+	// And anything set through SetLobbyParameter
+	if (const FSessionState* State = SessionStates.Find(Session->SessionName))
+	{
+		for (const TPair<FName, FString>& Parameter : State->LobbyParameters)
 		{
-			continue;
+			Attributes.Add(Parameter.Key, FVariantData(Parameter.Value));
 		}
-
-		const FLobbyAttributeOptions Attribute(TCHAR_TO_UTF8(*KeyName.ToString()), Setting.Data);
-		AddLobbyAttribute(LobbyModificationHandle, &Attribute);
 	}
 
 	// Add all of the member settings
-	for (TPair<FUniqueNetIdRef, FSessionSettings> MemberSettings : Session->SessionSettings.MemberSettings)
+	for (const TPair<FUniqueNetIdRef, FSessionSettings>& MemberSettings : Session->SessionSettings.MemberSettings)
 	{
 		// We'll only copy our local player's attributes
 		if (*EOSSubsystem->UserManager->GetUniquePlayerId(EOSSubsystem->UserManager->GetDefaultLocalUser()) == *MemberSettings.Key)
 		{
-			for (FSessionSettings::TConstIterator It(MemberSettings.Value); It; ++It)
-			{
-				const FName KeyName = It.Key();
-				const FOnlineSessionSetting& Setting = It.Value();
-
-				// Skip unsupported types or non session advertised settings
-				if (Setting.AdvertisementType < EOnlineDataAdvertisementType::ViaOnlineService || !IsSessionSettingTypeSupported(Setting.Data.GetType()))
-				{
-					continue;
-				}
-
-				const FLobbyAttributeOptions Attribute(TCHAR_TO_UTF8(*KeyName.ToString()), Setting.Data);
-				AddLobbyMemberAttribute(LobbyModificationHandle, &Attribute);
-			}
+			AddAdvertisedSessionSettings(MemberSettings.Value, OutState.MemberAttributes);
 		}
 	}
 }
 
+int32 FEOSWrapperSessionManager::SetLobbyAttributes(EOS_HLobbyModification LobbyModificationHandle, const FSessionAttributeState& DesiredState, const FSessionAttributeState* CommittedState)
+{
+	int32 NumChanged = DiffSessionAttributes(
+		DesiredState.Attributes, CommittedState ? &CommittedState->Attributes : nullptr,
+		[this, LobbyModificationHandle](const FName& Key, const FVariantData& Value)
+		{
+			const FLobbyAttributeOptions Attribute(AttributeArena.Store(Key), Value, AttributeArena);
+			AddLobbyAttribute(LobbyModificationHandle, &Attribute);
+		},
+		[this, LobbyModificationHandle](const FName& Key) { RemoveLobbyAttribute(LobbyModificationHandle, Key); });
+
+	NumChanged += DiffSessionAttributes(
+		DesiredState.MemberAttributes, CommittedState ? &CommittedState->MemberAttributes : nullptr,
+		[this, LobbyModificationHandle](const FName& Key, const FVariantData& Value)
+		{
+			const FLobbyAttributeOptions Attribute(AttributeArena.Store(Key), Value, AttributeArena);
+			AddLobbyMemberAttribute(LobbyModificationHandle, &Attribute);
+		},
+		[this, LobbyModificationHandle](const FName& Key) { RemoveLobbyMemberAttribute(LobbyModificationHandle, Key); });
+
+	// EOS copied everything into the modification handle
+	AttributeArena.Reset();
+
+	return NumChanged;
+}
+
 void FEOSWrapperSessionManager::AddLobbyAttribute(EOS_HLobbyModification LobbyModificationHandle, const EOS_Lobby_AttributeData* Attribute)
 {
 	EOS_LobbyModification_AddAttributeOptions Options = {};
@@ -3678,38 +5446,80 @@ void FEOSWrapperSessionManager::AddLobbyMemberAttribute(EOS_HLobbyModification L
 	}
 }
 
-void FEOSWrapperSessionManager::CopyLobbyData(
-	const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, FOnlineSession& OutSession, const FOnCopyLobbyDataCompleteCallback& Callback)
+void FEOSWrapperSessionManager::RemoveLobbyAttribute(EOS_HLobbyModification LobbyModificationHandle, const FName& Key)
+{
+	EOS_LobbyModification_RemoveAttributeOptions Options = {};
+	Options.ApiVersion = EOS_LOBBYMODIFICATION_REMOVEATTRIBUTE_API_LATEST;
+	Options.Key = AttributeArena.Store(Key);
+
+	EOS_EResult ResultCode = EOS_LobbyModification_RemoveAttribute(LobbyModificationHandle, &Options);
+	if (ResultCode != EOS_EResult::EOS_Success)
+	{
+		UE_LOG_ONLINE_SESSION(Error, TEXT("[FEOSWrapperSessionManager::RemoveLobbyAttribute] LobbyModification_RemoveAttribute for attribute name (%s) not successful. Finished with EOS_EResult %s"),
+			*Key.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
+	}
+}
+
+void FEOSWrapperSessionManager::RemoveLobbyMemberAttribute(EOS_HLobbyModification LobbyModificationHandle, const FName& Key)
+{
+	EOS_LobbyModification_RemoveMemberAttributeOptions Options = {};
+	Options.ApiVersion = EOS_LOBBYMODIFICATION_REMOVEMEMBERATTRIBUTE_API_LATEST;
+	Options.Key = AttributeArena.Store(Key);
+
+	EOS_EResult ResultCode = EOS_LobbyModification_RemoveMemberAttribute(LobbyModificationHandle, &Options);
+	if (ResultCode != EOS_EResult::EOS_Success)
+	{
+		UE_LOG_ONLINE_SESSION(Error, TEXT("[FEOSWrapperSessionManager::RemoveLobbyMemberAttribute] LobbyModification_RemoveMemberAttribute for attribute name (%s) not successful. Finished with EOS_EResult %s"),
+			*Key.ToString(), ANSI_TO_TCHAR(EOS_EResult_ToString(ResultCode)));
+	}
+}
+
+bool FEOSWrapperSessionManager::CopyLobbyInfo(const EOS_LobbyDetails_Info* LobbyDetailsInfo, FOnlineSession& OutSession)
 {
-	OutSession.SessionSettings.bUseLobbiesIfAvailable = true;
-	OutSession.SessionSettings.bIsLANMatch = false;
-	OutSession.SessionSettings.Set(SETTING_HOST_MIGRATION, LobbyDetailsInfo->bAllowHostMigration, EOnlineDataAdvertisementType::DontAdvertise);
+	FOnlineSessionSettings& Settings = OutSession.SessionSettings;
+	bool bChanged = AssignIfChanged(Settings.bUseLobbiesIfAvailable, true);
+	bChanged |= AssignIfChanged(Settings.bIsLANMatch, false);
+
+	const bool bAllowHostMigration = LobbyDetailsInfo->bAllowHostMigration == EOS_TRUE;
+	bool bCurrentAllowHostMigration = false;
+	if (!Settings.Get(SETTING_HOST_MIGRATION, bCurrentAllowHostMigration) || bCurrentAllowHostMigration != bAllowHostMigration)
+	{
+		Settings.Set(SETTING_HOST_MIGRATION, bAllowHostMigration, EOnlineDataAdvertisementType::DontAdvertise);
+		bChanged = true;
+	}
 #if WITH_EOS_RTC
-	OutSession.SessionSettings.bUseLobbiesVoiceChatIfAvailable = LobbyDetailsInfo->bRTCRoomEnabled == EOS_TRUE;
+	bChanged |= AssignIfChanged(Settings.bUseLobbiesVoiceChatIfAvailable, LobbyDetailsInfo->bRTCRoomEnabled == EOS_TRUE);
 #endif
 
 	switch (LobbyDetailsInfo->PermissionLevel)
 	{
 		case EOS_ELobbyPermissionLevel::EOS_LPL_PUBLICADVERTISED:
 		case EOS_ELobbyPermissionLevel::EOS_LPL_JOINVIAPRESENCE:
-			OutSession.SessionSettings.bUsesPresence = true;
-			OutSession.SessionSettings.bAllowJoinViaPresence = true;
+			bChanged |= AssignIfChanged(Settings.bUsesPresence, true);
+			bChanged |= AssignIfChanged(Settings.bAllowJoinViaPresence, true);
 
-			OutSession.SessionSettings.NumPublicConnections = LobbyDetailsInfo->MaxMembers;
-			OutSession.NumOpenPublicConnections = LobbyDetailsInfo->AvailableSlots;
+			bChanged |= AssignIfChanged(Settings.NumPublicConnections, (int32)LobbyDetailsInfo->MaxMembers);
+			bChanged |= AssignIfChanged(OutSession.NumOpenPublicConnections, (int32)LobbyDetailsInfo->AvailableSlots);
 
 			break;
 		case EOS_ELobbyPermissionLevel::EOS_LPL_INVITEONLY:
-			OutSession.SessionSettings.bUsesPresence = false;
-			OutSession.SessionSettings.bAllowJoinViaPresence = false;
+			bChanged |= AssignIfChanged(Settings.bUsesPresence, false);
+			bChanged |= AssignIfChanged(Settings.bAllowJoinViaPresence, false);
 
-			OutSession.SessionSettings.NumPrivateConnections = LobbyDetailsInfo->MaxMembers;
-			OutSession.NumOpenPrivateConnections = LobbyDetailsInfo->AvailableSlots;
+			bChanged |= AssignIfChanged(Settings.NumPrivateConnections, (int32)LobbyDetailsInfo->MaxMembers);
+			bChanged |= AssignIfChanged(OutSession.NumOpenPrivateConnections, (int32)LobbyDetailsInfo->AvailableSlots);
 
 			break;
 	}
 
-	OutSession.SessionSettings.bAllowInvites = (bool)LobbyDetailsInfo->bAllowInvites;
+	bChanged |= AssignIfChanged(Settings.bAllowInvites, LobbyDetailsInfo->bAllowInvites == EOS_TRUE);
+	return bChanged;
+}
+
+void FEOSWrapperSessionManager::CopyLobbyData(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, const TSharedRef<FOnlineSessionSearch>& OwningSearch,
+	FOnlineSession& OutSession, const FOnCopyLobbyDataCompleteCallback& Callback)
+{
+	CopyLobbyInfo(LobbyDetailsInfo, OutSession);
 
 	// We copy the settings related to lobby attributes
 	CopyLobbyAttributes(LobbyDetails, OutSession);
@@ -3735,8 +5545,14 @@ void FEOSWrapperSessionManager::CopyLobbyData(
 	if (!TargetUserIds.IsEmpty())
 	{
 		EOSSubsystem->UserManager->ResolveUniqueNetIds(TargetUserIds,
-			[this, LobbyDetails, LobbyId = FUniqueNetIdEOSLobby::Create(LobbyDetailsInfo->LobbyId), OriginalCallback = Callback](TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds) {
-				FOnlineSession* Session = GetOnlineSessionFromLobbyId(*LobbyId);
+			[this, LobbyDetails, OwningSearch, LobbyId = FUniqueNetIdEOSLobby::Create(LobbyDetailsInfo->LobbyId), OriginalCallback = Callback](
+				TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds) {
+				// OutSession may have moved if the owning search grew in the meantime, so we find it again in the search it was added to.
+				// The search can be a standalone search that is neither CurrentSessionSearch nor LastInviteSearch
+				FOnlineSessionSearchResult* SearchResult = OwningSearch->SearchResults.FindByPredicate([&LobbyId](const FOnlineSessionSearchResult& Candidate) {
+					return Candidate.Session.SessionInfo.IsValid() && *StaticCastSharedPtr<FOnlineSessionInfoEOS>(Candidate.Session.SessionInfo)->SessionId == *LobbyId;
+				});
+				FOnlineSession* Session = SearchResult ? &SearchResult->Session : nullptr;
 				if (Session)
 				{
 					for (TMap<EOS_ProductUserId, FUniqueNetIdEOSRef>::TConstIterator It(ResolvedUniqueNetIds); It; ++It)
@@ -3757,9 +5573,10 @@ void FEOSWrapperSessionManager::CopyLobbyData(
 	}
 }
 
-void FEOSWrapperSessionManager::CopyLobbyAttributes(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, FOnlineSession& OutSession)
+bool FEOSWrapperSessionManager::CopyLobbyAttributes(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, FOnlineSession& OutSession, TSet<FName>* OutAttributeKeys)
 {
-	// In this method we are updating/adding attributes, but not removing
+	// In this method we are updating/adding attributes, removing is up to callers that track OutAttributeKeys
+	bool bChanged = false;
 
 	EOS_LobbyDetails_GetAttributeCountOptions CountOptions = {};
 	CountOptions.ApiVersion = EOS_LOBBYDETAILS_GETATTRIBUTECOUNT_API_LATEST;
@@ -3775,78 +5592,47 @@ void FEOSWrapperSessionManager::CopyLobbyAttributes(const TSharedRef<FLobbyDetai
 		EOS_EResult ResultCode = EOS_LobbyDetails_CopyAttributeByIndex(LobbyDetails->LobbyDetailsHandle, &AttrOptions, &Attribute);
 		if (ResultCode == EOS_EResult::EOS_Success)
 		{
-			FString Key = UTF8_TO_TCHAR(Attribute->Data->Key);
-			if (Key == TEXT("OwningUserId"))
+			const EWellKnownSessionAttribute WellKnownAttribute = FindWellKnownSessionAttribute(Attribute->Data->Key);
+			if (WellKnownAttribute != EWellKnownSessionAttribute::Unknown)
 			{
-				OutSession.OwningUserId = FUniqueNetIdEOSRegistry::FindOrAdd(UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-			}
-			else if (Key == TEXT("OwningUserName"))
-			{
-				OutSession.OwningUserName = UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8);
-			}
-			else if (Key == TEXT("NumPublicConnections"))
-			{
-				OutSession.SessionSettings.NumPublicConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("NumPrivateConnections"))
-			{
-				OutSession.SessionSettings.NumPrivateConnections = Attribute->Data->Value.AsInt64;
-			}
-			else if (Key == TEXT("bAntiCheatProtected"))
-			{
-				OutSession.SessionSettings.bAntiCheatProtected = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bUsesStats"))
-			{
-				OutSession.SessionSettings.bUsesStats = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("bIsDedicated"))
-			{
-				OutSession.SessionSettings.bIsDedicated = Attribute->Data->Value.AsBool == EOS_TRUE;
-			}
-			else if (Key == TEXT("BuildUniqueId"))
-			{
-				OutSession.SessionSettings.BuildUniqueId = Attribute->Data->Value.AsInt64;
+				bChanged |= CopyWellKnownSessionAttribute(WellKnownAttribute, Attribute->Data, OutSession);
 			}
 			// Handle FSessionSettings
 			else
 			{
-				FOnlineSessionSetting Setting;
-				switch (Attribute->Data->ValueType)
+				const FName Key = InternAttributeKey(Attribute->Data->Key);
+				FOnlineSessionSetting NewSetting = MakeSessionSettingFromAttribute(Attribute->Data);
+				if (FOnlineSessionSetting* Setting = OutSession.SessionSettings.Settings.Find(Key))
 				{
-					case EOS_ESessionAttributeType::EOS_SAT_Boolean:
-					{
-						Setting.Data.SetValue(Attribute->Data->Value.AsBool == EOS_TRUE);
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_Int64:
+					if (!(Setting->Data == NewSetting.Data))
 					{
-						Setting.Data.SetValue(int64(Attribute->Data->Value.AsInt64));
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_Double:
-					{
-						Setting.Data.SetValue(Attribute->Data->Value.AsDouble);
-						break;
-					}
-					case EOS_ESessionAttributeType::EOS_SAT_String:
-					{
-						Setting.Data.SetValue(UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-						break;
+						Setting->Data = MoveTemp(NewSetting.Data);
+						bChanged = true;
 					}
 				}
+				else
+				{
+					OutSession.SessionSettings.Settings.Add(Key, MoveTemp(NewSetting));
+					bChanged = true;
+				}
 
-				OutSession.SessionSettings.Settings.FindOrAdd(FName(Key), Setting);
+				if (OutAttributeKeys)
+				{
+					OutAttributeKeys->Add(Key);
+				}
 			}
 		}
 
 		EOS_Lobby_Attribute_Release(Attribute);
 	}
+
+	return bChanged;
 }
 
-void FEOSWrapperSessionManager::CopyLobbyMemberAttributes(const FLobbyDetailsEOS& LobbyDetails, const EOS_ProductUserId& TargetUserId, FSessionSettings& OutSessionSettings)
+bool FEOSWrapperSessionManager::CopyLobbyMemberAttributes(const FLobbyDetailsEOS& LobbyDetails, const EOS_ProductUserId& TargetUserId, FSessionSettings& OutSessionSettings)
 {
 	// In this method we are updating/adding attributes, but not removing
+	bool bChanged = false;
 
 	EOS_LobbyDetails_GetMemberAttributeCountOptions GetMemberAttributeCountOptions = {};
 	GetMemberAttributeCountOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERATTRIBUTECOUNT_API_LATEST;
@@ -3857,48 +5643,108 @@ void FEOSWrapperSessionManager::CopyLobbyMemberAttributes(const FLobbyDetailsEOS
 	{
 		EOS_LobbyDetails_CopyMemberAttributeByIndexOptions AttrOptions = {};
 		AttrOptions.ApiVersion = EOS_LOBBYDETAILS_COPYMEMBERATTRIBUTEBYINDEX_API_LATEST;
+		AttrOptions.TargetUserId = TargetUserId;
 		AttrOptions.AttrIndex = MemberAttributeIndex;
 
 		EOS_Lobby_Attribute* Attribute = NULL;
 		EOS_EResult ResultCode = EOS_LobbyDetails_CopyMemberAttributeByIndex(LobbyDetails.LobbyDetailsHandle, &AttrOptions, &Attribute);
 		if (ResultCode == EOS_EResult::EOS_Success)
 		{
-			FString Key = Attribute->Data->Key;
-
-			FOnlineSessionSetting Setting;
-			switch (Attribute->Data->ValueType)
+			const FName Key = InternAttributeKey(Attribute->Data->Key);
+			FOnlineSessionSetting NewSetting = MakeSessionSettingFromAttribute(Attribute->Data);
+			if (FOnlineSessionSetting* Setting = OutSessionSettings.Find(Key))
 			{
-				case EOS_ESessionAttributeType::EOS_SAT_Boolean:
-				{
-					Setting.Data.SetValue(Attribute->Data->Value.AsBool == EOS_TRUE);
-					break;
-				}
-				case EOS_ESessionAttributeType::EOS_SAT_Int64:
-				{
-					Setting.Data.SetValue(int64(Attribute->Data->Value.AsInt64));
-					break;
-				}
-				case EOS_ESessionAttributeType::EOS_SAT_Double:
-				{
-					Setting.Data.SetValue(Attribute->Data->Value.AsDouble);
-					break;
-				}
-				case EOS_ESessionAttributeType::EOS_SAT_String:
+				if (!(Setting->Data == NewSetting.Data))
 				{
-					Setting.Data.SetValue(UTF8_TO_TCHAR(Attribute->Data->Value.AsUtf8));
-					break;
+					*Setting = MoveTemp(NewSetting);
+					bChanged = true;
 				}
 			}
-
-			if (OutSessionSettings.Contains(FName(Key)))
-			{
-				OutSessionSettings[FName(Key)] = Setting;
-			}
 			else
 			{
-				OutSessionSettings.Add(FName(Key), Setting);
+				OutSessionSettings.Add(Key, MoveTemp(NewSetting));
+				bChanged = true;
 			}
 		}
+
+		EOS_Lobby_Attribute_Release(Attribute);
+	}
+
+	return bChanged;
+}
+
+void FEOSWrapperSessionManager::ApplyLobbyUpdate(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, FNamedOnlineSession& Session)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EOSWrapper_ApplyLobbyUpdate);
+
+	const FName SessionName = Session.SessionName;
+	bool bChanged = CopyLobbyInfo(LobbyDetailsInfo, Session);
+
+	// Attributes the owner removed since the last update are dropped, everything else is only written when its value changed
+	TSet<FName> AttributeKeys;
+	bChanged |= CopyLobbyAttributes(LobbyDetails, Session, &AttributeKeys);
+	FSessionState& State = SessionStates.FindOrAdd(SessionName);
+	for (const FName& Key : State.LobbyAttributeKeys)
+	{
+		if (!AttributeKeys.Contains(Key))
+		{
+			bChanged |= Session.SessionSettings.Settings.Remove(Key) > 0;
+		}
+	}
+	State.LobbyAttributeKeys = MoveTemp(AttributeKeys);
+
+	// Members already in the session keep the id they were resolved to, only newcomers go through ResolveUniqueNetIds
+	TMap<EOS_ProductUserId, FUniqueNetIdRef> KnownMembers;
+	KnownMembers.Reserve(Session.SessionSettings.MemberSettings.Num());
+	for (const TPair<FUniqueNetIdRef, FSessionSettings>& MemberSettings : Session.SessionSettings.MemberSettings)
+	{
+		KnownMembers.Add(FUniqueNetIdEOS::Cast(*MemberSettings.Key).GetProductUserId(), MemberSettings.Key);
+	}
+
+	EOS_LobbyDetails_GetMemberCountOptions CountOptions = {};
+	CountOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERCOUNT_API_LATEST;
+	const int32 Count = EOS_LobbyDetails_GetMemberCount(LobbyDetails->LobbyDetailsHandle, &CountOptions);
+
+	TArray<EOS_ProductUserId> NewMemberIds;
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		EOS_LobbyDetails_GetMemberByIndexOptions GetMemberByIndexOptions = {};
+		GetMemberByIndexOptions.ApiVersion = EOS_LOBBYDETAILS_GETMEMBERBYINDEX_API_LATEST;
+		GetMemberByIndexOptions.MemberIndex = Index;
+		const EOS_ProductUserId TargetUserId = EOS_LobbyDetails_GetMemberByIndex(LobbyDetails->LobbyDetailsHandle, &GetMemberByIndexOptions);
+
+		if (const FUniqueNetIdRef* MemberId = KnownMembers.Find(TargetUserId))
+		{
+			bChanged |= CopyLobbyMemberAttributes(*LobbyDetails, TargetUserId, Session.SessionSettings.MemberSettings.FindChecked(*MemberId));
+		}
+		else
+		{
+			NewMemberIds.Add(TargetUserId);
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_LobbyMemberResolvesSkipped, Count - NewMemberIds.Num());
+
+	if (NewMemberIds.Num() > 0)
+	{
+		EOSSubsystem->UserManager->ResolveUniqueNetIds(NewMemberIds, [this, LobbyDetails, SessionName](TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds) {
+			if (FNamedOnlineSession* Session = GetNamedSession(SessionName))
+			{
+				for (TMap<EOS_ProductUserId, FUniqueNetIdEOSRef>::TConstIterator It(ResolvedUniqueNetIds); It; ++It)
+				{
+					FSessionSettings& MemberSettings = Session->SessionSettings.MemberSettings.FindOrAdd(It.Value());
+					CopyLobbyMemberAttributes(*LobbyDetails, It.Key(), MemberSettings);
+				}
+				TriggerOnSessionSettingsUpdatedDelegates(SessionName, Session->SessionSettings);
+			}
+		});
+	}
+	else if (bChanged)
+	{
+		TriggerOnSessionSettingsUpdatedDelegates(SessionName, Session.SessionSettings);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_EOSWrapper_LobbyUpdatesUnchanged);
 	}
 }
 
@@ -3917,7 +5763,7 @@ void FEOSWrapperSessionManager::AddLobbySearchAttribute(EOS_HLobbySearch LobbySe
 }
 
 void FEOSWrapperSessionManager::AddLobbySearchResult(
-	const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnCopyLobbyDataCompleteCallback& Callback)
+	const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, const TSharedRef<FOnlineSessionSearch>& SearchSettings, double SearchStartInSeconds, const FOnCopyLobbyDataCompleteCallback& Callback)
 {
 	EOS_LobbyDetails_Info* LobbyDetailsInfo = nullptr;
 	EOS_LobbyDetails_CopyInfoOptions CopyOptions = {};
@@ -3927,7 +5773,7 @@ void FEOSWrapperSessionManager::AddLobbySearchResult(
 	{
 		int32 Position = SearchSettings->SearchResults.AddZeroed();
 		FOnlineSessionSearchResult& SearchResult = SearchSettings->SearchResults[Position];
-		SearchResult.PingInMs = static_cast<int32>((FPlatformTime::Seconds() - SessionSearchStartInSeconds) * 1000);
+		SearchResult.PingInMs = static_cast<int32>((FPlatformTime::Seconds() - SearchStartInSeconds) * 1000);
 
 		// This will set the host address and port
 		// Because some platforms remap ports, we will use the ID of the name of the net driver to be our port instead
@@ -3940,7 +5786,7 @@ void FEOSWrapperSessionManager::AddLobbySearchResult(
 
 		// We copy the lobby data and settings
 		LobbySearchResultsCache.Add(FString(LobbyDetailsInfo->LobbyId), LobbyDetails);
-		CopyLobbyData(LobbyDetails, LobbyDetailsInfo, SearchResult.Session, Callback);
+		CopyLobbyData(LobbyDetails, LobbyDetailsInfo, SearchSettings, SearchResult.Session, Callback);
 
 		EOS_LobbyDetails_Info_Release(LobbyDetailsInfo);
 
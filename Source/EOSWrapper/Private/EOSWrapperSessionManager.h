@@ -7,6 +7,10 @@
 #include "Interfaces/OnlineSessionInterface.h"
 #include "EOSSharedTypes.h"
 #include "EOSWrapperTypes.h"
+#include "EOSWrapperSessionRanking.h"
+#include "EOSWrapperMatchmaking.h"
+#include "EOSWrapperQos.h"
+#include "EOSWrapperLan.h"
 
 #if WITH_EOS_SDK
 #include "eos_types.h"
@@ -45,6 +49,54 @@ struct FLobbyDetailsEOS : FNoncopyable
 	virtual ~FLobbyDetailsEOS() { EOS_LobbyDetails_Release(LobbyDetailsHandle); }
 };
 
+/** Hashes and compares unique net ids by value, so sets of them can be probed with an id from anywhere */
+struct FUniqueNetIdRefKeyFuncs : BaseKeyFuncs<FUniqueNetIdRef, FUniqueNetIdRef, false>
+{
+	static KeyInitType GetSetKey(ElementInitType Element) { return Element; }
+	static bool Matches(KeyInitType A, KeyInitType B) { return *A == *B; }
+	static uint32 GetKeyHash(KeyInitType Key) { return GetTypeHash(*Key); }
+};
+typedef TSet<FUniqueNetIdRef, FUniqueNetIdRefKeyFuncs> FUniqueNetIdRefSet;
+
+/** Same as FUniqueNetIdRefKeyFuncs for maps keyed by unique net id */
+template <typename ValueType>
+struct TUniqueNetIdRefMapKeyFuncs : TDefaultMapKeyFuncs<FUniqueNetIdRef, ValueType, false>
+{
+	static bool Matches(const FUniqueNetIdRef& A, const FUniqueNetIdRef& B) { return *A == *B; }
+	static uint32 GetKeyHash(const FUniqueNetIdRef& Key) { return GetTypeHash(*Key); }
+};
+typedef TMap<FUniqueNetIdRef, int32, FDefaultSetAllocator, TUniqueNetIdRefMapKeyFuncs<int32>> FUniqueNetIdRefIndexMap;
+
+/** Outcome of the last FindSessions call that was split into partitions */
+struct FEOSPartitionedSearchMetrics
+{
+	int32 NumPartitions = 0;
+	int32 NumPagesFetched = 0;
+	int32 NumPagesFailed = 0;
+	int32 NumResults = 0;
+	double TimeToCompleteInSeconds = 0.0;
+};
+
+/**
+ * Linear arena for the UTF-8 keys and values handed to EOS while staging a session or lobby modification.
+ * Strings are packed back to back and keep their address until Reset(), which releases everything at once but keeps the memory for the next update.
+ */
+class FEOSAttributeArena : FNoncopyable
+{
+public:
+	const char* Store(const char* Utf8String, int32 Length);
+	const char* Store(const TCHAR* String);
+	const char* Store(const FName& Name);
+	void Reset();
+
+private:
+	static constexpr int32 BlockSize = 4096;
+
+	/** Blocks never grow past their reserved size, so pointers into them stay valid */
+	TArray<TArray<char>> Blocks;
+	int32 CurrentBlock = 0;
+};
+
 class FEOSWrapperSubsystem;
 
 /**
@@ -110,28 +162,32 @@ public:
 	bool SetLobbyParameter(const FName& LobbyName, const FName& Parameter, const FString& Value);
 
 	void Initialize(const FString& InBucketId);
+	/** Writes the session snapshot one last time, so a server stopped for an update leaves its current sessions behind */
+	void Shutdown();
 	/** Session tick for various background tasks */
 	void Tick(float DeltaTime);
 
+	/** Swaps the lobby backend StartMatchmaking runs against, e.g. for an FEOSMatchmakingLocalBackend. Tickets in progress are dropped */
+	void SetMatchmakingBackend(const TSharedRef<IEOSMatchmakingBackend>& Backend);
+	const FEOSMatchmakingMetrics& GetMatchmakingMetrics() const { return Matchmaker->GetMetrics(); }
+	const FEOSPartitionedSearchMetrics& GetLastPartitionedSearchMetrics() const { return LastPartitionedSearchMetrics; }
+
 private:
+	friend class FEOSMatchmakingLobbyBackend;
+
 	EOS_HLobby LobbyHandle;
 
 	void RegisterLobbyNotifications();
 	void RegisterLocalPlayers(class FNamedOnlineSession* Session);
 
-	// Lobby session callbacks and methods
-	FCallbackBase* LobbyCreatedCallback;
-	FCallbackBase* LobbySearchFindCallback;
-	FCallbackBase* LobbyJoinedCallback;
-	FCallbackBase* LobbyLeftCallback;
-	FCallbackBase* LobbyDestroyedCallback;
-	FCallbackBase* LobbySendInviteCallback;
-
+	// Lobby session methods
 	uint32 FindLobbySession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	/** Creates and starts a lobby search for the query settings, without touching the current search or the lobby results cache */
+	uint32 StartLobbySessionSearch(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate);
 	void StartLobbySearch(
 		int32 SearchingPlayerNum, EOS_HLobbySearch LobbySearchHandle, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate);
 	uint32 CreateLobbySession(int32 HostingPlayerNum, FNamedOnlineSession* Session);
-	uint32 UpdateLobbySession(FNamedOnlineSession* Session);
+	uint32 UpdateLobbySession(FNamedOnlineSession* Session, int32 NumCallers = 1);
 	uint32 JoinLobbySession(int32 PlayerNum, FNamedOnlineSession* Session, const FOnlineSession* SearchSession);
 	uint32 StartLobbySession(FNamedOnlineSession* Session);
 	uint32 EndLobbySession(FNamedOnlineSession* Session);
@@ -143,6 +199,57 @@ private:
 	FNamedOnlineSession* GetNamedSessionFromLobbyId(const FUniqueNetIdEOSLobby& LobbyId);
 	FOnlineSessionSearchResult* GetSearchResultFromLobbyId(const FUniqueNetIdEOSLobby& LobbyId);
 
+	/**
+	 * FindFriendSession over a friends list. The lobby id every friend publishes as presence join info is searched for,
+	 * once per distinct lobby with at most FriendSessionSearchMaxParallelSearches running
+	 */
+	struct FFriendSessionSearch
+	{
+		int32 LocalUserNum = 0;
+		TArray<FString> LobbyIds;
+		int32 NextLobbyIndex = 0;
+		int32 NumInFlight = 0;
+		bool bAnySucceeded = false;
+		bool bCompleted = false;
+		TArray<FOnlineSessionSearchResult> Results;
+	};
+	int32 FriendSessionSearchMaxParallelSearches = 4;
+
+	/** Presence join info of a friend, the id of the presence enabled lobby they are in. Empty when they are in none or their presence isn't cached */
+	FString GetFriendJoinInfo(int32 LocalUserNum, const FUniqueNetId& Friend) const;
+	EOS_HLobbySearch CreateLobbySearchById(const FString& LobbyId);
+	EOS_HLobbySearch CreateFriendLobbySearch(int32 LocalUserNum, const FUniqueNetId& Friend);
+	void StartFriendSessionSearches(const TSharedRef<FFriendSessionSearch>& FriendSearch);
+
+	/** FindSessions split on SEARCH_EOSWRAPPER_PARTITION_KEY, one regular search per partition value */
+	struct FPartitionedSearch
+	{
+		explicit FPartitionedSearch(const TSharedRef<FOnlineSessionSearch>& InSearchSettings)
+			: SearchSettings(InSearchSettings)
+		{
+		}
+
+		TSharedRef<FOnlineSessionSearch> SearchSettings;
+		int32 SearchingPlayerNum = 0;
+		bool bLobbies = false;
+		FName PartitionKey;
+		TArray<FVariantData> PartitionValues;
+		int32 NextPartitionIndex = 0;
+		int32 NumInFlight = 0;
+		int32 NumPagesFetched = 0;
+		int32 NumPagesFailed = 0;
+		/** Set once the first batch of partitions was sent, completion is reported from then on */
+		bool bStarted = false;
+		double StartTimeInSeconds = 0.0;
+		TSet<FString> FoundSessionIds;
+	};
+	int32 PartitionedSearchMaxParallelSearches = 4;
+	FEOSPartitionedSearchMetrics LastPartitionedSearchMetrics;
+
+	uint32 StartPartitionedSearch(const TSharedRef<FPartitionedSearch>& PartitionedSearch);
+	void StartSearchPartitions(const TSharedRef<FPartitionedSearch>& PartitionedSearch);
+	void CompletePartitionedSearch(const TSharedRef<FPartitionedSearch>& PartitionedSearch);
+
 	// Lobby notification callbacks and methods
 	EOS_NotificationId LobbyUpdateReceivedId;
 	FCallbackBase* LobbyUpdateReceivedCallback;
@@ -175,52 +282,231 @@ private:
 	void SetInvitesAllowed(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
 	void SetJoinInProgress(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
 	void AddAttribute(EOS_HSessionModification SessionModHandle, const EOS_Sessions_AttributeData* Attribute);
-	void SetAttributes(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session);
+	void RemoveAttribute(EOS_HSessionModification SessionModHandle, const FName& Key);
+
+	/** Everything an update pushes to EOS for a session or lobby, used to only send what changed since the last acknowledged update */
+	struct FSessionAttributeState
+	{
+		TMap<FName, FVariantData> Attributes;
+		/** Local member attributes, lobbies only */
+		TMap<FName, FVariantData> MemberAttributes;
+		int32 PermissionLevel = 0;
+		uint32 MaxPlayers = 0;
+		bool bInvitesAllowed = false;
+		bool bAllowJoinInProgress = false;
+
+		bool Equals(const FSessionAttributeState& Other) const;
+	};
+
+	/** Everything tracked for a named session next to FNamedOnlineSession itself, dropped together with it in RemoveNamedSession */
+	struct FSessionState
+	{
+		/** Last state EOS acknowledged, unset until an update went through */
+		TOptional<FSessionAttributeState> CommittedState;
+		/** Index of every player in FNamedOnlineSession::RegisteredPlayers for constant time membership checks and removals, filled on first use */
+		TOptional<FUniqueNetIdRefIndexMap> RegisteredPlayerIndices;
+		/** Values set through SetLobbyParameter, sent on top of the lobby session settings */
+		TMap<FName, FString> LobbyParameters;
+		/** Game attribute keys of the lobby as of the last update, to notice the ones the owner removed */
+		TSet<FName> LobbyAttributeKeys;
+		/** An update is on the wire, later updates wait until it completed */
+		bool bUpdateInFlight = false;
+		/** This session holds a reference on the metrics player session */
+		bool bAnalyticsStarted = false;
+		/** Players of a session recreated from the snapshot, registered with EOS again once the session exists */
+		TArray<FUniqueNetIdRef> RestoredPlayers;
+		/** The snapshot had the session started, it is started again once recreated */
+		bool bRestoreStarted = false;
+		/** Recreated from the snapshot rather than through CreateSession, so nobody is waiting for its create completion */
+		bool bRestored = false;
+	};
+	TMap<FName, FSessionState> SessionStates;
+	/** Index of every named session in LobbySessions */
+	TMap<FName, int32> SessionIndexByName;
+	/** Lobby id to session name, filled on lookup and checked against the session on every hit */
+	TMap<FString, FName> SessionNamesByLobbyId;
+	/** Sessions holding the metrics player session open */
+	int32 NumAnalyticsSessions = 0;
+
+	const FSessionAttributeState* FindCommittedSessionState(FName SessionName) const;
+
+	void MakeSessionAttributeState(FNamedOnlineSession* Session, FSessionAttributeState& OutState);
+	void MakeLobbyAttributeState(FNamedOnlineSession* Session, FSessionAttributeState& OutState);
+	void CommitSessionAttributeState(FName SessionName, const FSessionAttributeState& StagedState, bool bWasSuccessful);
+
+	/** UpdateSession/SetLobbyParameter calls waiting to be merged into a single backend update */
+	struct FPendingSessionUpdate
+	{
+		double FlushTimeInSeconds = 0.0;
+		/** Number of calls merged so far, each one gets its own completion */
+		int32 NumCallers = 0;
+	};
+	TMap<FName, FPendingSessionUpdate> PendingSessionUpdates;
+
+	/** Registrations waiting for the next tick, sent to EOS as one RegisterPlayers and one UnregisterPlayers call per session */
+	struct FPendingPlayerRegistrations
+	{
+		FUniqueNetIdRefSet PlayersToRegister;
+		FUniqueNetIdRefSet PlayersToUnregister;
+		/** Player lists of every RegisterPlayers/UnregisterPlayers call merged in, each one gets its own completion */
+		TArray<TArray<FUniqueNetIdRef>> RegisterCallers;
+		TArray<TArray<FUniqueNetIdRef>> UnregisterCallers;
+	};
+	TMap<FName, FPendingPlayerRegistrations> PendingPlayerRegistrations;
+	/** Lobby member status notifications waiting for the next tick, resolved with a single ResolveUniqueNetIds call */
+	struct FPendingMemberStatus
+	{
+		FUniqueNetIdEOSLobbyRef LobbyNetId;
+		EOS_ProductUserId TargetUserId;
+		EOS_ELobbyMemberStatus Status;
+	};
+	TArray<FPendingMemberStatus> PendingMemberStatuses;
+	bool bMemberStatusResolveInFlight = false;
+	/** How long update calls are held back to be merged, 0 sends them right away */
+	double SessionUpdateCoalescingWindowInSeconds = 0.0;
+
+	/** Client side ranking applied to FindSessions results */
+	FEOSSessionRankingSettings SearchRankingSettings;
+
+	/** Client side matchmaking behind StartMatchmaking */
+	FEOSMatchmakingSettings MatchmakingSettings;
+	TSharedPtr<FEOSMatchmaker> Matchmaker;
+
+	/** Measures PingInMs for PingSearchResults */
+	TUniquePtr<FEOSQosProber> QosProber;
+	/** Answers QoS probes on dedicated servers, port advertised as SETTING_EOSWRAPPER_QOSPORT */
+	TUniquePtr<FEOSQosResponder> QosResponder;
+
+	/** Socket LAN sessions are advertised and searched with, open while either is happening */
+	TUniquePtr<FEOSLanBeacon> LanBeacon;
+	struct FPendingLanQuery
+	{
+		/** Host byte order */
+		uint32 Ip = 0;
+		int32 Port = 0;
+		uint64 Nonce = 0;
+		uint16 Sequence = 0;
+	};
+	/** Queries received this tick, answered together once the socket is drained */
+	TArray<FPendingLanQuery> PendingLanQueries;
+	/** Response packets of the current tick back to back, built once for all querying clients */
+	TArray<uint8> LanResponseBuffer;
+	TArray<int32> LanResponsePacketOffsets;
+	TArray<uint8> LanSessionBuffer;
+	TArray<uint8> LanQueryBuffer;
+	/** Nonce of the running LAN search, responses to anything else are ignored */
+	uint64 LanSearchNonce = 0;
+	/** Send time of every query of the running LAN search, indexed by sequence */
+	TArray<double> LanQuerySendTimes;
+	/** Index of every session the running LAN search found in its results, by session id */
+	TMap<FString, int32> LanSearchResultIndices;
+	double LanNextQueryTimeInSeconds = 0.0;
+	double LanQueryIntervalInSeconds = 0.25;
+	int32 LanBeaconPort = 14001;
+	bool bLanSessionDiscovered = false;
+
+	/** Hosted EOS sessions saved to disk so a restarted dedicated server can recreate them, empty path disables it */
+	FString SessionSnapshotPath;
+	double SessionSnapshotIntervalInSeconds = 5.0;
+	double NextSessionSnapshotTimeInSeconds = 0.0;
+	/** Contents of the last snapshot written, the file is only rewritten when this changes */
+	TArray<uint8> LastSessionSnapshot;
+	TArray<uint8> SessionSnapshotBuffer;
+	/** Set while the snapshot is read back, sessions that fail to restore must not overwrite it before the rest are recreated */
+	bool bRestoringSessionSnapshot = false;
+
+	void QueueSessionUpdate(FName SessionName);
+	/** Queues an update that skips the coalescing window, it still waits for an update already in flight */
+	void FlushSessionUpdate(FName SessionName);
+	bool CanSendSessionUpdate(FName SessionName);
+	void SendSessionUpdate(FName SessionName);
+	void CompleteSessionUpdate(FName SessionName, bool bWasSuccessful, int32 NumCallers);
+	void TickSessionUpdates();
+	FUniqueNetIdRefIndexMap& GetRegisteredPlayerIndices(const FNamedOnlineSession& Session);
+	void TickPlayerRegistrations();
+	void TickMemberStatuses();
+	void ApplyMemberStatus(const FPendingMemberStatus& MemberStatus, const FUniqueNetIdEOSRef& ResolvedUniqueNetId);
+
+	int32 SetAttributes(EOS_HSessionModification SessionModHandle, const FSessionAttributeState& DesiredState, const FSessionAttributeState* CommittedState);
 	typedef TEOSCallback<EOS_Sessions_OnUpdateSessionCallback, EOS_Sessions_UpdateSessionCallbackInfo, FEOSWrapperSessionManager> FUpdateSessionCallback;
-	uint32 SharedSessionUpdate(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session, FUpdateSessionCallback* Callback);
+	uint32 SharedSessionUpdate(EOS_HSessionModification SessionModHandle, FNamedOnlineSession* Session, FUpdateSessionCallback* Callback, const FSessionAttributeState& DesiredState);
 
 	void BeginSessionAnalytics(FNamedOnlineSession* Session);
-	void EndSessionAnalytics();
+	void EndSessionAnalytics(FName SessionName);
 
 	// Methods to update an API Lobby from an OSS Lobby
 	void SetLobbyPermissionLevel(EOS_HLobbyModification LobbyModificationHandle, FNamedOnlineSession* Session);
 	void SetLobbyMaxMembers(EOS_HLobbyModification LobbyModificationHandle, FNamedOnlineSession* Session);
-	void SetLobbyAttributes(EOS_HLobbyModification LobbyModificationHandle, FNamedOnlineSession* Session);
+	int32 SetLobbyAttributes(EOS_HLobbyModification LobbyModificationHandle, const FSessionAttributeState& DesiredState, const FSessionAttributeState* CommittedState);
 	void AddLobbyAttribute(EOS_HLobbyModification LobbyModificationHandle, const EOS_Lobby_AttributeData* Attribute);
 	void AddLobbyMemberAttribute(EOS_HLobbyModification LobbyModificationHandle, const EOS_Lobby_AttributeData* Attribute);
+	void RemoveLobbyAttribute(EOS_HLobbyModification LobbyModificationHandle, const FName& Key);
+	void RemoveLobbyMemberAttribute(EOS_HLobbyModification LobbyModificationHandle, const FName& Key);
 
 	// Methods to update an OSS Lobby from an API Lobby
 	typedef TFunction<void(bool bWasSuccessful)> FOnCopyLobbyDataCompleteCallback;
-	void CopyLobbyData(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, FOnlineSession& OutSession, const FOnCopyLobbyDataCompleteCallback& Callback);
-	void CopyLobbyAttributes(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, FOnlineSession& OutSession);
-	void CopyLobbyMemberAttributes(const FLobbyDetailsEOS& LobbyDetails, const EOS_ProductUserId& TargetUserId, FSessionSettings& OutSessionSettings);
+	/** Copies a lobby search result into OutSession, which must belong to OwningSearch. Member attributes are filled in asynchronously once member ids resolve */
+	void CopyLobbyData(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, const TSharedRef<FOnlineSessionSearch>& OwningSearch, FOnlineSession& OutSession,
+		const FOnCopyLobbyDataCompleteCallback& Callback);
+	bool CopyLobbyInfo(const EOS_LobbyDetails_Info* LobbyDetailsInfo, FOnlineSession& OutSession);
+	bool CopyLobbyAttributes(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, FOnlineSession& OutSession, TSet<FName>* OutAttributeKeys = nullptr);
+	bool CopyLobbyMemberAttributes(const FLobbyDetailsEOS& LobbyDetails, const EOS_ProductUserId& TargetUserId, FSessionSettings& OutSessionSettings);
+	/** Applies a lobby update notification to a session we're in, touching only what changed */
+	void ApplyLobbyUpdate(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, EOS_LobbyDetails_Info* LobbyDetailsInfo, FNamedOnlineSession& Session);
 	void AddLobbySearchAttribute(EOS_HLobbySearch LobbySearchHandle, const EOS_Lobby_AttributeData* Attribute, EOS_EOnlineComparisonOp ComparisonOp);
-	void AddLobbySearchResult(const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnCopyLobbyDataCompleteCallback& Callback);
+	void AddLobbySearchResult(
+		const TSharedRef<FLobbyDetailsEOS>& LobbyDetails, const TSharedRef<FOnlineSessionSearch>& SearchSettings, double SearchStartInSeconds, const FOnCopyLobbyDataCompleteCallback& Callback);
 	void UpdateOrAddLobbyMember(const FUniqueNetIdEOSLobbyRef& LobbyNetId, const FUniqueNetIdEOSRef& PlayerId);
 
 	void TickLanTasks(float DeltaTime);
 
+	// LAN sessions
+	uint32 CreateLANSession(int32 HostingPlayerNum, FNamedOnlineSession* Session);
+	uint32 JoinLANSession(int32 PlayerNum, FNamedOnlineSession* Session, const FOnlineSession* SearchSession);
+	uint32 FindLANSession();
+	bool StartLanBeacon();
+	bool IsLanSessionAdvertised(const FNamedOnlineSession& Session) const;
+	bool HasAdvertisedLanSession() const;
+	void SendLanQuery(double Now);
+	void AddPendingLanQuery(const FEOSLanPacketHeader& Header, const FInternetAddr& FromAddress);
+	void SendLanResponses();
+	void OnLanResponseReceived(const FEOSLanPacketHeader& Header, FEOSLanPacketReader& Reader, const FInternetAddr& FromAddress, double Now);
+	void CompleteLanSearch();
+	/** Ranks the results of a finished FindSessions search, keeping all of them until PingSearchResults when ranking weighs ping */
+	void RankCompletedSearch(FOnlineSessionSearch& Search);
+	void AppendSessionToPacket(FEOSLanPacketWriter& Writer, const FNamedOnlineSession& Session) const;
+	bool ReadSessionFromPacket(FEOSLanPacketReader& Reader, const FInternetAddr& FromAddress, FOnlineSession& OutSession) const;
+
+	// Session snapshots
+	bool ShouldSnapshotSession(const FNamedOnlineSession& Session) const;
+	void WriteSessionSnapshot(FEOSLanPacketWriter& Writer) const;
+	void TickSessionSnapshot();
+	void SaveSessionSnapshot();
+	void RestoreSessionSnapshot();
+	bool RestoreSession(FEOSLanPacketReader& Reader);
+
 	// EOS Sessions
-	uint32 CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineSession* Session);
+	/** SessionId reuses the id of a session restored from a snapshot, a new one is assigned when empty */
+	uint32 CreateEOSSession(int32 HostingPlayerNum, FNamedOnlineSession* Session, const FString& SessionId = FString());
 	uint32 JoinEOSSession(int32 PlayerNum, FNamedOnlineSession* Session, const FOnlineSession* SearchSession);
 	uint32 StartEOSSession(FNamedOnlineSession* Session);
-	uint32 UpdateEOSSession(FNamedOnlineSession* Session);
+	uint32 UpdateEOSSession(FNamedOnlineSession* Session, int32 NumCallers = 1);
 	uint32 EndEOSSession(FNamedOnlineSession* Session);
 	uint32 DestroyEOSSession(FNamedOnlineSession* Session, const FOnDestroySessionCompleteDelegate& CompletionDelegate);
 	uint32 FindEOSSession(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings);
+	/** Creates and starts an EOS session search for the query settings, without touching the current search */
+	uint32 StartEOSSessionSearch(int32 SearchingPlayerNum, const TSharedRef<FOnlineSessionSearch>& SearchSettings, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate);
 	bool SendEOSSessionInvite(FName SessionName, EOS_ProductUserId SenderId, EOS_ProductUserId ReceiverId);
 	void FindEOSSessionById(int32 SearchingPlayerNum, const FUniqueNetId& SessionId, const FOnSingleSessionResultCompleteDelegate& CompletionDelegate);
 
 	/** Cached pointer to owning subsystem */
 	FEOSWrapperSubsystem* EOSSubsystem;
-	TArray<TSharedRef<FLobbyDetailsEOS>> PendingLobbySearchResults;
 	TMap<FString, TSharedRef<FLobbyDetailsEOS>> LobbySearchResultsCache;
-	/** Current search object */
+	/** Search started through FindSessions, lobby and EOS session searches started internally own their state instead */
 	TSharedPtr<FOnlineSessionSearch> CurrentSessionSearch;
 	/** Current search start time. */
 	double SessionSearchStartInSeconds;
 
-	bool bLobbyCreated = false;
 	bool bIsDedicatedServer = false;
 	bool bIsUsingP2PSockets = false;
 
@@ -231,12 +517,13 @@ private:
 	TArray<FNamedOnlineSession> LobbySessions;
 	/** The last accepted invite search. It searches by session id */
 	TSharedPtr<FOnlineSessionSearch> LastInviteSearch;
-	/** EOS handle wrapper to hold onto it for scope of the search */
-	TSharedPtr<FSessionSearchEOS> CurrentSearchHandle;
 
 	/** Notification state for SDK events */
 	EOS_NotificationId SessionInviteAcceptedId;
 	FCallbackBase* SessionInviteAcceptedCallback;
+
+	/** Backing storage for attribute strings while a modification or search is being staged */
+	FEOSAttributeArena AttributeArena;
 };
 
 typedef TSharedPtr<FEOSWrapperSessionManager, ESPMode::ThreadSafe> FEOSWrapperSessionManagerPtr;
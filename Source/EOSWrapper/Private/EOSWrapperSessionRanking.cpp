@@ -0,0 +1,195 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperSessionRanking.h"
+#include "EOSWrapperSessionSearch.h"
+#include "EOSWrapperTypes.h"
+#include "OnlineSessionSettings.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rank search results"), STAT_EOSWrapper_RankSearchResults, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Search results ranked"), STAT_EOSWrapper_SearchResultsRanked, STATGROUP_EOSWrapper);
+
+bool FEOSSessionSearchRanker::GetNumericValue(const FVariantData& Data, double& OutValue)
+{
+	switch (Data.GetType())
+	{
+		case EOnlineKeyValuePairDataType::Int32:
+		{
+			int32 Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt32:
+		{
+			uint32 Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Int64:
+		{
+			int64 Value;
+			Data.GetValue(Value);
+			OutValue = (double)Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::UInt64:
+		{
+			uint64 Value;
+			Data.GetValue(Value);
+			OutValue = (double)Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Value;
+			Data.GetValue(Value);
+			OutValue = Value;
+			return true;
+		}
+		case EOnlineKeyValuePairDataType::Double:
+		{
+			Data.GetValue(OutValue);
+			return true;
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+bool FEOSSessionSearchRanker::IsRankingSearchParam(const FName& Key)
+{
+	return Key == SEARCH_EOSWRAPPER_RANK_TOPK || Key == SEARCH_EOSWRAPPER_RANK_SKILLBAND || Key == SEARCH_EOSWRAPPER_RANK_REGION;
+}
+
+void FEOSSessionSearchRanker::RankSearchResults(const FEOSSessionRankingSettings& Settings, FOnlineSessionSearch& Search, bool bKeepAllResults)
+{
+	int32 TopK = Settings.TopK;
+	Search.QuerySettings.Get(SEARCH_EOSWRAPPER_RANK_TOPK, TopK);
+	if (bKeepAllResults)
+	{
+		TopK = 0;
+	}
+
+	const int32 NumResults = Search.SearchResults.Num();
+	if (NumResults == 0 || (!Settings.HasWeights() && (TopK <= 0 || TopK >= NumResults)))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_EOSWrapper_RankSearchResults);
+	INC_DWORD_STAT_BY(STAT_EOSWrapper_SearchResultsRanked, NumResults);
+
+	int32 SearcherSkillBand = 0;
+	const bool bHasSearcherSkillBand = Search.QuerySettings.Get(SEARCH_EOSWRAPPER_RANK_SKILLBAND, SearcherSkillBand);
+	FString PreferredRegion;
+	const bool bHasPreferredRegion = Search.QuerySettings.Get(SEARCH_EOSWRAPPER_RANK_REGION, PreferredRegion) && !PreferredRegion.IsEmpty();
+
+	// One column per scoring term plus the result, padded so the scoring loop always works on full vectors
+	const int32 NumPadded = Align(NumResults, 4);
+	TArray<float> Columns;
+	Columns.SetNumZeroed(NumPadded * 5);
+	float* PingScores = Columns.GetData();
+	float* FillScores = PingScores + NumPadded;
+	float* SkillScores = FillScores + NumPadded;
+	float* RegionScores = SkillScores + NumPadded;
+	float* Scores = RegionScores + NumPadded;
+
+	const float InvMaxPing = Settings.MaxPingInMs > 0 ? 1.f / Settings.MaxPingInMs : 0.f;
+	const float InvMaxSkillBandDifference = Settings.MaxSkillBandDifference > 0 ? 1.f / Settings.MaxSkillBandDifference : 0.f;
+
+	// Gather every term normalized to [0, 1] in its own column
+	for (int32 Index = 0; Index < NumResults; Index++)
+	{
+		const FOnlineSessionSearchResult& SearchResult = Search.SearchResults[Index];
+		const FOnlineSession& Session = SearchResult.Session;
+
+		if (SearchResult.PingInMs >= 0 && SearchResult.PingInMs < MAX_QUERY_PING && InvMaxPing > 0.f)
+		{
+			PingScores[Index] = 1.f - FMath::Min(SearchResult.PingInMs * InvMaxPing, 1.f);
+		}
+
+		const int32 MaxConnections = Session.SessionSettings.NumPublicConnections + Session.SessionSettings.NumPrivateConnections;
+		const int32 OpenConnections = Session.NumOpenPublicConnections + Session.NumOpenPrivateConnections;
+		if (MaxConnections > 0)
+		{
+			FillScores[Index] = OpenConnections > 0 ? (float)(MaxConnections - OpenConnections) / MaxConnections : -1.f;
+		}
+
+		const FOnlineSessionSetting* SkillBandSetting = bHasSearcherSkillBand ? Session.SessionSettings.Settings.Find(SETTING_EOSWRAPPER_SKILLBAND) : nullptr;
+		double SessionSkillBand;
+		if (SkillBandSetting && GetNumericValue(SkillBandSetting->Data, SessionSkillBand))
+		{
+			const float SkillBandDifference = FMath::Abs((float)(SessionSkillBand - SearcherSkillBand));
+			SkillScores[Index] = InvMaxSkillBandDifference > 0.f ? 1.f - FMath::Min(SkillBandDifference * InvMaxSkillBandDifference, 1.f) : (SkillBandDifference == 0.f ? 1.f : 0.f);
+		}
+
+		FString SessionRegion;
+		if (bHasPreferredRegion && Session.SessionSettings.Get(SETTING_REGION, SessionRegion) && SessionRegion.Equals(PreferredRegion, ESearchCase::IgnoreCase))
+		{
+			RegionScores[Index] = 1.f;
+		}
+	}
+
+	// Score = sum of Weight * Term, four results at a time
+	const VectorRegister4Float PingWeight = VectorSetFloat1(Settings.PingWeight);
+	const VectorRegister4Float FillWeight = VectorSetFloat1(Settings.FillWeight);
+	const VectorRegister4Float SkillWeight = VectorSetFloat1(Settings.SkillWeight);
+	const VectorRegister4Float RegionWeight = VectorSetFloat1(Settings.RegionWeight);
+	for (int32 Index = 0; Index < NumPadded; Index += 4)
+	{
+		VectorRegister4Float Score = VectorMultiply(VectorLoad(PingScores + Index), PingWeight);
+		Score = VectorMultiplyAdd(VectorLoad(FillScores + Index), FillWeight, Score);
+		Score = VectorMultiplyAdd(VectorLoad(SkillScores + Index), SkillWeight, Score);
+		Score = VectorMultiplyAdd(VectorLoad(RegionScores + Index), RegionWeight, Score);
+		VectorStore(Score, Scores + Index);
+	}
+
+	const int32 NumKept = TopK > 0 ? FMath::Min(TopK, NumResults) : NumResults;
+	TArray<int32> Order;
+	SelectTopK(Scores, NumResults, NumKept, Order);
+
+	TArray<FOnlineSessionSearchResult> RankedResults;
+	RankedResults.Reserve(Order.Num());
+	for (int32 Index : Order)
+	{
+		RankedResults.Add(MoveTemp(Search.SearchResults[Index]));
+	}
+	Search.SearchResults = MoveTemp(RankedResults);
+}
+
+void FEOSSessionSearchRanker::SelectTopK(const float* Scores, int32 NumResults, int32 NumKept, TArray<int32>& OutOrder)
+{
+	auto IsBetter = [Scores](int32 A, int32 B) { return Scores[A] > Scores[B] || (Scores[A] == Scores[B] && A < B); };
+
+	OutOrder.Reset(NumKept);
+	if (NumKept < NumResults)
+	{
+		// Heap of the best results seen so far with the worst of them on top, so every other result costs at most one compare
+		auto IsWorse = [&IsBetter](int32 A, int32 B) { return IsBetter(B, A); };
+		for (int32 Index = 0; Index < NumResults; Index++)
+		{
+			if (OutOrder.Num() < NumKept)
+			{
+				OutOrder.HeapPush(Index, IsWorse);
+			}
+			else if (IsBetter(Index, OutOrder.HeapTop()))
+			{
+				OutOrder.HeapPopDiscard(IsWorse);
+				OutOrder.HeapPush(Index, IsWorse);
+			}
+		}
+	}
+	else
+	{
+		for (int32 Index = 0; Index < NumResults; Index++)
+		{
+			OutOrder.Add(Index);
+		}
+	}
+
+	OutOrder.Sort(IsBetter);
+}
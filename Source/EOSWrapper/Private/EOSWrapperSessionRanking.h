@@ -0,0 +1,54 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FOnlineSessionSearch;
+class FVariantData;
+
+/** Weights and bounds used to rank session search results */
+struct FEOSSessionRankingSettings
+{
+	/** Lower ping scores higher, unknown ping scores nothing */
+	float PingWeight = 0.f;
+	/** Fuller sessions score higher, full ones sink to the bottom */
+	float FillWeight = 0.f;
+	/** Sessions closer to the searcher's skill band score higher */
+	float SkillWeight = 0.f;
+	/** Sessions in the searcher's preferred region score higher */
+	float RegionWeight = 0.f;
+	/** Ping at which the ping score reaches zero */
+	int32 MaxPingInMs = 250;
+	/** Skill band difference at which the skill score reaches zero */
+	int32 MaxSkillBandDifference = 5;
+	/** Default number of results to keep, overridden per search by SEARCH_EOSWRAPPER_RANK_TOPK. 0 keeps all of them */
+	int32 TopK = 0;
+
+	bool HasWeights() const { return PingWeight != 0.f || FillWeight != 0.f || SkillWeight != 0.f || RegionWeight != 0.f; }
+};
+
+/**
+ * Client side ranking stage for session and lobby search results.
+ * Results are scored in batches over a structure of arrays copy of the values we rank on, then the best K are kept sorted by descending score.
+ */
+class FEOSSessionSearchRanker
+{
+public:
+	/**
+	 * Ranks the results of a completed search in place. Without weights and without a top K the backend order is left untouched.
+	 * With bKeepAllResults the top K is not applied, so results can be ranked again without losing any once their ping is known.
+	 */
+	static void RankSearchResults(const FEOSSessionRankingSettings& Settings, FOnlineSessionSearch& Search, bool bKeepAllResults = false);
+
+	/** True for search parameters consumed by the ranking stage, these must not be sent to the backend */
+	static bool IsRankingSearchParam(const FName& Key);
+
+	/** Attribute values copied from EOS come back as whatever numeric type the host advertised */
+	static bool GetNumericValue(const FVariantData& Data, double& OutValue);
+
+private:
+	/** Indices of the best NumKept results, best first. Ties keep the backend order */
+	static void SelectTopK(const float* Scores, int32 NumResults, int32 NumKept, TArray<int32>& OutOrder);
+};
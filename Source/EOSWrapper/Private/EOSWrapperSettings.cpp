@@ -141,6 +141,36 @@ const FEOSWrapperSettings& UEOSWrapperSettings::ManualGetSettings()
 		GConfig->GetString(INI_SECTION, TEXT("DefaultArtifactName"), CachedSettings->DefaultArtifactName, GEngineIni);
 		GConfig->GetInt(INI_SECTION, TEXT("TickBudgetInMilliseconds"), CachedSettings->TickBudgetInMilliseconds, GEngineIni);
 		GConfig->GetInt(INI_SECTION, TEXT("TitleStorageReadChunkLength"), CachedSettings->TitleStorageReadChunkLength, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("SessionUpdateCoalescingWindowInMilliseconds"), CachedSettings->SessionUpdateCoalescingWindowInMilliseconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("FriendSessionSearchMaxParallelSearches"), CachedSettings->FriendSessionSearchMaxParallelSearches, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("PartitionedSearchMaxParallelSearches"), CachedSettings->PartitionedSearchMaxParallelSearches, GEngineIni);
+		GConfig->GetString(INI_SECTION, TEXT("SessionSnapshotPath"), CachedSettings->SessionSnapshotPath, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("SessionSnapshotIntervalInSeconds"), CachedSettings->SessionSnapshotIntervalInSeconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("RecentPlayersCapacity"), CachedSettings->RecentPlayersCapacity, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("RecentPlayersSaveDebounceInMilliseconds"), CachedSettings->RecentPlayersSaveDebounceInMilliseconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("PresenceUpdateDebounceInMilliseconds"), CachedSettings->PresenceUpdateDebounceInMilliseconds, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("UnmappedProductUserIdCacheTimeInSeconds"), CachedSettings->UnmappedProductUserIdCacheTimeInSeconds, GEngineIni);
+		GConfig->GetBool(INI_SECTION, TEXT("bVerifyIdTokensLocally"), CachedSettings->bVerifyIdTokensLocally, GEngineIni);
+		GConfig->GetString(INI_SECTION, TEXT("IdTokenSigningKeysLocation"), CachedSettings->IdTokenSigningKeysLocation, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("IdTokenVerificationMaxWorkers"), CachedSettings->IdTokenVerificationMaxWorkers, GEngineIni);
+		GConfig->GetArray(INI_SECTION, TEXT("IdTokenAcceptedAudiences"), CachedSettings->IdTokenAcceptedAudiences, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("SearchRankingPingWeight"), CachedSettings->SearchRankingPingWeight, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("SearchRankingFillWeight"), CachedSettings->SearchRankingFillWeight, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("SearchRankingSkillWeight"), CachedSettings->SearchRankingSkillWeight, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("SearchRankingRegionWeight"), CachedSettings->SearchRankingRegionWeight, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("SearchRankingMaxPingInMs"), CachedSettings->SearchRankingMaxPingInMs, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("SearchRankingMaxSkillBandDifference"), CachedSettings->SearchRankingMaxSkillBandDifference, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("SearchRankingTopK"), CachedSettings->SearchRankingTopK, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("MatchmakingRoundIntervalInSeconds"), CachedSettings->MatchmakingRoundIntervalInSeconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("MatchmakingMaxSkillBandRadius"), CachedSettings->MatchmakingMaxSkillBandRadius, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("MatchmakingMaxParallelSearches"), CachedSettings->MatchmakingMaxParallelSearches, GEngineIni);
+		GConfig->GetFloat(INI_SECTION, TEXT("MatchmakingCreateLobbyAfterSeconds"), CachedSettings->MatchmakingCreateLobbyAfterSeconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("QosSamplesPerHost"), CachedSettings->QosSamplesPerHost, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("QosSampleIntervalInMilliseconds"), CachedSettings->QosSampleIntervalInMilliseconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("QosTimeoutInMilliseconds"), CachedSettings->QosTimeoutInMilliseconds, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("QosResponderPort"), CachedSettings->QosResponderPort, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("LanBeaconPort"), CachedSettings->LanBeaconPort, GEngineIni);
+		GConfig->GetInt(INI_SECTION, TEXT("LanQueryIntervalInMilliseconds"), CachedSettings->LanQueryIntervalInMilliseconds, GEngineIni);
 		GConfig->GetBool(INI_SECTION, TEXT("bEnableOverlay"), CachedSettings->bEnableOverlay, GEngineIni);
 		GConfig->GetBool(INI_SECTION, TEXT("bEnableSocialOverlay"), CachedSettings->bEnableSocialOverlay, GEngineIni);
 		GConfig->GetBool(INI_SECTION, TEXT("bEnableEditorOverlay"), CachedSettings->bEnableEditorOverlay, GEngineIni);
@@ -166,6 +196,36 @@ FEOSWrapperSettings UEOSWrapperSettings::ToNative() const
 	Native.DefaultArtifactName = DefaultArtifactName;
 	Native.TickBudgetInMilliseconds = TickBudgetInMilliseconds;
 	Native.TitleStorageReadChunkLength = TitleStorageReadChunkLength;
+	Native.SessionUpdateCoalescingWindowInMilliseconds = SessionUpdateCoalescingWindowInMilliseconds;
+	Native.FriendSessionSearchMaxParallelSearches = FriendSessionSearchMaxParallelSearches;
+	Native.PartitionedSearchMaxParallelSearches = PartitionedSearchMaxParallelSearches;
+	Native.SessionSnapshotPath = SessionSnapshotPath;
+	Native.SessionSnapshotIntervalInSeconds = SessionSnapshotIntervalInSeconds;
+	Native.RecentPlayersCapacity = RecentPlayersCapacity;
+	Native.RecentPlayersSaveDebounceInMilliseconds = RecentPlayersSaveDebounceInMilliseconds;
+	Native.PresenceUpdateDebounceInMilliseconds = PresenceUpdateDebounceInMilliseconds;
+	Native.UnmappedProductUserIdCacheTimeInSeconds = UnmappedProductUserIdCacheTimeInSeconds;
+	Native.bVerifyIdTokensLocally = bVerifyIdTokensLocally;
+	Native.IdTokenSigningKeysLocation = IdTokenSigningKeysLocation;
+	Native.IdTokenVerificationMaxWorkers = IdTokenVerificationMaxWorkers;
+	Native.IdTokenAcceptedAudiences = IdTokenAcceptedAudiences;
+	Native.SearchRankingPingWeight = SearchRankingPingWeight;
+	Native.SearchRankingFillWeight = SearchRankingFillWeight;
+	Native.SearchRankingSkillWeight = SearchRankingSkillWeight;
+	Native.SearchRankingRegionWeight = SearchRankingRegionWeight;
+	Native.SearchRankingMaxPingInMs = SearchRankingMaxPingInMs;
+	Native.SearchRankingMaxSkillBandDifference = SearchRankingMaxSkillBandDifference;
+	Native.SearchRankingTopK = SearchRankingTopK;
+	Native.MatchmakingRoundIntervalInSeconds = MatchmakingRoundIntervalInSeconds;
+	Native.MatchmakingMaxSkillBandRadius = MatchmakingMaxSkillBandRadius;
+	Native.MatchmakingMaxParallelSearches = MatchmakingMaxParallelSearches;
+	Native.MatchmakingCreateLobbyAfterSeconds = MatchmakingCreateLobbyAfterSeconds;
+	Native.QosSamplesPerHost = QosSamplesPerHost;
+	Native.QosSampleIntervalInMilliseconds = QosSampleIntervalInMilliseconds;
+	Native.QosTimeoutInMilliseconds = QosTimeoutInMilliseconds;
+	Native.QosResponderPort = QosResponderPort;
+	Native.LanBeaconPort = LanBeaconPort;
+	Native.LanQueryIntervalInMilliseconds = LanQueryIntervalInMilliseconds;
 	Native.bEnableOverlay = bEnableOverlay;
 	Native.bEnableSocialOverlay = bEnableSocialOverlay;
 	Native.bEnableEditorOverlay = bEnableEditorOverlay;
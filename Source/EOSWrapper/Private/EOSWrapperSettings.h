@@ -59,6 +59,36 @@ struct FEOSWrapperSettings
 	FString DefaultArtifactName;
 	int32 TickBudgetInMilliseconds;
 	int32 TitleStorageReadChunkLength;
+	int32 SessionUpdateCoalescingWindowInMilliseconds = 100;
+	int32 FriendSessionSearchMaxParallelSearches = 4;
+	int32 PartitionedSearchMaxParallelSearches = 4;
+	FString SessionSnapshotPath;
+	float SessionSnapshotIntervalInSeconds = 5.f;
+	int32 RecentPlayersCapacity = 50;
+	int32 RecentPlayersSaveDebounceInMilliseconds = 5000;
+	int32 PresenceUpdateDebounceInMilliseconds = 250;
+	float UnmappedProductUserIdCacheTimeInSeconds = 300.f;
+	bool bVerifyIdTokensLocally = false;
+	FString IdTokenSigningKeysLocation = TEXT("https://api.epicgames.dev/epic/oauth/v1/.well-known/jwks.json");
+	int32 IdTokenVerificationMaxWorkers = 4;
+	TArray<FString> IdTokenAcceptedAudiences;
+	float SearchRankingPingWeight = 0.f;
+	float SearchRankingFillWeight = 0.f;
+	float SearchRankingSkillWeight = 0.f;
+	float SearchRankingRegionWeight = 0.f;
+	int32 SearchRankingMaxPingInMs = 250;
+	int32 SearchRankingMaxSkillBandDifference = 5;
+	int32 SearchRankingTopK = 0;
+	float MatchmakingRoundIntervalInSeconds = 2.f;
+	int32 MatchmakingMaxSkillBandRadius = 3;
+	int32 MatchmakingMaxParallelSearches = 4;
+	float MatchmakingCreateLobbyAfterSeconds = 10.f;
+	int32 QosSamplesPerHost = 3;
+	int32 QosSampleIntervalInMilliseconds = 20;
+	int32 QosTimeoutInMilliseconds = 1000;
+	int32 QosResponderPort = 0;
+	int32 LanBeaconPort = 14001;
+	int32 LanQueryIntervalInMilliseconds = 250;
 	bool bEnableOverlay;
 	bool bEnableSocialOverlay;
 	bool bEnableEditorOverlay;
@@ -122,6 +152,126 @@ public:
 	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
 	int32 TitleStorageReadChunkLength = 0;
 
+	/** UpdateSession/SetLobbyParameter calls made within this window are merged into a single backend update, 0 sends every call immediately */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "0"))
+	int32 SessionUpdateCoalescingWindowInMilliseconds = 100;
+
+	/** Lobby searches FindFriendSession runs at the same time when given a list of friends */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "1"))
+	int32 FriendSessionSearchMaxParallelSearches = 4;
+
+	/** Partition queries a FindSessions call split with SEARCH_EOSWRAPPER_PARTITION_KEY runs at the same time */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "1"))
+	int32 PartitionedSearchMaxParallelSearches = 4;
+
+	/** File dedicated servers save their hosted EOS sessions to and recreate them from on startup, relative to the project Saved directory. Empty disables snapshots */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
+	FString SessionSnapshotPath;
+
+	/** Minimum time between two session snapshot writes, nothing is written while the sessions don't change */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "0"))
+	float SessionSnapshotIntervalInSeconds = 5.f;
+
+	/** Number of players kept in each local user's recent players list, the least recently seen one drops out first */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "1"))
+	int32 RecentPlayersCapacity = 50;
+
+	/** Recent player changes made within this time are written to disk together, 0 writes them on the next tick */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "0"))
+	int32 RecentPlayersSaveDebounceInMilliseconds = 5000;
+
+	/** SetPresence calls made within this time are merged into a single update, 0 sends every call that changes something right away */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "0"))
+	int32 PresenceUpdateDebounceInMilliseconds = 250;
+
+	/** How long a product user id without an Epic account (e.g. a crossplay only player) is remembered before ResolveUniqueNetIds asks EOS again */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "0"))
+	float UnmappedProductUserIdCacheTimeInSeconds = 300.f;
+
+	/** Verify user auth tokens against cached signing keys instead of asking the backend for each one, tokens that can't be checked locally still go to the backend */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
+	bool bVerifyIdTokensLocally = false;
+
+	/** JWKS document with the ID token signing keys, either an URL or a file path relative to the project directory */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
+	FString IdTokenSigningKeysLocation = TEXT("https://api.epicgames.dev/epic/oauth/v1/.well-known/jwks.json");
+
+	/** Number of worker threads a batch of tokens is spread over when verifying locally */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings", meta = (ClampMin = "1"))
+	int32 IdTokenVerificationMaxWorkers = 4;
+
+	/** Client ids a locally verified token may be issued to (its aud claim), usually the game client's. Empty accepts the client id of the running artifact */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
+	TArray<FString> IdTokenAcceptedAudiences;
+
+	/** How much a low ping counts when ranking session search results */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking")
+	float SearchRankingPingWeight = 0.f;
+
+	/** How much a nearly full session counts when ranking session search results */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking")
+	float SearchRankingFillWeight = 0.f;
+
+	/** How much a matching SKILLBAND setting counts when ranking session search results */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking")
+	float SearchRankingSkillWeight = 0.f;
+
+	/** How much a matching REGION setting counts when ranking session search results */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking")
+	float SearchRankingRegionWeight = 0.f;
+
+	/** Ping at which a search result no longer scores for ping */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking", meta = (ClampMin = "1"))
+	int32 SearchRankingMaxPingInMs = 250;
+
+	/** Skill band difference at which a search result no longer scores for skill */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking", meta = (ClampMin = "0"))
+	int32 SearchRankingMaxSkillBandDifference = 5;
+
+	/** Number of ranked search results to keep, 0 keeps all of them. With a ping weight results are only cut down once PingSearchResults measured them */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Session Search Ranking", meta = (ClampMin = "0"))
+	int32 SearchRankingTopK = 0;
+
+	/** Time between lobby search rounds while StartMatchmaking hasn't found a match */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Matchmaking", meta = (ClampMin = "0"))
+	float MatchmakingRoundIntervalInSeconds = 2.f;
+
+	/** How many skill bands around the player's own matchmaking widens to, one band per round, before it stops filtering on skill */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Matchmaking", meta = (ClampMin = "0"))
+	int32 MatchmakingMaxSkillBandRadius = 3;
+
+	/** Lobby searches a matchmaking ticket runs at the same time */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Matchmaking", meta = (ClampMin = "1"))
+	int32 MatchmakingMaxParallelSearches = 4;
+
+	/** Time after which matchmaking that found nothing to join creates its own lobby */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Matchmaking", meta = (ClampMin = "0"))
+	float MatchmakingCreateLobbyAfterSeconds = 10.f;
+
+	/** Number of probes PingSearchResults sends to every host, the reported ping is the median of the answered ones */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "QoS", meta = (ClampMin = "1"))
+	int32 QosSamplesPerHost = 3;
+
+	/** Time between two probes to the same host */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "QoS", meta = (ClampMin = "0"))
+	int32 QosSampleIntervalInMilliseconds = 20;
+
+	/** Probes not answered within this time count as lost */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "QoS", meta = (ClampMin = "1"))
+	int32 QosTimeoutInMilliseconds = 1000;
+
+	/** UDP port dedicated servers answer QoS probes on and advertise in their sessions, 0 disables the responder */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "QoS", meta = (ClampMin = "0", ClampMax = "65535"))
+	int32 QosResponderPort = 0;
+
+	/** UDP port LAN sessions are advertised and searched for on */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "LAN", meta = (ClampMin = "1", ClampMax = "65535"))
+	int32 LanBeaconPort = 14001;
+
+	/** Time between query broadcasts while a LAN search is running */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "LAN", meta = (ClampMin = "1"))
+	int32 LanQueryIntervalInMilliseconds = 250;
+
 	/** Per artifact SDK settings. A game might have a FooStaging, FooQA, and public Foo artifact */
 	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "EOS Settings")
 	TArray<FEOSWrapperArtifactSettings> Artifacts;
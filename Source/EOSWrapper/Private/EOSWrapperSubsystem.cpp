@@ -242,13 +242,7 @@ bool FEOSWrapperSubsystem::Init()
 		return false;
 	}
 
-	UserManager = MakeShareable(new FEOSWrapperUserManager(this));
-	UserManager->Initialize();
-
-	SessionManager = MakeShareable(new FEOSWrapperSessionManager(this));
-	SessionManager->Initialize(EOSSDKManager->GetProductName() + TEXT("_") + FString::FromInt(GetBuildUniqueId()));
-
-	// We set the product id
+	// We set the product id, the managers read it and the client id during Initialize
 	FString ArtifactName;
 	FParse::Value(FCommandLine::Get(), TEXT("EpicApp="), ArtifactName);
 	if (!ArtifactName.IsEmpty())
@@ -260,12 +254,19 @@ bool FEOSWrapperSubsystem::Init()
 	if (UEOSWrapperSettings::GetSettingsForArtifact(ArtifactName, ArtifactSettings))
 	{
 		ProductId = ArtifactSettings.ProductId;
+		ClientId = ArtifactSettings.ClientId;
 	}
 	else
 	{
 		UE_LOG_ONLINE(Warning, TEXT("[FEOSWrapperSubsystem::Init] Failed to find artifact settings object for artifact (%s). ProductIdAnsi not set."), *ArtifactName);
 	}
 
+	UserManager = MakeShareable(new FEOSWrapperUserManager(this));
+	UserManager->Initialize();
+
+	SessionManager = MakeShareable(new FEOSWrapperSessionManager(this));
+	SessionManager->Initialize(EOSSDKManager->GetProductName() + TEXT("_") + FString::FromInt(GetBuildUniqueId()));
+
 	StartTicker();
 
 	bInitialized = true;
@@ -292,6 +293,11 @@ bool FEOSWrapperSubsystem::Shutdown()
 	// 	SocketSubsystem = nullptr;
 	// }
 
+	if (SessionManager.IsValid())
+	{
+		SessionManager->Shutdown();
+	}
+
 	// Release our ref to the interfaces. May still exist since they can be aggregated
 	UserManager = nullptr;
 	SessionManager = nullptr;
@@ -333,6 +339,7 @@ bool FEOSWrapperSubsystem::Tick(float DeltaTime)
 	}
 
 	SessionManager->Tick(DeltaTime);
+	UserManager->Tick(DeltaTime);
 	FOnlineSubsystemImpl::Tick(DeltaTime);
 
 	return true;
@@ -90,6 +90,7 @@ public:
 	bool bIsPlatformOSS = false;
 
 	FString ProductId;
+	FString ClientId;
 
 	void ReleaseVoiceChatUserInterface(const FUniqueNetId& LocalUserId);
 
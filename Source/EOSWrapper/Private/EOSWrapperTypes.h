@@ -30,6 +30,9 @@
 #define EOS_CONNECTION_URL_PREFIX TEXT("EOS")
 #endif
 
+/** Counters for the wrapper's own caching and batching, see "stat EOSWrapper" */
+DECLARE_STATS_GROUP(TEXT("EOSWrapper"), STATGROUP_EOSWrapper, STATCAT_Advanced);
+
 class FEOSWrapperSubsystem;
 
 typedef TSharedPtr<const class FUniqueNetIdEOS> FUniqueNetIdEOSPtr;
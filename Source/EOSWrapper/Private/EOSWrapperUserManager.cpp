@@ -6,6 +6,9 @@
 #include "EOSWrapperTypes.h"
 #include "IEOSSDKManager.h"
 #include "OnlineSubsystem.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
 
 #pragma optimize("", off)
 
@@ -23,6 +26,20 @@
 #include "eos_userinfo.h"
 #include "eos_userinfo_types.h"
 
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence updates sent"), STAT_EOSWrapper_PresenceUpdatesSent, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence updates suppressed"), STAT_EOSWrapper_PresenceUpdatesSuppressed, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence notifications received"), STAT_EOSWrapper_PresenceNotificationsReceived, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence copies"), STAT_EOSWrapper_PresenceCopies, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Presence copies unchanged"), STAT_EOSWrapper_PresenceCopiesUnchanged, STATGROUP_EOSWrapper);
+DECLARE_CYCLE_STAT(TEXT("Process presence notifications"), STAT_EOSWrapper_ProcessDirtyPresence, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Product user ids queried"), STAT_EOSWrapper_ProductUserIdsQueried, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Product user id resolves shared"), STAT_EOSWrapper_ProductUserIdResolvesShared, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Unmapped product user id cache hits"), STAT_EOSWrapper_UnmappedProductUserIdCacheHits, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Verified ID token cache hits"), STAT_EOSWrapper_VerifiedIdTokenCacheHits, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Verified ID token cache misses"), STAT_EOSWrapper_VerifiedIdTokenCacheMisses, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Local ID token cache hits"), STAT_EOSWrapper_LocalIdTokenCacheHits, STATGROUP_EOSWrapper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Local ID token cache misses"), STAT_EOSWrapper_LocalIdTokenCacheMisses, STATGROUP_EOSWrapper);
+
 static inline EInviteStatus::Type ToEInviteStatus(EOS_EFriendsStatus InStatus)
 {
 	switch (InStatus)
@@ -118,6 +135,20 @@ FEOSWrapperUserManager::FEOSWrapperUserManager(FEOSWrapperSubsystem* InSubsystem
 
 void FEOSWrapperUserManager::Initialize()
 {
+	const FEOSWrapperSettings Settings = UEOSWrapperSettings::GetSettings();
+	PresenceUpdateDebounceInSeconds = Settings.PresenceUpdateDebounceInMilliseconds / 1000.0;
+	RecentPlayersSaveDebounceInSeconds = Settings.RecentPlayersSaveDebounceInMilliseconds / 1000.0;
+	if (Settings.bVerifyIdTokensLocally)
+	{
+		// Servers usually run with their own client id, so the ids players log in with can be configured
+		TArray<FString> AcceptedAudiences = Settings.IdTokenAcceptedAudiences;
+		if (AcceptedAudiences.Num() == 0 && !EOSSubsystem->ClientId.IsEmpty())
+		{
+			AcceptedAudiences.Add(EOSSubsystem->ClientId);
+		}
+		IdTokenVerifier = MakeUnique<FEOSIdTokenVerifier>(Settings.IdTokenSigningKeysLocation, AcceptedAudiences, Settings.IdTokenVerificationMaxWorkers);
+	}
+
 	// This delegate would cause a crash when running a dedicated server
 	if (!IsRunningDedicatedServer())
 	{
@@ -135,6 +166,9 @@ void FEOSWrapperUserManager::Initialize()
 
 void FEOSWrapperUserManager::Shutdown()
 {
+	// Changes still waiting for the debounce would be lost otherwise
+	SaveDirtyRecentPlayers();
+
 	// This delegate would cause a crash when running a dedicated server
 	if (DisplaySettingsUpdatedId != EOS_INVALID_NOTIFICATIONID)
 	{
@@ -155,6 +189,35 @@ FEOSWrapperUserManager::~FEOSWrapperUserManager()
 	Shutdown();
 }
 
+void FEOSWrapperUserManager::Tick(float DeltaTime)
+{
+	ProcessDirtyPresence();
+	if (IdTokenVerifier.IsValid())
+	{
+		IdTokenVerifier->Tick();
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (DirtyRecentPlayerLists.Num() > 0 && Now >= RecentPlayersSaveTimeInSeconds)
+	{
+		SaveDirtyRecentPlayers();
+	}
+
+	if (LocalPresenceStates.Num() == 0)
+	{
+		return;
+	}
+
+	for (const TPair<EOS_EpicAccountId, FLocalPresenceState>& Pair : LocalPresenceStates)
+	{
+		const FLocalPresenceState& PresenceState = Pair.Value;
+		if (PresenceState.PendingStatus.IsSet() && !PresenceState.bSendInFlight && Now >= PresenceState.SendTimeInSeconds)
+		{
+			SendPresence(Pair.Key);
+		}
+	}
+}
+
 void FEOSWrapperUserManager::LoginStatusChanged(const EOS_Auth_LoginStatusChangedCallbackInfo* Data)
 {
 	if (Data->CurrentStatus == EOS_ELoginStatus::EOS_LS_NotLoggedIn)
@@ -879,8 +942,9 @@ void FEOSWrapperUserManager::FullLoginCallback(int32 LocalUserNum, EOS_EpicAccou
 		{
 			if (EpicAccountIdToOnlineUserMap.Contains(Data->PresenceUserId))
 			{
-				// Update the presence data to the most recent
-				UpdatePresence(Data->PresenceUserId);
+				// Copied on the next tick, so a friends list coming online at once costs one copy per friend
+				INC_DWORD_STAT(STAT_EOSWrapper_PresenceNotificationsReceived);
+				DirtyPresenceAccountIds.Add(Data->PresenceUserId);
 				return;
 			}
 		};
@@ -1017,9 +1081,10 @@ void FEOSWrapperUserManager::AddLocalUser(int32 LocalUserNum, EOS_EpicAccountId
 	NetIdStringToBlockedPlayerListMap.Emplace(NetId, BlockedPlayersList);
 	QueryBlockedPlayers(*UserNetId);
 
-	FRecentPlayersListEOSRef RecentPlayersList = MakeShareable(new FRecentPlayersListEOS(LocalUserNum, UserNetId));
+	FRecentPlayersListEOSRef RecentPlayersList = MakeShareable(new FRecentPlayersListEOS(LocalUserNum, UserNetId, UEOSWrapperSettings::GetSettings().RecentPlayersCapacity));
 	LocalUserNumToRecentPlayerListMap.Emplace(LocalUserNum, RecentPlayersList);
 	NetIdStringToRecentPlayerListMap.Emplace(NetId, RecentPlayersList);
+	LoadRecentPlayers(LocalUserNum);
 
 	// Get auth token info
 	EOS_Auth_Token* AuthToken = nullptr;
@@ -1261,11 +1326,21 @@ void FEOSWrapperUserManager::ResolveUniqueNetId(const EOS_ProductUserId& Product
 
 void FEOSWrapperUserManager::ResolveUniqueNetIds(const TArray<EOS_ProductUserId>& ProductUserIds, const FResolveUniqueNetIdsCallback& Callback) const
 {
-	TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds;
+	// EOS_Connect_QueryProductUserIdMappings takes at most this many ids per call
+	static constexpr int32 MaxProductUserIdsPerQuery = 128;
+
+	TSharedRef<FResolveUniqueNetIdsRequest> Request = MakeShared<FResolveUniqueNetIdsRequest>();
+	Request->Callback = Callback;
 	TArray<EOS_ProductUserId> ProductUserIdsToResolve;
+	const double Now = FPlatformTime::Seconds();
 
 	for (const EOS_ProductUserId& ProductUserId : ProductUserIds)
 	{
+		if (Request->ResolvedUniqueNetIds.Contains(ProductUserId))
+		{
+			continue;
+		}
+
 		EOS_EpicAccountId EpicAccountId;
 
 		// We check first if the Product User Id has already been queried, which would allow us to retrieve its Epic Account Id directly
@@ -1273,53 +1348,115 @@ void FEOSWrapperUserManager::ResolveUniqueNetIds(const TArray<EOS_ProductUserId>
 		{
 			const FUniqueNetIdEOSRef UniqueNetId = FUniqueNetIdEOSRegistry::FindOrAdd(EpicAccountId, ProductUserId).ToSharedRef();
 
-			ResolvedUniqueNetIds.Add(ProductUserId, UniqueNetId);
+			Request->ResolvedUniqueNetIds.Add(ProductUserId, UniqueNetId);
+			continue;
 		}
-		else
+
+		// Players without an Epic account are normal with crossplay, there is nothing new to learn until the entry expires
+		if (const double* ExpiryTime = UnmappedProductUserIdExpiryTimes.Find(ProductUserId))
+		{
+			if (Now < *ExpiryTime)
+			{
+				INC_DWORD_STAT(STAT_EOSWrapper_UnmappedProductUserIdCacheHits);
+				Request->ResolvedUniqueNetIds.Add(ProductUserId, FUniqueNetIdEOSRegistry::FindOrAdd(nullptr, ProductUserId).ToSharedRef());
+				continue;
+			}
+			UnmappedProductUserIdExpiryTimes.Remove(ProductUserId);
+		}
+
+		// If that's not the case, we'll have to query them first, unless another call already does
+		TArray<TSharedRef<FResolveUniqueNetIdsRequest>>* Waiting = InFlightProductUserIdResolves.Find(ProductUserId);
+		if (Waiting == nullptr)
 		{
-			// If that's not the case, we'll have to query them first
+			Waiting = &InFlightProductUserIdResolves.Add(ProductUserId);
 			ProductUserIdsToResolve.Add(ProductUserId);
 		}
+		else if (Waiting->Contains(Request))
+		{
+			continue;
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_EOSWrapper_ProductUserIdResolvesShared);
+		}
+		Waiting->Add(Request);
+		Request->NumPending++;
+	}
+
+	if (Request->NumPending == 0)
+	{
+		Callback(Request->ResolvedUniqueNetIds);
+		return;
 	}
 
-	if (!ProductUserIdsToResolve.IsEmpty())
+	for (int32 QueryStart = 0; QueryStart < ProductUserIdsToResolve.Num(); QueryStart += MaxProductUserIdsPerQuery)
 	{
+		TArray<EOS_ProductUserId> BatchIds(ProductUserIdsToResolve.GetData() + QueryStart, FMath::Min(ProductUserIdsToResolve.Num() - QueryStart, MaxProductUserIdsPerQuery));
+		INC_DWORD_STAT_BY(STAT_EOSWrapper_ProductUserIdsQueried, BatchIds.Num());
+
 		EOS_Connect_QueryProductUserIdMappingsOptions QueryProductUserIdMappingsOptions = {};
 		QueryProductUserIdMappingsOptions.ApiVersion = EOS_CONNECT_QUERYPRODUCTUSERIDMAPPINGS_API_LATEST;
 		QueryProductUserIdMappingsOptions.LocalUserId = EOSSubsystem->UserManager->GetLocalProductUserId(0);
-		QueryProductUserIdMappingsOptions.ProductUserIds = ProductUserIdsToResolve.GetData();
-		QueryProductUserIdMappingsOptions.ProductUserIdCount = ProductUserIdsToResolve.Num();
+		QueryProductUserIdMappingsOptions.ProductUserIds = BatchIds.GetData();
+		QueryProductUserIdMappingsOptions.ProductUserIdCount = BatchIds.Num();
 
 		FConnectQueryProductUserIdMappingsCallback* CallbackObj = new FConnectQueryProductUserIdMappingsCallback(FEOSWrapperUserManagerConstWeakPtr(AsShared()));
-		CallbackObj->CallbackLambda = [this, ProductUserIdsToResolve, ResolvedUniqueNetIds = MoveTemp(ResolvedUniqueNetIds), Callback](
-			const EOS_Connect_QueryProductUserIdMappingsCallbackInfo* Data) mutable
+		CallbackObj->CallbackLambda = [this, BatchIds](const EOS_Connect_QueryProductUserIdMappingsCallbackInfo* Data)
+		{
+			const bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
+			if (!bWasSuccessful)
 			{
-				if (Data->ResultCode != EOS_EResult::EOS_Success)
+				UE_LOG_ONLINE(Verbose, TEXT("[FEOSWrapperUserManager::ResolveUniqueNetIds] EOS_Connect_QueryProductUserIdMappings not successful for user (%s). Finished with EOS_EResult %s."),
+					*LexToString(Data->LocalUserId), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+			}
+
+			const double CallbackTime = FPlatformTime::Seconds();
+			const double UnmappedExpiryTime = CallbackTime + UEOSWrapperSettings::GetSettings().UnmappedProductUserIdCacheTimeInSeconds;
+			if (bWasSuccessful)
+			{
+				for (TMap<EOS_ProductUserId, double>::TIterator It(UnmappedProductUserIdExpiryTimes); It; ++It)
 				{
-					UE_LOG_ONLINE(Verbose, TEXT("[FEOSWrapperUserManager::ResolveUniqueNetIds] EOS_Connect_QueryProductUserIdMappings not successful for user (%s). Finished with EOS_EResult %s."),
-						*LexToString(Data->LocalUserId), ANSI_TO_TCHAR(EOS_EResult_ToString(Data->ResultCode)));
+					if (It.Value() <= CallbackTime)
+					{
+						It.RemoveCurrent();
+					}
 				}
+			}
 
-				for (const EOS_ProductUserId& ProductUserId : ProductUserIdsToResolve)
-				{
-					EOS_EpicAccountId EpicAccountId = nullptr;
+			// Callbacks run after the bookkeeping, they may start new resolves
+			TArray<TSharedRef<FResolveUniqueNetIdsRequest>> CompletedRequests;
+			for (const EOS_ProductUserId& ProductUserId : BatchIds)
+			{
+				EOS_EpicAccountId EpicAccountId = nullptr;
 
-					GetEpicAccountIdFromProductUserId(ProductUserId, EpicAccountId);
+				// Only a successful query tells us the id has no mapping, errors are retried by the next call
+				if (!GetEpicAccountIdFromProductUserId(ProductUserId, EpicAccountId) && bWasSuccessful)
+				{
+					UnmappedProductUserIdExpiryTimes.Add(ProductUserId, UnmappedExpiryTime);
+				}
 
-					const FUniqueNetIdEOSRef UniqueNetId = FUniqueNetIdEOSRegistry::FindOrAdd(EpicAccountId, ProductUserId).ToSharedRef();
+				const FUniqueNetIdEOSRef UniqueNetId = FUniqueNetIdEOSRegistry::FindOrAdd(EpicAccountId, ProductUserId).ToSharedRef();
 
-					ResolvedUniqueNetIds.Add(ProductUserId, UniqueNetId);
+				TArray<TSharedRef<FResolveUniqueNetIdsRequest>> Waiting;
+				InFlightProductUserIdResolves.RemoveAndCopyValue(ProductUserId, Waiting);
+				for (const TSharedRef<FResolveUniqueNetIdsRequest>& Request : Waiting)
+				{
+					Request->ResolvedUniqueNetIds.Add(ProductUserId, UniqueNetId);
+					if (--Request->NumPending == 0)
+					{
+						CompletedRequests.Add(Request);
+					}
 				}
+			}
 
-				Callback(ResolvedUniqueNetIds);
-			};
+			for (const TSharedRef<FResolveUniqueNetIdsRequest>& Request : CompletedRequests)
+			{
+				Request->Callback(Request->ResolvedUniqueNetIds);
+			}
+		};
 
 		EOS_Connect_QueryProductUserIdMappings(EOSSubsystem->GetConnectHandle(), &QueryProductUserIdMappingsOptions, CallbackObj, CallbackObj->GetCallbackPtr());
 	}
-	else
-	{
-		Callback(ResolvedUniqueNetIds);
-	}
 }
 
 FOnlineUserPtr FEOSWrapperUserManager::GetLocalOnlineUser(int32 LocalUserNum) const
@@ -1366,9 +1503,24 @@ FOnlineUserPtr FEOSWrapperUserManager::GetOnlineUser(EOS_EpicAccountId AccountId
 
 void FEOSWrapperUserManager::GetUserAuthToken(int32 LocalUserNum, FString& Token, FString& UserAccountString)
 {
+	// Tokens this close to their expiry are copied again, the copy holds whatever EOS refreshed it to
+	static constexpr int64 LocalIdTokenRenewMarginInSeconds = 60;
+
 	Token.Empty();
 	UserAccountString.Empty();
 
+	if (const FCachedIdToken* CachedToken = LocalUserIdTokens.Find(LocalUserNum))
+	{
+		if (CachedToken->ExpiresAtUnixTime - LocalIdTokenRenewMarginInSeconds > FDateTime::UtcNow().ToUnixTimestamp())
+		{
+			INC_DWORD_STAT(STAT_EOSWrapper_LocalIdTokenCacheHits);
+			Token = CachedToken->Token;
+			UserAccountString = CachedToken->UserAccountString;
+			return;
+		}
+	}
+	INC_DWORD_STAT(STAT_EOSWrapper_LocalIdTokenCacheMisses);
+
 	const EOS_EpicAccountId AccountID = GetLocalEpicAccountId(LocalUserNum);
 
 	EOS_Auth_CopyIdTokenOptions CopyIdTokenOptions;
@@ -1383,6 +1535,14 @@ void FEOSWrapperUserManager::GetUserAuthToken(int32 LocalUserNum, FString& Token
 		UserAccountString = LexToString(AccountID);
 		// UE_LOG_ONLINE(Verbose, "IdToken=%s", UTF8_TO_TCHAR(IdToken->JsonWebToken));
 		EOS_Auth_IdToken_Release(IdToken);
+
+		FCachedIdToken CachedToken;
+		if (FEOSIdTokenVerifier::ReadTokenExpiry(Token, CachedToken.ExpiresAtUnixTime))
+		{
+			CachedToken.Token = Token;
+			CachedToken.UserAccountString = UserAccountString;
+			LocalUserIdTokens.Emplace(LocalUserNum, MoveTemp(CachedToken));
+		}
 	}
 	else
 	{
@@ -1390,9 +1550,95 @@ void FEOSWrapperUserManager::GetUserAuthToken(int32 LocalUserNum, FString& Token
 	}
 }
 
+/** SHA-1 of a token, used to identify it in logs and as the verified token cache key without keeping the token itself */
+static FSHAHash HashIdToken(const FString& TokenString)
+{
+	const FTCHARToUTF8 TokenUtf8(*TokenString);
+	FSHAHash Hash;
+	FSHA1::HashBuffer(TokenUtf8.Get(), TokenUtf8.Length(), Hash.Hash);
+	return Hash;
+}
+
+void FEOSWrapperUserManager::AddVerifiedIdToken(const FString& TokenString, const FString& UserAccountString, int64 ExpiresAtUnixTime)
+{
+	const int64 Now = FDateTime::UtcNow().ToUnixTimestamp();
+	if (ExpiresAtUnixTime <= Now)
+	{
+		return;
+	}
+
+	// Expired entries are dropped now and then rather than on every insert
+	const double CurrentTime = FPlatformTime::Seconds();
+	if (CurrentTime >= NextVerifiedIdTokenSweepTimeInSeconds)
+	{
+		NextVerifiedIdTokenSweepTimeInSeconds = CurrentTime + 60.0;
+		for (TMap<FSHAHash, FCachedIdToken>::TIterator It(VerifiedIdTokens); It; ++It)
+		{
+			if (It.Value().ExpiresAtUnixTime <= Now)
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	FCachedIdToken& CachedToken = VerifiedIdTokens.FindOrAdd(HashIdToken(TokenString));
+	CachedToken.UserAccountString = UserAccountString;
+	CachedToken.ExpiresAtUnixTime = ExpiresAtUnixTime;
+}
+
 typedef TEOSCallback<EOS_Auth_OnVerifyIdTokenCallback, EOS_Auth_VerifyIdTokenCallbackInfo, FEOSWrapperUserManager> FOnVerifyIdTokenCallbackCallback;
 
 void FEOSWrapperUserManager::ValidateUserAuthToken(const FString& TokenString, const FString& UserAccountString, const FValidateUserAuthTokenCallback& Callback)
+{
+	if (const FCachedIdToken* CachedToken = VerifiedIdTokens.Find(HashIdToken(TokenString)))
+	{
+		if (CachedToken->UserAccountString == UserAccountString && CachedToken->ExpiresAtUnixTime > FDateTime::UtcNow().ToUnixTimestamp())
+		{
+			INC_DWORD_STAT(STAT_EOSWrapper_VerifiedIdTokenCacheHits);
+			// Completes on the next tick like a validation that went out would
+			EOSSubsystem->ExecuteNextTick([WeakThis = AsWeak(), TokenString, UserAccountString, Callback]()
+				{
+					if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
+					{
+						Callback(TokenString, EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*UserAccountString)), true);
+					}
+				});
+			return;
+		}
+	}
+	INC_DWORD_STAT(STAT_EOSWrapper_VerifiedIdTokenCacheMisses);
+
+	if (!IdTokenVerifier.IsValid())
+	{
+		VerifyIdTokenRemotely(TokenString, UserAccountString, Callback);
+		return;
+	}
+
+	IdTokenVerifier->Verify(TokenString, UserAccountString,
+		[this, WeakThis = AsWeak(), TokenString, UserAccountString, Callback](FEOSIdTokenVerifier::EResult Result, int64 ExpiresAtUnixTime)
+		{
+			if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
+			{
+				if (Result == FEOSIdTokenVerifier::EResult::Valid)
+				{
+					UE_LOG_ONLINE(Display, TEXT("Provided user auth token is valid"));
+					AddVerifiedIdToken(TokenString, UserAccountString, ExpiresAtUnixTime);
+					Callback(TokenString, EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*UserAccountString)), true);
+				}
+				else if (Result == FEOSIdTokenVerifier::EResult::Invalid)
+				{
+					UE_LOG_ONLINE(Display, TEXT("Invalid user auth token for account (%s), token hash (%s)"), *UserAccountString, *HashIdToken(TokenString).ToString());
+					Callback(TokenString, nullptr, false);
+				}
+				else
+				{
+					VerifyIdTokenRemotely(TokenString, UserAccountString, Callback);
+				}
+			}
+		});
+}
+
+void FEOSWrapperUserManager::VerifyIdTokenRemotely(const FString& TokenString, const FString& UserAccountString, const FValidateUserAuthTokenCallback& Callback)
 {
 	EOS_EpicAccountId AccountID = EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*UserAccountString));
 
@@ -1408,15 +1654,20 @@ void FEOSWrapperUserManager::ValidateUserAuthToken(const FString& TokenString, c
 	Options.IdToken = &Token;
 
 	FOnVerifyIdTokenCallbackCallback* CallbackObj = new FOnVerifyIdTokenCallbackCallback(FEOSWrapperUserManagerConstWeakPtr(AsShared()));
-	CallbackObj->CallbackLambda = [AccountID, TokenString, Callback](const EOS_Auth_VerifyIdTokenCallbackInfo* Data)
+	CallbackObj->CallbackLambda = [this, AccountID, TokenString, UserAccountString, Callback](const EOS_Auth_VerifyIdTokenCallbackInfo* Data)
 	{
 		if (Data->ResultCode == EOS_EResult::EOS_Success)
 		{
 			UE_LOG_ONLINE(Display, TEXT("Provided user auth token is valid"));
+			int64 ExpiresAtUnixTime = 0;
+			if (FEOSIdTokenVerifier::ReadTokenExpiry(TokenString, ExpiresAtUnixTime))
+			{
+				AddVerifiedIdToken(TokenString, UserAccountString, ExpiresAtUnixTime);
+			}
 			Callback(TokenString, AccountID, true);
 			return;
 		}
-		UE_LOG_ONLINE(Display, TEXT("Invalid user auth token: %s"), *TokenString);
+		UE_LOG_ONLINE(Display, TEXT("Invalid user auth token for account (%s), token hash (%s)"), *UserAccountString, *HashIdToken(TokenString).ToString());
 		Callback(TokenString, nullptr, false);
 	};
 
@@ -1429,8 +1680,33 @@ void FEOSWrapperUserManager::RemoveLocalUser(int32 LocalUserNum)
 	if (FoundId != nullptr)
 	{
 		EOSSubsystem->ReleaseVoiceChatUserInterface(**FoundId);
+		if (const FFriendsListEOSRef* FriendsList = LocalUserNumToFriendsListMap.Find(LocalUserNum))
+		{
+			// Another local user sharing a friend only loses the fingerprint, their next copy converts the presence again
+			for (const FOnlineFriendEOSRef& Friend : (*FriendsList)->GetList())
+			{
+				const EOS_EpicAccountId FriendAccountId = FUniqueNetIdEOS::Cast(*Friend->GetUserId()).GetEpicAccountId();
+				PresenceInfoHashes.Remove(FriendAccountId);
+				DirtyPresenceAccountIds.Remove(FriendAccountId);
+			}
+		}
 		LocalUserNumToFriendsListMap.Remove(LocalUserNum);
 		const FString& NetId = (*FoundId)->ToString();
+		if (const FBlockedPlayersListEOSRef* BlockedPlayersList = LocalUserNumToBlockedPlayerListMap.Find(LocalUserNum))
+		{
+			for (const FOnlineBlockedPlayerEOSRef& BlockedPlayer : (*BlockedPlayersList)->GetList())
+			{
+				RemoveBlockedPlayerId(FUniqueNetIdEOS::Cast(*BlockedPlayer->GetUserId()));
+			}
+			LocalUserNumToBlockedPlayerListMap.Remove(LocalUserNum);
+			NetIdStringToBlockedPlayerListMap.Remove(NetId);
+		}
+		if (DirtyRecentPlayerLists.Remove(LocalUserNum) > 0)
+		{
+			SaveRecentPlayers(LocalUserNum);
+		}
+		LocalUserNumToRecentPlayerListMap.Remove(LocalUserNum);
+		NetIdStringToRecentPlayerListMap.Remove(NetId);
 		const EOS_EpicAccountId AccountId = (*FoundId)->GetEpicAccountId();
 		AccountIdToStringMap.Remove(AccountId);
 		AccountIdToUserNumMap.Remove(AccountId);
@@ -1442,6 +1718,10 @@ void FEOSWrapperUserManager::RemoveLocalUser(int32 LocalUserNum)
 		ProductUserIdToUserNumMap.Remove(UserId);
 		ProductUserIdToStringMap.Remove(UserId);
 		UserNumToProductUserIdMap.Remove(LocalUserNum);
+		LocalPresenceStates.Remove(AccountId);
+		PresenceInfoHashes.Remove(AccountId);
+		DirtyPresenceAccountIds.Remove(AccountId);
+		LocalUserIdTokens.Remove(LocalUserNum);
 	}
 	// Reset this for the next user login
 	if (LocalUserNum == DefaultLocalUser)
@@ -1744,13 +2024,17 @@ void FEOSWrapperUserManager::FriendStatusChanged(const EOS_Friends_OnFriendsUpda
 		}
 		else if (Data->PreviousStatus == EOS_EFriendsStatus::EOS_FS_Friends && Data->CurrentStatus == EOS_EFriendsStatus::EOS_FS_NotFriends)
 		{
-			LocalUserNumToFriendsListMap[LocalUserNum]->Remove(AccountIdToStringMap[Data->TargetUserId], Friend.ToSharedRef());
+			LocalUserNumToFriendsListMap[LocalUserNum]->Remove(AccountIdToStringMap[Data->TargetUserId]);
+			PresenceInfoHashes.Remove(Data->TargetUserId);
+			DirtyPresenceAccountIds.Remove(Data->TargetUserId);
 			Friend->SetInviteStatus(EInviteStatus::Unknown);
 			TriggerOnFriendRemovedDelegates(*LocalEOSID, *OnlineUser->GetUserId());
 		}
 		else if (Data->PreviousStatus < EOS_EFriendsStatus::EOS_FS_Friends && Data->CurrentStatus == EOS_EFriendsStatus::EOS_FS_NotFriends)
 		{
-			LocalUserNumToFriendsListMap[LocalUserNum]->Remove(AccountIdToStringMap[Data->TargetUserId], Friend.ToSharedRef());
+			LocalUserNumToFriendsListMap[LocalUserNum]->Remove(AccountIdToStringMap[Data->TargetUserId]);
+			PresenceInfoHashes.Remove(Data->TargetUserId);
+			DirtyPresenceAccountIds.Remove(Data->TargetUserId);
 			Friend->SetInviteStatus(EInviteStatus::Unknown);
 			TriggerOnInviteRejectedDelegates(*LocalEOSID, *OnlineUser->GetUserId());
 		}
@@ -2214,15 +2498,128 @@ bool FEOSWrapperUserManager::IsFriend(int32 LocalUserNum, const FUniqueNetId& Fr
 	return GetFriend(LocalUserNum, FriendId, ListName).IsValid();
 }
 
+void FRecentPlayersListEOS::AddOrUpdate(const FUniqueNetIdEOSRef& PlayerId, const FDateTime& LastSeen)
+{
+	const FString NetId = PlayerId->ToString();
+	if (!SeenOrder.Contains(NetId) && SeenOrder.Num() >= SeenOrder.Max())
+	{
+		// The cache would drop the least recent player on its own, but the list entry has to go with it
+		Remove(SeenOrder.RemoveLeastRecent());
+	}
+	SeenOrder.Add(NetId, NetId);
+
+	FOnlineRecentPlayerEOSPtr RecentPlayer = GetByNetIdString(NetId);
+	if (!RecentPlayer.IsValid())
+	{
+		RecentPlayer = MakeShareable(new FOnlineRecentPlayerEOS(PlayerId));
+		Add(NetId, RecentPlayer.ToSharedRef());
+	}
+	RecentPlayer->SetLastSeen(LastSeen);
+}
+
+void FRecentPlayersListEOS::GetRecentPlayers(TArray<FOnlineRecentPlayerEOSRef>& OutRecentPlayers) const
+{
+	OutRecentPlayers.Reset(SeenOrder.Num());
+	for (TLruCache<FString, FString>::TConstIterator It(SeenOrder); It; ++It)
+	{
+		OutRecentPlayers.Add(GetByNetIdString(It.Key()).ToSharedRef());
+	}
+}
+
+void FEOSWrapperUserManager::RecordRecentPlayer(const FUniqueNetId& PlayerId)
+{
+	if (PlayerId.GetType() != FUniqueNetIdEOS::GetTypeStatic() || !PlayerId.IsValid() || IsLocalUser(PlayerId))
+	{
+		return;
+	}
+
+	const FUniqueNetIdEOSRef PlayerNetId = StaticCastSharedRef<const FUniqueNetIdEOS>(PlayerId.AsShared());
+	const FDateTime Now = FDateTime::UtcNow();
+	const bool bSaveQueued = DirtyRecentPlayerLists.Num() > 0;
+	for (const TPair<int32, FRecentPlayersListEOSRef>& Pair : LocalUserNumToRecentPlayerListMap)
+	{
+		Pair.Value->AddOrUpdate(PlayerNetId, Now);
+		DirtyRecentPlayerLists.Add(Pair.Key);
+	}
+
+	// Players joining and leaving within the debounce window end up in a single write per user, Tick writes them once it has passed
+	if (!bSaveQueued && DirtyRecentPlayerLists.Num() > 0)
+	{
+		RecentPlayersSaveTimeInSeconds = FPlatformTime::Seconds() + RecentPlayersSaveDebounceInSeconds;
+	}
+}
+
+void FEOSWrapperUserManager::SaveDirtyRecentPlayers()
+{
+	for (int32 LocalUserNum : DirtyRecentPlayerLists)
+	{
+		SaveRecentPlayers(LocalUserNum);
+	}
+	DirtyRecentPlayerLists.Reset();
+}
+
+void FEOSWrapperUserManager::LoadRecentPlayers(int32 LocalUserNum)
+{
+	FRecentPlayersListEOSRef RecentPlayersList = LocalUserNumToRecentPlayerListMap[LocalUserNum];
+
+	// Oldest first, one "<net id> <last seen ticks>" per line
+	TArray<FString> Lines;
+	FFileHelper::LoadFileToStringArray(Lines, *GetLocalUserFilePath(LocalUserNum, TEXT("RecentPlayers.txt")));
+	for (const FString& Line : Lines)
+	{
+		FString NetId;
+		FString LastSeenTicks;
+		if (!Line.Split(TEXT(" "), &NetId, &LastSeenTicks))
+		{
+			continue;
+		}
+
+		FUniqueNetIdEOSPtr PlayerNetId = FUniqueNetIdEOSRegistry::FindOrAdd(NetId);
+		if (PlayerNetId.IsValid() && PlayerNetId->IsValid())
+		{
+			RecentPlayersList->AddOrUpdate(PlayerNetId.ToSharedRef(), FDateTime(FCString::Atoi64(*LastSeenTicks)));
+		}
+	}
+}
+
+void FEOSWrapperUserManager::SaveRecentPlayers(int32 LocalUserNum) const
+{
+	const FString FilePath = GetLocalUserFilePath(LocalUserNum, TEXT("RecentPlayers.txt"));
+	const FRecentPlayersListEOSRef* RecentPlayersList = LocalUserNumToRecentPlayerListMap.Find(LocalUserNum);
+	if (FilePath.IsEmpty() || RecentPlayersList == nullptr)
+	{
+		return;
+	}
+
+	TArray<FOnlineRecentPlayerEOSRef> RecentPlayers;
+	(*RecentPlayersList)->GetRecentPlayers(RecentPlayers);
+	TArray<FString> Lines;
+	Lines.Reserve(RecentPlayers.Num());
+	for (int32 Index = RecentPlayers.Num() - 1; Index >= 0; Index--)
+	{
+		Lines.Add(FString::Printf(TEXT("%s %lld"), *RecentPlayers[Index]->GetUserId()->ToString(), RecentPlayers[Index]->GetLastSeen().GetTicks()));
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(Lines, *FilePath))
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::SaveRecentPlayers] Failed to write %s"), *FilePath);
+	}
+}
+
 bool FEOSWrapperUserManager::QueryRecentPlayers(const FUniqueNetId& UserId, const FString& Namespace)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::QueryRecentPlayers] This method is not supported."));
+	// Recent players are recorded locally from session membership and loaded at login, there is nothing to fetch
+	const bool bWasSuccessful = NetIdStringToRecentPlayerListMap.Contains(UserId.ToString());
+	if (!bWasSuccessful)
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::QueryRecentPlayers] User (%s) is not logged in"), *UserId.ToDebugString());
+	}
 
-	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), UserId = UserId.AsShared(), Namespace]()
+	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), UserId = UserId.AsShared(), Namespace, bWasSuccessful]()
 	{
 		if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
 		{
-			TriggerOnQueryRecentPlayersCompleteDelegates(*UserId, Namespace, false, TEXT("This method is not supported."));
+			TriggerOnQueryRecentPlayersCompleteDelegates(*UserId, Namespace, bWasSuccessful, bWasSuccessful ? TEXT("") : TEXT("User is not logged in"));
 		}
 	});
 
@@ -2231,20 +2628,59 @@ bool FEOSWrapperUserManager::QueryRecentPlayers(const FUniqueNetId& UserId, cons
 
 bool FEOSWrapperUserManager::GetRecentPlayers(const FUniqueNetId& UserId, const FString& Namespace, TArray<TSharedRef<FOnlineRecentPlayer>>& OutRecentPlayers)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::GetRecentPlayers] This method is not supported."));
+	OutRecentPlayers.Reset();
+	const FRecentPlayersListEOSRef* RecentPlayersList = NetIdStringToRecentPlayerListMap.Find(UserId.ToString());
+	if (RecentPlayersList == nullptr)
+	{
+		return false;
+	}
 
-	return false;
+	TArray<FOnlineRecentPlayerEOSRef> RecentPlayers;
+	(*RecentPlayersList)->GetRecentPlayers(RecentPlayers);
+	OutRecentPlayers.Append(RecentPlayers);
+	return true;
 }
 
 bool FEOSWrapperUserManager::BlockPlayer(int32 LocalUserNum, const FUniqueNetId& PlayerId)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::BlockPlayer] This method is not supported."));
+	bool bWasSuccessful = false;
+	FString ErrorStr;
+	const FBlockedPlayersListEOSRef* BlockedPlayersList = LocalUserNumToBlockedPlayerListMap.Find(LocalUserNum);
+	if (BlockedPlayersList == nullptr)
+	{
+		ErrorStr = FString::Printf(TEXT("Can't BlockPlayer() for user (%d) since they are not logged in"), LocalUserNum);
+	}
+	else if (PlayerId.GetType() != FUniqueNetIdEOS::GetTypeStatic() || !PlayerId.IsValid() || IsLocalUser(PlayerId))
+	{
+		ErrorStr = FString::Printf(TEXT("Can't BlockPlayer() for user (%d) with invalid player (%s)"), LocalUserNum, *PlayerId.ToDebugString());
+	}
+	else
+	{
+		const FString NetId = PlayerId.ToString();
+		if (!(*BlockedPlayersList)->GetByNetIdString(NetId).IsValid())
+		{
+			FUniqueNetIdEOSRef PlayerNetId = StaticCastSharedRef<const FUniqueNetIdEOS>(PlayerId.AsShared());
+			(*BlockedPlayersList)->Add(NetId, MakeShareable(new FOnlineBlockedPlayerEOS(PlayerNetId)));
+			AddBlockedPlayerId(*PlayerNetId);
+			SaveBlockedPlayers(LocalUserNum);
+		}
+		bWasSuccessful = true;
+	}
+
+	if (!bWasSuccessful)
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::BlockPlayer] %s"), *ErrorStr);
+	}
 
-	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), LocalUserNum, PlayerId = PlayerId.AsShared()]()
+	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), LocalUserNum, PlayerId = PlayerId.AsShared(), bWasSuccessful, ErrorStr]()
 	{
 		if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
 		{
-			TriggerOnBlockedPlayerCompleteDelegates(LocalUserNum, false, *PlayerId, TEXT(""), TEXT("This method is not supported"));
+			TriggerOnBlockedPlayerCompleteDelegates(LocalUserNum, bWasSuccessful, *PlayerId, TEXT(""), ErrorStr);
+			if (bWasSuccessful)
+			{
+				TriggerOnBlockListChangeDelegates(LocalUserNum, TEXT(""));
+			}
 		}
 	});
 
@@ -2253,13 +2689,40 @@ bool FEOSWrapperUserManager::BlockPlayer(int32 LocalUserNum, const FUniqueNetId&
 
 bool FEOSWrapperUserManager::UnblockPlayer(int32 LocalUserNum, const FUniqueNetId& PlayerId)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::UnblockPlayer] This method is not supported."));
+	bool bWasSuccessful = false;
+	FString ErrorStr;
+	const FBlockedPlayersListEOSRef* BlockedPlayersList = LocalUserNumToBlockedPlayerListMap.Find(LocalUserNum);
+	if (BlockedPlayersList == nullptr)
+	{
+		ErrorStr = FString::Printf(TEXT("Can't UnblockPlayer() for user (%d) since they are not logged in"), LocalUserNum);
+	}
+	else
+	{
+		const FString NetId = PlayerId.ToString();
+		FOnlineBlockedPlayerEOSPtr BlockedPlayer = (*BlockedPlayersList)->GetByNetIdString(NetId);
+		if (BlockedPlayer.IsValid())
+		{
+			(*BlockedPlayersList)->Remove(NetId);
+			RemoveBlockedPlayerId(FUniqueNetIdEOS::Cast(*BlockedPlayer->GetUserId()));
+			SaveBlockedPlayers(LocalUserNum);
+		}
+		bWasSuccessful = true;
+	}
+
+	if (!bWasSuccessful)
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::UnblockPlayer] %s"), *ErrorStr);
+	}
 
-	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), LocalUserNum, PlayerId = PlayerId.AsShared()]()
+	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), LocalUserNum, PlayerId = PlayerId.AsShared(), bWasSuccessful, ErrorStr]()
 	{
 		if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
 		{
-			TriggerOnUnblockedPlayerCompleteDelegates(LocalUserNum, false, *PlayerId, TEXT(""), TEXT("This method is not supported"));
+			TriggerOnUnblockedPlayerCompleteDelegates(LocalUserNum, bWasSuccessful, *PlayerId, TEXT(""), ErrorStr);
+			if (bWasSuccessful)
+			{
+				TriggerOnBlockListChangeDelegates(LocalUserNum, TEXT(""));
+			}
 		}
 	});
 
@@ -2268,13 +2731,23 @@ bool FEOSWrapperUserManager::UnblockPlayer(int32 LocalUserNum, const FUniqueNetI
 
 bool FEOSWrapperUserManager::QueryBlockedPlayers(const FUniqueNetId& UserId)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::QueryBlockedPlayers] This method is not supported."));
+	// EOS keeps no block list of its own, the list lives on disk next to the other local user data
+	const int32 LocalUserNum = GetLocalUserNumFromUniqueNetId(UserId);
+	const bool bWasSuccessful = LocalUserNumToBlockedPlayerListMap.Contains(LocalUserNum);
+	if (bWasSuccessful)
+	{
+		LoadBlockedPlayers(LocalUserNum);
+	}
+	else
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::QueryBlockedPlayers] User (%s) is not logged in"), *UserId.ToDebugString());
+	}
 
-	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), UserId = UserId.AsShared()]()
+	EOSSubsystem->ExecuteNextTick([this, WeakThis = AsWeak(), UserId = UserId.AsShared(), bWasSuccessful]()
 	{
 		if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
 		{
-			TriggerOnQueryBlockedPlayersCompleteDelegates(*UserId, false, TEXT("This method is not supported"));
+			TriggerOnQueryBlockedPlayersCompleteDelegates(*UserId, bWasSuccessful, bWasSuccessful ? TEXT("") : TEXT("User is not logged in"));
 		}
 	});
 
@@ -2283,19 +2756,149 @@ bool FEOSWrapperUserManager::QueryBlockedPlayers(const FUniqueNetId& UserId)
 
 bool FEOSWrapperUserManager::GetBlockedPlayers(const FUniqueNetId& UserId, TArray<TSharedRef<FOnlineBlockedPlayer>>& OutBlockedPlayers)
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::GetBlockedPlayers] This method is not supported."));
+	OutBlockedPlayers.Reset();
+	const FBlockedPlayersListEOSRef* BlockedPlayersList = NetIdStringToBlockedPlayerListMap.Find(UserId.ToString());
+	if (BlockedPlayersList == nullptr)
+	{
+		return false;
+	}
 
-	return false;
+	OutBlockedPlayers.Reserve((*BlockedPlayersList)->GetList().Num());
+	for (const FOnlineBlockedPlayerEOSRef& BlockedPlayer : (*BlockedPlayersList)->GetList())
+	{
+		OutBlockedPlayers.Add(BlockedPlayer);
+	}
+	return true;
 }
 
 void FEOSWrapperUserManager::DumpBlockedPlayers() const
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::DumpBlockedPlayers] This method is not supported."));
+	for (const TPair<int32, FBlockedPlayersListEOSRef>& Pair : LocalUserNumToBlockedPlayerListMap)
+	{
+		UE_LOG_ONLINE_FRIEND(Display, TEXT("Blocked players of user (%d):"), Pair.Key);
+		for (const FOnlineBlockedPlayerEOSRef& BlockedPlayer : Pair.Value->GetList())
+		{
+			UE_LOG_ONLINE_FRIEND(Display, TEXT("\t%s"), *BlockedPlayer->GetUserId()->ToDebugString());
+		}
+	}
+}
+
+bool FEOSWrapperUserManager::IsPlayerBlockedByAnyLocalUser(const FUniqueNetId& PlayerId) const
+{
+	if (PlayerId.GetType() != FUniqueNetIdEOS::GetTypeStatic())
+	{
+		return false;
+	}
+
+	const FUniqueNetIdEOS& EOSID = FUniqueNetIdEOS::Cast(PlayerId);
+	return (EOSID.GetProductUserId() != nullptr && BlockedProductUserIdCounts.Contains(EOSID.GetProductUserId())) ||
+		   (EOSID.GetEpicAccountId() != nullptr && BlockedEpicAccountIdCounts.Contains(EOSID.GetEpicAccountId()));
+}
+
+bool FEOSWrapperUserManager::IsPlayerBlockedByAnyLocalUser(EOS_ProductUserId ProductUserId) const
+{
+	return ProductUserId != nullptr && BlockedProductUserIdCounts.Contains(ProductUserId);
+}
+
+void FEOSWrapperUserManager::AddBlockedPlayerId(const FUniqueNetIdEOS& PlayerId)
+{
+	if (PlayerId.GetProductUserId() != nullptr)
+	{
+		BlockedProductUserIdCounts.FindOrAdd(PlayerId.GetProductUserId())++;
+	}
+	if (PlayerId.GetEpicAccountId() != nullptr)
+	{
+		BlockedEpicAccountIdCounts.FindOrAdd(PlayerId.GetEpicAccountId())++;
+	}
+}
+
+void FEOSWrapperUserManager::RemoveBlockedPlayerId(const FUniqueNetIdEOS& PlayerId)
+{
+	if (int32* Count = BlockedProductUserIdCounts.Find(PlayerId.GetProductUserId()))
+	{
+		if (--(*Count) <= 0)
+		{
+			BlockedProductUserIdCounts.Remove(PlayerId.GetProductUserId());
+		}
+	}
+	if (int32* Count = BlockedEpicAccountIdCounts.Find(PlayerId.GetEpicAccountId()))
+	{
+		if (--(*Count) <= 0)
+		{
+			BlockedEpicAccountIdCounts.Remove(PlayerId.GetEpicAccountId());
+		}
+	}
+}
+
+FString FEOSWrapperUserManager::GetLocalUserFilePath(int32 LocalUserNum, const TCHAR* FileName) const
+{
+	const FUniqueNetIdEOSPtr* NetId = UserNumToNetIdMap.Find(LocalUserNum);
+	if (NetId == nullptr || !NetId->IsValid())
+	{
+		return FString();
+	}
+
+	// The id separator isn't allowed in file names everywhere
+	const FString UserDir = (*NetId)->ToString().Replace(EOS_ID_SEPARATOR, TEXT("_"));
+	return FPaths::ProjectSavedDir() / TEXT("EOSWrapper") / UserDir / FileName;
+}
+
+void FEOSWrapperUserManager::LoadBlockedPlayers(int32 LocalUserNum)
+{
+	FBlockedPlayersListEOSRef BlockedPlayersList = LocalUserNumToBlockedPlayerListMap[LocalUserNum];
+	for (const FOnlineBlockedPlayerEOSRef& BlockedPlayer : BlockedPlayersList->GetList())
+	{
+		RemoveBlockedPlayerId(FUniqueNetIdEOS::Cast(*BlockedPlayer->GetUserId()));
+	}
+	BlockedPlayersList->Empty();
+
+	TArray<FString> NetIds;
+	FFileHelper::LoadFileToStringArray(NetIds, *GetLocalUserFilePath(LocalUserNum, TEXT("BlockedPlayers.txt")));
+	for (const FString& NetId : NetIds)
+	{
+		FUniqueNetIdEOSPtr PlayerNetId = FUniqueNetIdEOSRegistry::FindOrAdd(NetId);
+		if (PlayerNetId.IsValid() && PlayerNetId->IsValid() && !BlockedPlayersList->GetByNetIdString(PlayerNetId->ToString()).IsValid())
+		{
+			BlockedPlayersList->Add(PlayerNetId->ToString(), MakeShareable(new FOnlineBlockedPlayerEOS(PlayerNetId.ToSharedRef())));
+			AddBlockedPlayerId(*PlayerNetId);
+		}
+	}
+}
+
+void FEOSWrapperUserManager::SaveBlockedPlayers(int32 LocalUserNum) const
+{
+	const FString FilePath = GetLocalUserFilePath(LocalUserNum, TEXT("BlockedPlayers.txt"));
+	const FBlockedPlayersListEOSRef* BlockedPlayersList = LocalUserNumToBlockedPlayerListMap.Find(LocalUserNum);
+	if (FilePath.IsEmpty() || BlockedPlayersList == nullptr)
+	{
+		return;
+	}
+
+	TArray<FString> NetIds;
+	NetIds.Reserve((*BlockedPlayersList)->GetList().Num());
+	for (const FOnlineBlockedPlayerEOSRef& BlockedPlayer : (*BlockedPlayersList)->GetList())
+	{
+		NetIds.Add(BlockedPlayer->GetUserId()->ToString());
+	}
+
+	if (!FFileHelper::SaveStringArrayToFile(NetIds, *FilePath))
+	{
+		UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::SaveBlockedPlayers] Failed to write %s"), *FilePath);
+	}
 }
 
 void FEOSWrapperUserManager::DumpRecentPlayers() const
 {
-	UE_LOG_ONLINE_FRIEND(Warning, TEXT("[FEOSWrapperUserManager::DumpRecentPlayers] This method is not supported."));
+	for (const TPair<int32, FRecentPlayersListEOSRef>& Pair : LocalUserNumToRecentPlayerListMap)
+	{
+		TArray<FOnlineRecentPlayerEOSRef> RecentPlayers;
+		Pair.Value->GetRecentPlayers(RecentPlayers);
+		UE_LOG_ONLINE_FRIEND(Display, TEXT("Recent players of user (%d):"), Pair.Key);
+		for (const FOnlineRecentPlayerEOSRef& RecentPlayer : RecentPlayers)
+		{
+			UE_LOG_ONLINE_FRIEND(Display, TEXT("\t%s last seen %s"), *RecentPlayer->GetUserId()->ToDebugString(), *RecentPlayer->GetLastSeen().ToString());
+		}
+	}
 }
 
 bool FEOSWrapperUserManager::HandleFriendsExec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar)
@@ -2415,6 +3018,24 @@ struct FRichTextOptions : public EOS_PresenceModification_SetRawRichTextOptions
 
 typedef TEOSCallback<EOS_Presence_SetPresenceCompleteCallback, EOS_Presence_SetPresenceCallbackInfo, FEOSWrapperUserManager> FSetPresenceCallback;
 
+static bool PresenceStatusEquals(const FOnlineUserPresenceStatus& A, const FOnlineUserPresenceStatus& B)
+{
+	if (A.State != B.State || A.StatusStr != B.StatusStr || A.Properties.Num() != B.Properties.Num())
+	{
+		return false;
+	}
+
+	for (const TPair<FString, FVariantData>& Property : A.Properties)
+	{
+		const FVariantData* Other = B.Properties.Find(Property.Key);
+		if (Other == nullptr || !(*Other == Property.Value))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void FEOSWrapperUserManager::SetPresence(const FUniqueNetId& UserId, const FOnlineUserPresenceStatus& Status, const FOnPresenceTaskCompleteDelegate& Delegate)
 {
 	const FUniqueNetIdEOS& EOSID = FUniqueNetIdEOS::Cast(UserId);
@@ -2425,6 +3046,71 @@ void FEOSWrapperUserManager::SetPresence(const FUniqueNetId& UserId, const FOnli
 		return;
 	}
 
+	FLocalPresenceState& PresenceState = LocalPresenceStates.FindOrAdd(AccountId);
+	const TOptional<FOnlineUserPresenceStatus>& LatestStatus = PresenceState.PendingStatus.IsSet() ? PresenceState.PendingStatus : PresenceState.SentStatus;
+	if (LatestStatus.IsSet() && PresenceStatusEquals(*LatestStatus, Status))
+	{
+		// Nothing changed, the call completes together with whatever is already on its way
+		INC_DWORD_STAT(STAT_EOSWrapper_PresenceUpdatesSuppressed);
+		if (PresenceState.PendingStatus.IsSet())
+		{
+			PresenceState.PendingDelegates.Add(Delegate);
+		}
+		else
+		{
+			EOSSubsystem->ExecuteNextTick([Delegate, UserId = UserId.AsShared()]() { Delegate.ExecuteIfBound(*UserId, true); });
+		}
+		return;
+	}
+
+	if (PresenceState.PendingStatus.IsSet())
+	{
+		INC_DWORD_STAT(STAT_EOSWrapper_PresenceUpdatesSuppressed);
+	}
+	else
+	{
+		PresenceState.SendTimeInSeconds = FPlatformTime::Seconds() + PresenceUpdateDebounceInSeconds;
+	}
+	PresenceState.PendingStatus = Status;
+	PresenceState.PendingDelegates.Add(Delegate);
+
+	if (PresenceUpdateDebounceInSeconds <= 0.0 && !PresenceState.bSendInFlight)
+	{
+		SendPresence(AccountId);
+	}
+}
+
+void FEOSWrapperUserManager::SendPresence(EOS_EpicAccountId AccountId)
+{
+	FLocalPresenceState& PresenceState = LocalPresenceStates[AccountId];
+	const FOnlineUserPresenceStatus Status = MoveTemp(PresenceState.PendingStatus.GetValue());
+	PresenceState.PendingStatus.Reset();
+	TArray<FOnPresenceTaskCompleteDelegate> Delegates = MoveTemp(PresenceState.PendingDelegates);
+	PresenceState.PendingDelegates.Reset();
+
+	auto CompleteDelegates = [this, Delegates](EOS_EpicAccountId LocalUserId, bool bWasSuccessful)
+	{
+		FUniqueNetIdEOSRef EOSID = bWasSuccessful && AccountIdToStringMap.Contains(LocalUserId) ? FUniqueNetIdEOSRegistry::FindOrAdd(AccountIdToStringMap[LocalUserId]).ToSharedRef() : FUniqueNetIdEOS::EmptyId();
+		for (const FOnPresenceTaskCompleteDelegate& Delegate : Delegates)
+		{
+			Delegate.ExecuteIfBound(*EOSID, bWasSuccessful);
+		}
+	};
+
+	// Changed and changed back within the debounce window
+	if (PresenceState.SentStatus.IsSet() && PresenceStatusEquals(*PresenceState.SentStatus, Status))
+	{
+		INC_DWORD_STAT(STAT_EOSWrapper_PresenceUpdatesSuppressed);
+		EOSSubsystem->ExecuteNextTick([WeakThis = AsWeak(), CompleteDelegates, AccountId]()
+			{
+				if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
+				{
+					CompleteDelegates(AccountId, true);
+				}
+			});
+		return;
+	}
+
 	EOS_HPresenceModification ChangeHandle = nullptr;
 	EOS_Presence_CreatePresenceModificationOptions Options = {};
 	Options.ApiVersion = EOS_PRESENCE_CREATEPRESENCEMODIFICATION_API_LATEST;
@@ -2433,6 +3119,13 @@ void FEOSWrapperUserManager::SetPresence(const FUniqueNetId& UserId, const FOnli
 	if (ChangeHandle == nullptr)
 	{
 		UE_LOG_ONLINE(Error, TEXT("Failed to create a modification handle for setting presence"));
+		EOSSubsystem->ExecuteNextTick([WeakThis = AsWeak(), CompleteDelegates, AccountId]()
+			{
+				if (FEOSWrapperUserManagerPtr StrongThis = WeakThis.Pin())
+				{
+					CompleteDelegates(AccountId, false);
+				}
+			});
 		return;
 	}
 
@@ -2477,17 +3170,29 @@ void FEOSWrapperUserManager::SetPresence(const FUniqueNetId& UserId, const FOnli
 		UE_LOG_ONLINE(Error, TEXT("EOS_PresenceModification_SetData() failed with result code (%s)"), *LexToString(SetDataResult));
 	}
 
+	// Later calls are compared against what is on its way, a failed update is forgotten so the next call sends again
+	PresenceState.SentStatus = Status;
+	PresenceState.bSendInFlight = true;
+	INC_DWORD_STAT(STAT_EOSWrapper_PresenceUpdatesSent);
+
 	FSetPresenceCallback* CallbackObj = new FSetPresenceCallback(AsWeak());
-	CallbackObj->CallbackLambda = [this, Delegate](const EOS_Presence_SetPresenceCallbackInfo* Data)
+	CallbackObj->CallbackLambda = [this, CompleteDelegates](const EOS_Presence_SetPresenceCallbackInfo* Data)
 	{
-		if (Data->ResultCode == EOS_EResult::EOS_Success && AccountIdToStringMap.Contains(Data->LocalUserId))
+		const bool bWasSuccessful = Data->ResultCode == EOS_EResult::EOS_Success;
+		if (FLocalPresenceState* SentPresenceState = LocalPresenceStates.Find(Data->LocalUserId))
 		{
-			FUniqueNetIdEOSRef EOSID = FUniqueNetIdEOSRegistry::FindOrAdd(AccountIdToStringMap[Data->LocalUserId]).ToSharedRef();
-			Delegate.ExecuteIfBound(*EOSID, true);
-			return;
+			SentPresenceState->bSendInFlight = false;
+			if (!bWasSuccessful)
+			{
+				SentPresenceState->SentStatus.Reset();
+			}
+		}
+
+		if (!bWasSuccessful)
+		{
+			UE_LOG_ONLINE(Error, TEXT("SetPresence() failed with result code (%s)"), *LexToString(Data->ResultCode));
 		}
-		UE_LOG_ONLINE(Error, TEXT("SetPresence() failed with result code (%s)"), *LexToString(Data->ResultCode));
-		Delegate.ExecuteIfBound(*FUniqueNetIdEOS::EmptyId(), false);
+		CompleteDelegates(Data->LocalUserId, bWasSuccessful && AccountIdToStringMap.Contains(Data->LocalUserId));
 	};
 
 	EOS_Presence_SetPresenceOptions PresOptions = {};
@@ -2557,8 +3262,78 @@ void FEOSWrapperUserManager::QueryPresence(const FUniqueNetId& UserId, const FOn
 	Delegate.ExecuteIfBound(UserId, true);
 }
 
+void FEOSWrapperUserManager::ProcessDirtyPresence()
+{
+	if (DirtyPresenceAccountIds.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_EOSWrapper_ProcessDirtyPresence);
+	if (DefaultLocalUser < 0)
+	{
+		DirtyPresenceAccountIds.Reset();
+		return;
+	}
+
+	// Notifications triggered while updating land in the next tick
+	TSet<EOS_EpicAccountId> AccountIds = MoveTemp(DirtyPresenceAccountIds);
+	DirtyPresenceAccountIds.Reset();
+	for (const EOS_EpicAccountId AccountId : AccountIds)
+	{
+		// The user may have been removed since the notification came in
+		if (AccountIdToStringMap.Contains(AccountId))
+		{
+			UpdatePresence(AccountId);
+		}
+	}
+}
+
+/** Fingerprint of everything UpdatePresence converts, so an unchanged presence can be skipped without touching any strings */
+static uint32 HashPresenceInfo(const EOS_Presence_Info& PresenceInfo)
+{
+	auto HashString = [](const char* String, uint32 Crc) { return String != nullptr ? FCrc::MemCrc32(String, FCStringAnsi::Strlen(String) + 1, Crc) : FCrc::MemCrc32("", 1, Crc); };
+
+	uint32 Crc = FCrc::MemCrc32(&PresenceInfo.Status, sizeof(PresenceInfo.Status));
+	Crc = HashString(PresenceInfo.RichText, Crc);
+	Crc = HashString(PresenceInfo.ProductId, Crc);
+	Crc = HashString(PresenceInfo.ProductVersion, Crc);
+	Crc = HashString(PresenceInfo.Platform, Crc);
+	for (int32 Index = 0; Index < PresenceInfo.RecordsCount; Index++)
+	{
+		Crc = HashString(PresenceInfo.Records[Index].Key, Crc);
+		Crc = HashString(PresenceInfo.Records[Index].Value, Crc);
+	}
+	return Crc;
+}
+
+/** Only writes the property when its value changed, returns true if it did */
+static bool UpdatePresenceProperty(FPresenceProperties& Properties, const FString& Key, const TCHAR* Value)
+{
+	if (FVariantData* Existing = Properties.Find(Key))
+	{
+		if (Existing->GetType() == EOnlineKeyValuePairDataType::String)
+		{
+			FString ExistingValue;
+			Existing->GetValue(ExistingValue);
+			if (ExistingValue.Equals(Value, ESearchCase::CaseSensitive))
+			{
+				return false;
+			}
+		}
+		Existing->SetValue(Value);
+		return true;
+	}
+	Properties.Emplace(Key, FVariantData(Value));
+	return true;
+}
+
 void FEOSWrapperUserManager::UpdatePresence(EOS_EpicAccountId AccountId)
 {
+	// A pending notification is covered by this copy
+	DirtyPresenceAccountIds.Remove(AccountId);
+	INC_DWORD_STAT(STAT_EOSWrapper_PresenceCopies);
+
 	EOS_Presence_Info* PresenceInfo = nullptr;
 	EOS_Presence_CopyPresenceOptions Options = {};
 	Options.ApiVersion = EOS_PRESENCE_COPYPRESENCE_API_LATEST;
@@ -2576,24 +3351,61 @@ void FEOSWrapperUserManager::UpdatePresence(EOS_EpicAccountId AccountId)
 		}
 
 		FOnlineUserPresenceRef PresenceRef = NetIdStringToOnlineUserPresenceMap[NetId];
-		const FString ProductId(UTF8_TO_TCHAR(PresenceInfo->ProductId));
-		const FString ProdVersion(UTF8_TO_TCHAR(PresenceInfo->ProductVersion));
-		const FString Platform(UTF8_TO_TCHAR(PresenceInfo->Platform));
-		// Convert the presence data to our format
-		PresenceRef->Status.State = ToEOnlinePresenceState(PresenceInfo->Status);
-		PresenceRef->Status.StatusStr = UTF8_TO_TCHAR(PresenceInfo->RichText);
-		PresenceRef->bIsOnline = PresenceRef->Status.State == EOnlinePresenceState::Online;
-		PresenceRef->bIsPlaying = !ProductId.IsEmpty();
-		PresenceRef->bIsPlayingThisGame = ProductId == EOSSubsystem->ProductId && ProdVersion == EOSSubsystem->EOSSDKManager->GetProductVersion();
-		//		PresenceRef->bIsJoinable = ???;
-		//		PresenceRef->bHasVoiceSupport = ???;
-		PresenceRef->Status.Properties.Add(TEXT("ProductId"), ProductId);
-		PresenceRef->Status.Properties.Add(TEXT("ProductVersion"), ProdVersion);
-		PresenceRef->Status.Properties.Add(TEXT("Platform"), Platform);
-		for (int32 Index = 0; Index < PresenceInfo->RecordsCount; Index++)
-		{
-			const EOS_Presence_DataRecord& Record = PresenceInfo->Records[Index];
-			PresenceRef->Status.Properties.Add(Record.Key, UTF8_TO_TCHAR(Record.Value));
+		const uint32 PresenceInfoHash = HashPresenceInfo(*PresenceInfo);
+		uint32* LastPresenceInfoHash = PresenceInfoHashes.Find(AccountId);
+		if (LastPresenceInfoHash == nullptr || *LastPresenceInfoHash != PresenceInfoHash)
+		{
+			PresenceInfoHashes.Emplace(AccountId, PresenceInfoHash);
+
+			static const FString ProductIdKey(TEXT("ProductId"));
+			static const FString ProductVersionKey(TEXT("ProductVersion"));
+			static const FString PlatformKey(TEXT("Platform"));
+			const FUTF8ToTCHAR ProductId(PresenceInfo->ProductId);
+			const FUTF8ToTCHAR ProdVersion(PresenceInfo->ProductVersion);
+			const FUTF8ToTCHAR Platform(PresenceInfo->Platform);
+			// Convert the presence data to our format
+			PresenceRef->Status.State = ToEOnlinePresenceState(PresenceInfo->Status);
+			const FUTF8ToTCHAR RichText(PresenceInfo->RichText);
+			if (!PresenceRef->Status.StatusStr.Equals(RichText.Get(), ESearchCase::CaseSensitive))
+			{
+				PresenceRef->Status.StatusStr = RichText.Get();
+			}
+			PresenceRef->bIsOnline = PresenceRef->Status.State == EOnlinePresenceState::Online;
+			PresenceRef->bIsPlaying = ProductId.Length() > 0;
+			PresenceRef->bIsPlayingThisGame = EOSSubsystem->ProductId.Equals(ProductId.Get(), ESearchCase::CaseSensitive) && EOSSubsystem->EOSSDKManager->GetProductVersion().Equals(ProdVersion.Get(), ESearchCase::CaseSensitive);
+			//		PresenceRef->bIsJoinable = ???;
+			//		PresenceRef->bHasVoiceSupport = ???;
+			FPresenceProperties& Properties = PresenceRef->Status.Properties;
+			UpdatePresenceProperty(Properties, ProductIdKey, ProductId.Get());
+			UpdatePresenceProperty(Properties, ProductVersionKey, ProdVersion.Get());
+			UpdatePresenceProperty(Properties, PlatformKey, Platform.Get());
+			for (int32 Index = 0; Index < PresenceInfo->RecordsCount; Index++)
+			{
+				const EOS_Presence_DataRecord& Record = PresenceInfo->Records[Index];
+				UpdatePresenceProperty(Properties, UTF8_TO_TCHAR(Record.Key), UTF8_TO_TCHAR(Record.Value));
+			}
+
+			// Drop records the user no longer publishes, so the map only ever holds the current ones
+			if (Properties.Num() > PresenceInfo->RecordsCount + 3)
+			{
+				for (FPresenceProperties::TIterator It(Properties); It; ++It)
+				{
+					const FString& Key = It.Key();
+					bool bIsCurrent = Key == ProductIdKey || Key == ProductVersionKey || Key == PlatformKey;
+					for (int32 Index = 0; Index < PresenceInfo->RecordsCount && !bIsCurrent; Index++)
+					{
+						bIsCurrent = Key == UTF8_TO_TCHAR(PresenceInfo->Records[Index].Key);
+					}
+					if (!bIsCurrent)
+					{
+						It.RemoveCurrent();
+					}
+				}
+			}
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_EOSWrapper_PresenceCopiesUnchanged);
 		}
 
 		// Copy the presence if this is a friend that was updated, so that their data is in sync
@@ -2843,6 +3655,14 @@ struct FGetAccountMappingOptions : public EOS_Connect_GetExternalAccountMappings
 
 typedef TEOSCallback<EOS_Connect_OnQueryExternalAccountMappingsCallback, EOS_Connect_QueryExternalAccountMappingsCallbackInfo, FEOSWrapperUserManager> FQueryByStringIdsCallback;
 
+/** Progress of the batches of one QueryExternalIdMappings call */
+struct FQueryExternalIdMappingsState
+{
+	int32 NumPendingBatches = 0;
+	/** First failure of any batch, the call only succeeds if every batch did */
+	EOS_EResult Result = EOS_EResult::EOS_Success;
+};
+
 bool FEOSWrapperUserManager::QueryExternalIdMappings(
 	const FUniqueNetId& UserId, const FExternalIdQueryOptions& QueryOptions, const TArray<FString>& ExternalIds, const FOnQueryExternalIdMappingsComplete& Delegate)
 {
@@ -2863,27 +3683,53 @@ bool FEOSWrapperUserManager::QueryExternalIdMappings(
 
 	int32 LocalUserNum = GetLocalUserNumFromUniqueNetId(UserId);
 
+	// Users whose product user id is already known don't need another round trip
+	TArray<FString> IdsToQuery;
+	TSet<FString> QueuedIds;
+	IdsToQuery.Reserve(ExternalIds.Num());
+	for (const FString& ExternalId : ExternalIds)
+	{
+		const EOS_EpicAccountId ExternalAccountId = EOS_EpicAccountId_FromString(TCHAR_TO_UTF8(*ExternalId));
+		if (const FString* NetIdStr = AccountIdToStringMap.Find(ExternalAccountId))
+		{
+			if (EOS_ProductUserId_IsValid(FUniqueNetIdEOSRegistry::FindOrAdd(*NetIdStr)->GetProductUserId()) == EOS_TRUE)
+			{
+				continue;
+			}
+		}
+		bool bIsAlreadyQueued = false;
+		QueuedIds.Add(ExternalId, &bIsAlreadyQueued);
+		if (!bIsAlreadyQueued)
+		{
+			IdsToQuery.Add(ExternalId);
+		}
+	}
+
+	if (IdsToQuery.IsEmpty())
+	{
+		Delegate.ExecuteIfBound(true, UserId, QueryOptions, ExternalIds, FString());
+		return true;
+	}
+
 	// Mark the queries as in progress
-	IsPlayerQueryExternalMappingsOngoingForLocalUserMap.FindOrAdd(LocalUserNum).Append(ExternalIds);
+	IsPlayerQueryExternalMappingsOngoingForLocalUserMap.FindOrAdd(LocalUserNum).Append(IdsToQuery);
 
 	const EOS_ProductUserId LocalUserId = EOSID.GetProductUserId();
-	const int32 NumBatches = (ExternalIds.Num() / EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS) + 1;
-	int32 QueryStart = 0;
-	// Process queries in batches since there's a max that can be done at once
-	for (int32 BatchCount = 0; BatchCount < NumBatches; BatchCount++)
-	{
-		const uint32 AmountToProcess = FMath::Min(ExternalIds.Num() - QueryStart, EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS);
-		TArray<FString> BatchIds;
-		BatchIds.Empty(AmountToProcess);
+	TSharedRef<FQueryExternalIdMappingsState> QueryState = MakeShared<FQueryExternalIdMappingsState>();
+	QueryState->NumPendingBatches = FMath::DivideAndRoundUp(IdsToQuery.Num(), EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS);
+	// Process queries in batches since there's a max that can be done at once, all of them run at the same time
+	for (int32 QueryStart = 0; QueryStart < IdsToQuery.Num(); QueryStart += EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS)
+	{
+		const int32 AmountToProcess = FMath::Min(IdsToQuery.Num() - QueryStart, EOS_CONNECT_QUERYEXTERNALACCOUNTMAPPINGS_MAX_ACCOUNT_IDS);
+		TArray<FString> BatchIds(IdsToQuery.GetData() + QueryStart, AmountToProcess);
 		FQueryByStringIdsOptions Options(AmountToProcess, LocalUserId);
 		// Build an options up per batch
-		for (uint32 ProcessedCount = 0; ProcessedCount < AmountToProcess; ProcessedCount++, QueryStart++)
+		for (int32 ProcessedCount = 0; ProcessedCount < AmountToProcess; ProcessedCount++)
 		{
-			FCStringAnsi::Strncpy(Options.PointerArray[ProcessedCount], TCHAR_TO_UTF8(*ExternalIds[ProcessedCount]), EOS_CONNECT_EXTERNAL_ACCOUNT_ID_MAX_LENGTH + 1);
-			BatchIds.Add(ExternalIds[ProcessedCount]);
+			FCStringAnsi::Strncpy(Options.PointerArray[ProcessedCount], TCHAR_TO_UTF8(*BatchIds[ProcessedCount]), EOS_CONNECT_EXTERNAL_ACCOUNT_ID_MAX_LENGTH + 1);
 		}
 		FQueryByStringIdsCallback* CallbackObj = new FQueryByStringIdsCallback(AsWeak());
-		CallbackObj->CallbackLambda = [LocalUserNum, QueryOptions, BatchIds, this, Delegate](const EOS_Connect_QueryExternalAccountMappingsCallbackInfo* Data)
+		CallbackObj->CallbackLambda = [LocalUserNum, QueryOptions, ExternalIds, BatchIds, QueryState, this, Delegate](const EOS_Connect_QueryExternalAccountMappingsCallbackInfo* Data)
 		{
 			EOS_EResult Result = Data->ResultCode;
 			if (GetLoginStatus(LocalUserNum) != ELoginStatus::LoggedIn)
@@ -2892,12 +3738,8 @@ bool FEOSWrapperUserManager::QueryExternalIdMappings(
 				Result = EOS_EResult::EOS_InvalidUser;
 			}
 
-			FString ErrorString;
-			FUniqueNetIdEOSPtr EOSID = FUniqueNetIdEOS::EmptyId();
 			if (Result == EOS_EResult::EOS_Success)
 			{
-				EOSID = UserNumToNetIdMap[LocalUserNum];
-
 				FGetAccountMappingOptions Options;
 				Options.LocalUserId = UserNumToProductUserIdMap[DefaultLocalUser];
 				// Get the product id for each epic account passed in
@@ -2912,20 +3754,37 @@ bool FEOSWrapperUserManager::QueryExternalIdMappings(
 					}
 				}
 			}
-			else
+			else if (QueryState->Result == EOS_EResult::EOS_Success)
 			{
-				ErrorString = FString::Printf(TEXT("EOS_Connect_QueryExternalAccountMappings() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(Result)));
+				QueryState->Result = Result;
 			}
 
 			// Mark all queries as complete
-			TArray<FString>& OngoingQueries = IsPlayerQueryExternalMappingsOngoingForLocalUserMap[LocalUserNum];
-			for (const FString& StringId : BatchIds)
+			if (TArray<FString>* OngoingQueries = IsPlayerQueryExternalMappingsOngoingForLocalUserMap.Find(LocalUserNum))
+			{
+				for (const FString& StringId : BatchIds)
+				{
+					OngoingQueries->RemoveSwap(StringId, false);
+				}
+			}
+
+			if (--QueryState->NumPendingBatches > 0)
 			{
-				OngoingQueries.RemoveSwap(StringId, false);
+				return;
 			}
 
-			const bool bWasSuccessful = Result == EOS_EResult::EOS_Success;
-			Delegate.ExecuteIfBound(bWasSuccessful, *EOSID, QueryOptions, BatchIds, ErrorString);
+			FString ErrorString;
+			FUniqueNetIdEOSPtr EOSID = FUniqueNetIdEOS::EmptyId();
+			const bool bWasSuccessful = QueryState->Result == EOS_EResult::EOS_Success;
+			if (bWasSuccessful)
+			{
+				EOSID = UserNumToNetIdMap[LocalUserNum];
+			}
+			else
+			{
+				ErrorString = FString::Printf(TEXT("EOS_Connect_QueryExternalAccountMappings() failed with result code (%s)"), ANSI_TO_TCHAR(EOS_EResult_ToString(QueryState->Result)));
+			}
+			Delegate.ExecuteIfBound(bWasSuccessful, *EOSID, QueryOptions, ExternalIds, ErrorString);
 		};
 
 		EOS_Connect_QueryExternalAccountMappings(EOSSubsystem->GetConnectHandle(), &Options, CallbackObj, CallbackObj->GetCallbackPtr());
@@ -4,9 +4,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/LruCache.h"
 #include "Interfaces/OnlineIdentityInterface.h"
 #include "EOSWrapperSubsystem.h"
 #include "EOSWrapperTypes.h"
+#include "EOSWrapperIdToken.h"
+#include "Misc/SecureHash.h"
 #include "OnlineSubsystemTypes.h"
 #include "eos_auth_types.h"
 #include "eos_friends_types.h"
@@ -94,46 +97,72 @@ class TOnlinePlayerList
 	int32 LocalUserNum;
 	/** The net id that owns this list */
 	FUniqueNetIdEOSRef OwningNetId;
-	/** The array of list class entries */
+	/** The array of list class entries, kept dense so removals swap the last entry into the freed slot */
 	TArray<ListClass> ListEntries;
-	/** Indexed by string form of account id for fast look up */
-	TMap<FString, ListClass> NetIdStringToListEntryMap;
+	/** String form of the account id of every entry, parallel to ListEntries */
+	TArray<FString> ListEntryNetIds;
+	/** Index into ListEntries by string form of account id for fast look up */
+	TMap<FString, int32> NetIdStringToIndexMap;
 
 public:
 	TOnlinePlayerList(int32 InLocalUserNum, FUniqueNetIdEOSRef InOwningNetId) : LocalUserNum(InLocalUserNum), OwningNetId(InOwningNetId) {}
 
-	const TArray<ListClass>& GetList() { return ListEntries; }
+	const TArray<ListClass>& GetList() const { return ListEntries; }
 
 	void Add(const FString& InNetId, ListClass InListEntry)
 	{
+		if (const int32* FoundIndex = NetIdStringToIndexMap.Find(InNetId))
+		{
+			ListEntries[*FoundIndex] = InListEntry;
+			return;
+		}
+
+		NetIdStringToIndexMap.Add(InNetId, ListEntries.Num());
 		ListEntries.Add(InListEntry);
-		NetIdStringToListEntryMap.Add(InNetId, InListEntry);
+		ListEntryNetIds.Add(InNetId);
 	}
 
-	void Remove(const FString& InNetId, ListClass InListEntry)
+	void Remove(const FString& InNetId)
 	{
-		const ListClass* Found = NetIdStringToListEntryMap.Find(InNetId);
-		if (Found != nullptr)
+		int32 Index = INDEX_NONE;
+		if (!NetIdStringToIndexMap.RemoveAndCopyValue(InNetId, Index))
 		{
-			NetIdStringToListEntryMap.Remove(InNetId);
+			return;
+		}
+
+		ListEntries.RemoveAtSwap(Index, 1, false);
+		ListEntryNetIds.RemoveAtSwap(Index, 1, false);
+		if (Index < ListEntries.Num())
+		{
+			NetIdStringToIndexMap[ListEntryNetIds[Index]] = Index;
 		}
-		ListEntries.Remove(InListEntry);
 	}
 
 	void Empty(int32 Slack = 0)
 	{
 		ListEntries.Empty(Slack);
-		NetIdStringToListEntryMap.Empty(Slack);
+		ListEntryNetIds.Empty(Slack);
+		NetIdStringToIndexMap.Empty(Slack);
 	}
 
 	void UpdateNetIdStr(const FString& PrevNetId, const FString& NewNetId)
 	{
-		ListClass ListEntry = NetIdStringToListEntryMap[PrevNetId];
-		NetIdStringToListEntryMap.Remove(PrevNetId);
-		NetIdStringToListEntryMap.Add(NewNetId, ListEntry);
+		if (PrevNetId == NewNetId || !NetIdStringToIndexMap.Contains(PrevNetId))
+		{
+			return;
+		}
+
+		// An entry already filed under the new id is the same player, it is dropped for the one being renamed rather than left unreachable in the list.
+		// The removal can swap the renamed entry into another slot, so its index is looked up afterwards
+		Remove(NewNetId);
+
+		int32 Index = INDEX_NONE;
+		NetIdStringToIndexMap.RemoveAndCopyValue(PrevNetId, Index);
+		ListEntryNetIds[Index] = NewNetId;
+		NetIdStringToIndexMap.Add(NewNetId, Index);
 	}
 
-	ListClassReturnType GetByIndex(int32 Index)
+	ListClassReturnType GetByIndex(int32 Index) const
 	{
 		if (ListEntries.IsValidIndex(Index))
 		{
@@ -142,12 +171,12 @@ public:
 		return ListClassReturnType();
 	}
 
-	ListClassReturnType GetByNetIdString(const FString& NetId)
+	ListClassReturnType GetByNetIdString(const FString& NetId) const
 	{
-		const ListClass* Found = NetIdStringToListEntryMap.Find(NetId);
-		if (Found != nullptr)
+		const int32* FoundIndex = NetIdStringToIndexMap.Find(NetId);
+		if (FoundIndex != nullptr)
 		{
-			return *Found;
+			return ListEntries[*FoundIndex];
 		}
 		return ListClassReturnType();
 	}
@@ -176,9 +205,21 @@ typedef TSharedRef<FBlockedPlayersListEOS> FBlockedPlayersListEOSRef;
 class FRecentPlayersListEOS : public TOnlinePlayerList<FOnlineRecentPlayerEOSRef, FOnlineRecentPlayerEOSPtr>
 {
 public:
-	FRecentPlayersListEOS(int32 InLocalUserNum, FUniqueNetIdEOSRef InOwningNetId) : TOnlinePlayerList<FOnlineRecentPlayerEOSRef, FOnlineRecentPlayerEOSPtr>(InLocalUserNum, InOwningNetId) {}
+	FRecentPlayersListEOS(int32 InLocalUserNum, FUniqueNetIdEOSRef InOwningNetId, int32 InCapacity)
+		: TOnlinePlayerList<FOnlineRecentPlayerEOSRef, FOnlineRecentPlayerEOSPtr>(InLocalUserNum, InOwningNetId), SeenOrder(FMath::Max(InCapacity, 1))
+	{
+	}
 
 	virtual ~FRecentPlayersListEOS() = default;
+
+	/** Records that the player was seen and moves them to the front, once the list is full the least recently seen player drops out */
+	void AddOrUpdate(const FUniqueNetIdEOSRef& PlayerId, const FDateTime& LastSeen);
+	/** Players ordered from most to least recently seen */
+	void GetRecentPlayers(TArray<FOnlineRecentPlayerEOSRef>& OutRecentPlayers) const;
+
+private:
+	/** Net id string of every player in the list, most recently seen first. The value is the key again, so the evicted player can be removed from the list */
+	TLruCache<FString, FString> SeenOrder;
 };
 
 typedef TSharedRef<FRecentPlayersListEOS> FRecentPlayersListEOSRef;
@@ -214,6 +255,8 @@ public:
 
 	void Initialize();
 	void Shutdown();
+	/** Sends presence updates once their debounce interval ran out and applies the presence changes received since the last tick */
+	void Tick(float DeltaTime);
 
 	// IOnlineIdentity Interface
 	virtual bool Login(int32 LocalUserNum, const FOnlineAccountCredentials& AccountCredentials) override;
@@ -337,6 +380,13 @@ public:
 	typedef TFunction<void(FString Token, EOS_EpicAccountId AccountID, bool bSuccess)> FValidateUserAuthTokenCallback;
 	void ValidateUserAuthToken(const FString& TokenString, const FString& UserAccountString, const FValidateUserAuthTokenCallback& Callback);
 
+	/** Whether any logged in local user blocked the player, cheap enough for per message or per frame filtering */
+	bool IsPlayerBlockedByAnyLocalUser(const FUniqueNetId& PlayerId) const;
+	bool IsPlayerBlockedByAnyLocalUser(EOS_ProductUserId ProductUserId) const;
+
+	/** Adds the player to the recent players of every local user, called as session members come and go */
+	void RecordRecentPlayer(const FUniqueNetId& PlayerId);
+
 private:
 	void RemoveLocalUser(int32 LocalUserNum);
 	void AddLocalUser(int32 LocalUserNum, EOS_EpicAccountId EpicAccountId, EOS_ProductUserId UserId);
@@ -352,7 +402,21 @@ private:
 	bool IsFriendQueryUserInfoOngoing(int32 LocalUserNum);
 	void ProcessReadFriendsListComplete(int32 LocalUserNum, bool bWasSuccessful, const FString& ErrorStr);
 
+	void VerifyIdTokenRemotely(const FString& TokenString, const FString& UserAccountString, const FValidateUserAuthTokenCallback& Callback);
+	void AddVerifiedIdToken(const FString& TokenString, const FString& UserAccountString, int64 ExpiresAtUnixTime);
 	void UpdatePresence(EOS_EpicAccountId AccountId);
+	void ProcessDirtyPresence();
+	void SendPresence(EOS_EpicAccountId AccountId);
+
+	/** File in the Saved directory holding local data of a logged in user, empty if the user isn't logged in */
+	FString GetLocalUserFilePath(int32 LocalUserNum, const TCHAR* FileName) const;
+	void AddBlockedPlayerId(const FUniqueNetIdEOS& PlayerId);
+	void RemoveBlockedPlayerId(const FUniqueNetIdEOS& PlayerId);
+	void LoadBlockedPlayers(int32 LocalUserNum);
+	void SaveBlockedPlayers(int32 LocalUserNum) const;
+	void LoadRecentPlayers(int32 LocalUserNum);
+	void SaveRecentPlayers(int32 LocalUserNum) const;
+	void SaveDirtyRecentPlayers();
 	void UpdateFriendPresence(const FString& FriendId, FOnlineUserPresenceRef Presence);
 
 	IOnlineSubsystem* GetPlatformOSS() const;
@@ -392,9 +456,17 @@ private:
 	/** Per user blocked player lists accessible by user num or net id */
 	TMap<int32, FBlockedPlayersListEOSRef> LocalUserNumToBlockedPlayerListMap;
 	TMap<FString, FBlockedPlayersListEOSRef> NetIdStringToBlockedPlayerListMap;
+	/** Number of local users blocking each id, EOS ids are unique handles so lookups don't touch strings */
+	TMap<EOS_ProductUserId, int32> BlockedProductUserIdCounts;
+	TMap<EOS_EpicAccountId, int32> BlockedEpicAccountIdCounts;
 	/** Per user recent player lists accessible by user num or net id */
 	TMap<int32, FRecentPlayersListEOSRef> LocalUserNumToRecentPlayerListMap;
 	TMap<FString, FRecentPlayersListEOSRef> NetIdStringToRecentPlayerListMap;
+	/** Users whose recent players changed, saved together once RecentPlayersSaveTimeInSeconds is reached */
+	TSet<int32> DirtyRecentPlayerLists;
+	double RecentPlayersSaveTimeInSeconds = 0.0;
+	/** How long recent player changes are collected before the files are written */
+	double RecentPlayersSaveDebounceInSeconds = 0.0;
 
 	/** Ids mapped to remote users */
 	TMap<FString, FOnlineUserPtr> NetIdStringToOnlineUserMap;
@@ -404,6 +476,8 @@ private:
 
 	/** Ids mapped to remote user presence */
 	TMap<FString, FOnlineUserPresenceRef> NetIdStringToOnlineUserPresenceMap;
+	/** Fingerprint of the last presence converted for a user, an identical copy leaves the cached presence untouched */
+	TMap<EOS_EpicAccountId, uint32> PresenceInfoHashes;
 
 	/** Id map to keep track of which friends have been processed during async user info queries */
 	TMap<int32, TArray<EOS_EpicAccountId>> IsFriendQueryUserInfoOngoingForLocalUserMap;
@@ -428,6 +502,49 @@ private:
 	EOS_NotificationId DisplaySettingsUpdatedId = EOS_INVALID_NOTIFICATIONID;
 	FCallbackBase* DisplaySettingsUpdatedCallback = nullptr;
 
+	/** Presence of a local user as last sent to EOS, and the SetPresence calls waiting to be merged into the next update */
+	struct FLocalPresenceState
+	{
+		TOptional<FOnlineUserPresenceStatus> SentStatus;
+		TOptional<FOnlineUserPresenceStatus> PendingStatus;
+		/** Every call merged into the pending update gets its own completion */
+		TArray<FOnPresenceTaskCompleteDelegate> PendingDelegates;
+		double SendTimeInSeconds = 0.0;
+		bool bSendInFlight = false;
+	};
+	TMap<EOS_EpicAccountId, FLocalPresenceState> LocalPresenceStates;
+	/** How long SetPresence calls are held back to be merged, 0 sends them right away */
+	double PresenceUpdateDebounceInSeconds = 0.0;
+	/** Remote users whose presence changed since the last tick, a burst of notifications for one user results in a single copy */
+	TSet<EOS_EpicAccountId> DirtyPresenceAccountIds;
+
+	/** A ResolveUniqueNetIds call waiting for product user id mappings, possibly shared with other calls */
+	struct FResolveUniqueNetIdsRequest
+	{
+		TMap<EOS_ProductUserId, FUniqueNetIdEOSRef> ResolvedUniqueNetIds;
+		FResolveUniqueNetIdsCallback Callback;
+		int32 NumPending = 0;
+	};
+	/** Calls waiting on each product user id that is being queried, a second call for the same id joins the running query */
+	mutable TMap<EOS_ProductUserId, TArray<TSharedRef<FResolveUniqueNetIdsRequest>>> InFlightProductUserIdResolves;
+	/** Product user ids the backend returned no Epic account for, and when to ask again */
+	mutable TMap<EOS_ProductUserId, double> UnmappedProductUserIdExpiryTimes;
+
+	/** Checks user auth tokens without a backend round trip, only set when bVerifyIdTokensLocally is on */
+	TUniquePtr<FEOSIdTokenVerifier> IdTokenVerifier;
+
+	struct FCachedIdToken
+	{
+		FString Token;
+		FString UserAccountString;
+		int64 ExpiresAtUnixTime = 0;
+	};
+	/** Tokens that passed validation by hash, a reconnect with the same token doesn't validate it again. The token itself is not kept */
+	TMap<FSHAHash, FCachedIdToken> VerifiedIdTokens;
+	double NextVerifiedIdTokenSweepTimeInSeconds = 0.0;
+	/** Own ID token of each local user, handed out again by GetUserAuthToken until it is about to expire */
+	TMap<int32, FCachedIdToken> LocalUserIdTokens;
+
 	/** Last Login Credentials used for a login attempt */
 	TMap<int32, TSharedRef<FOnlineAccountCredentials>> LocalUserNumToLastLoginCredentials;
 };
@@ -0,0 +1,318 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#include "EOSWrapperIdToken.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_EOSWRAPPER_OPENSSL
+
+#include "Dom/JsonObject.h"
+#include "Misc/Base64.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#endif
+#define UI UI_ST
+THIRD_PARTY_INCLUDES_START
+#include <openssl/bn.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+THIRD_PARTY_INCLUDES_END
+#undef UI
+#if PLATFORM_WINDOWS
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+namespace EOSWrapperIdTokenTests
+{
+	typedef FEOSIdTokenVerifier::EResult EResult;
+
+	static const FString TestIssuer = TEXT("https://api.epicgames.dev/epic/oauth/v1");
+	static const FString TestAudience = TEXT("xyza7891TestClientId");
+	static const FString TestAccountId = TEXT("0123456789abcdef0123456789abcdef");
+
+	static FString EncodeBase64Url(const uint8* Data, int32 Num)
+	{
+		FString Encoded = FBase64::Encode(Data, Num);
+		Encoded.ReplaceCharInline(TEXT('+'), TEXT('-'));
+		Encoded.ReplaceCharInline(TEXT('/'), TEXT('_'));
+		int32 PaddingStart = INDEX_NONE;
+		if (Encoded.FindChar(TEXT('='), PaddingStart))
+		{
+			Encoded.LeftInline(PaddingStart);
+		}
+		return Encoded;
+	}
+
+	static FString EncodeBase64Url(const FString& Text)
+	{
+		const FTCHARToUTF8 Utf8(*Text);
+		return EncodeBase64Url(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+	}
+
+	static FString EncodeBase64Url(const BIGNUM* Number)
+	{
+		TArray<uint8> Bytes;
+		Bytes.SetNumUninitialized(BN_num_bytes(Number));
+		BN_bn2bin(Number, Bytes.GetData());
+		return EncodeBase64Url(Bytes.GetData(), Bytes.Num());
+	}
+
+	static FString ToJson(const TSharedRef<FJsonObject>& Object)
+	{
+		FString Json;
+		FJsonSerializer::Serialize(Object, TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Json));
+		return Json;
+	}
+
+	/** Freshly generated RSA key that signs RS256 tokens and publishes itself as a JWKS file */
+	class FTestKey
+	{
+	public:
+		UE_NONCOPYABLE(FTestKey);
+
+		explicit FTestKey(const FString& InKeyId) : KeyId(InKeyId)
+		{
+			BIGNUM* PublicExponent = BN_new();
+			BN_set_word(PublicExponent, RSA_F4);
+			Rsa = RSA_new();
+			if (RSA_generate_key_ex(Rsa, 2048, PublicExponent, nullptr) != 1)
+			{
+				RSA_free(Rsa);
+				Rsa = nullptr;
+			}
+			BN_free(PublicExponent);
+		}
+
+		~FTestKey()
+		{
+			if (Rsa != nullptr)
+			{
+				RSA_free(Rsa);
+			}
+		}
+
+		bool IsValid() const { return Rsa != nullptr; }
+
+		/** Returns the full path of the written file, empty on failure */
+		FString WriteJwks(const FString& FileName) const
+		{
+			const BIGNUM* Modulus = nullptr;
+			const BIGNUM* Exponent = nullptr;
+			RSA_get0_key(Rsa, &Modulus, &Exponent, nullptr);
+
+			TSharedRef<FJsonObject> Key = MakeShared<FJsonObject>();
+			Key->SetStringField(TEXT("kty"), TEXT("RSA"));
+			Key->SetStringField(TEXT("use"), TEXT("sig"));
+			Key->SetStringField(TEXT("alg"), TEXT("RS256"));
+			Key->SetStringField(TEXT("kid"), KeyId);
+			Key->SetStringField(TEXT("n"), EncodeBase64Url(Modulus));
+			Key->SetStringField(TEXT("e"), EncodeBase64Url(Exponent));
+
+			TSharedRef<FJsonObject> Jwks = MakeShared<FJsonObject>();
+			Jwks->SetArrayField(TEXT("keys"), {MakeShared<FJsonValueObject>(Key)});
+
+			const FString FilePath = FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::AutomationTransientDir(), FileName));
+			return FFileHelper::SaveStringToFile(ToJson(Jwks), *FilePath) ? FilePath : FString();
+		}
+
+		FString Sign(const TSharedRef<FJsonObject>& Header, const TSharedRef<FJsonObject>& Payload) const
+		{
+			const FString SigningInput = EncodeBase64Url(ToJson(Header)) + TEXT(".") + EncodeBase64Url(ToJson(Payload));
+			const FTCHARToUTF8 Utf8(*SigningInput);
+			uint8 Digest[SHA256_DIGEST_LENGTH];
+			SHA256(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length(), Digest);
+
+			TArray<uint8> Signature;
+			Signature.SetNumUninitialized(RSA_size(Rsa));
+			unsigned int SignatureLength = 0;
+			if (RSA_sign(NID_sha256, Digest, SHA256_DIGEST_LENGTH, Signature.GetData(), &SignatureLength, Rsa) != 1)
+			{
+				return FString();
+			}
+			return SigningInput + TEXT(".") + EncodeBase64Url(Signature.GetData(), SignatureLength);
+		}
+
+		const FString KeyId;
+
+	private:
+		RSA* Rsa = nullptr;
+	};
+
+	static TSharedRef<FJsonObject> MakeHeader(const FString& KeyId)
+	{
+		TSharedRef<FJsonObject> Header = MakeShared<FJsonObject>();
+		Header->SetStringField(TEXT("alg"), TEXT("RS256"));
+		Header->SetStringField(TEXT("typ"), TEXT("JWT"));
+		Header->SetStringField(TEXT("kid"), KeyId);
+		return Header;
+	}
+
+	static TSharedRef<FJsonObject> MakePayload(int64 ExpiresAtUnixTime)
+	{
+		TSharedRef<FJsonObject> Payload = MakeShared<FJsonObject>();
+		Payload->SetStringField(TEXT("iss"), TestIssuer);
+		Payload->SetStringField(TEXT("sub"), TestAccountId);
+		Payload->SetStringField(TEXT("aud"), TestAudience);
+		Payload->SetNumberField(TEXT("iat"), (double)FDateTime::UtcNow().ToUnixTimestamp());
+		Payload->SetNumberField(TEXT("exp"), (double)ExpiresAtUnixTime);
+		return Payload;
+	}
+
+	/** Ticks the verifier until every token is back, returns false on timeout */
+	static bool VerifyTokens(FEOSIdTokenVerifier& Verifier, const TArray<FString>& Tokens, TArray<EResult>& OutResults, TArray<int64>& OutExpiresAtUnixTimes)
+	{
+		OutResults.Init(EResult::Unverifiable, Tokens.Num());
+		OutExpiresAtUnixTimes.Init(0, Tokens.Num());
+		int32 NumPending = Tokens.Num();
+		for (int32 Index = 0; Index < Tokens.Num(); Index++)
+		{
+			Verifier.Verify(Tokens[Index], TestAccountId,
+				[&OutResults, &OutExpiresAtUnixTimes, &NumPending, Index](EResult Result, int64 ExpiresAtUnixTime)
+				{
+					OutResults[Index] = Result;
+					OutExpiresAtUnixTimes[Index] = ExpiresAtUnixTime;
+					NumPending--;
+				});
+		}
+
+		const double TimeoutInSeconds = FPlatformTime::Seconds() + 60.0;
+		Verifier.Tick();
+		while (NumPending > 0 && FPlatformTime::Seconds() < TimeoutInSeconds)
+		{
+			FPlatformProcess::Sleep(0.001f);
+			Verifier.Tick();
+		}
+		return NumPending == 0;
+	}
+} // namespace EOSWrapperIdTokenTests
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEOSWrapperIdTokenVerifyTest, "EOSWrapper.IdToken.Verify", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FEOSWrapperIdTokenVerifyTest::RunTest(const FString& Parameters)
+{
+	using namespace EOSWrapperIdTokenTests;
+
+	const FTestKey Key(TEXT("test-key"));
+	const FTestKey OtherKey(TEXT("test-key"));
+	if (!TestTrue(TEXT("Generated the signing keys"), Key.IsValid() && OtherKey.IsValid()))
+	{
+		return false;
+	}
+	const FString JwksPath = Key.WriteJwks(TEXT("EOSWrapperIdTokenVerifyTest.json"));
+	if (!TestFalse(TEXT("Wrote the JWKS file"), JwksPath.IsEmpty()))
+	{
+		return false;
+	}
+
+	const int64 ExpiresAtUnixTime = FDateTime::UtcNow().ToUnixTimestamp() + 3600;
+	TArray<FString> Tokens;
+	TArray<EResult> ExpectedResults;
+	TArray<FString> Descriptions;
+	auto AddCase = [&Tokens, &ExpectedResults, &Descriptions](const TCHAR* Description, const FString& Token, EResult ExpectedResult)
+	{
+		Descriptions.Add(Description);
+		Tokens.Add(Token);
+		ExpectedResults.Add(ExpectedResult);
+	};
+
+	AddCase(TEXT("Valid token"), Key.Sign(MakeHeader(Key.KeyId), MakePayload(ExpiresAtUnixTime)), EResult::Valid);
+	AddCase(TEXT("Signed by another key with the same key id"), OtherKey.Sign(MakeHeader(Key.KeyId), MakePayload(ExpiresAtUnixTime)), EResult::Invalid);
+	AddCase(TEXT("Unknown key id"), Key.Sign(MakeHeader(TEXT("other-key")), MakePayload(ExpiresAtUnixTime)), EResult::Unverifiable);
+	AddCase(TEXT("Expired"), Key.Sign(MakeHeader(Key.KeyId), MakePayload(FDateTime::UtcNow().ToUnixTimestamp() - 3600)), EResult::Invalid);
+	{
+		TSharedRef<FJsonObject> Payload = MakePayload(ExpiresAtUnixTime);
+		Payload->SetStringField(TEXT("iss"), TestIssuer.ToUpper());
+		AddCase(TEXT("Issuer in another case"), Key.Sign(MakeHeader(Key.KeyId), Payload), EResult::Invalid);
+		Payload->SetStringField(TEXT("iss"), TestIssuer + TEXT(".example.com"));
+		AddCase(TEXT("Issuer with a suffix"), Key.Sign(MakeHeader(Key.KeyId), Payload), EResult::Invalid);
+		Payload->SetStringField(TEXT("iss"), TestIssuer);
+		Payload->SetStringField(TEXT("aud"), TEXT("SomeOtherClientId"));
+		AddCase(TEXT("Other audience"), Key.Sign(MakeHeader(Key.KeyId), Payload), EResult::Invalid);
+		Payload->SetStringField(TEXT("aud"), TestAudience);
+		Payload->SetStringField(TEXT("sub"), TEXT("fedcba9876543210fedcba9876543210"));
+		AddCase(TEXT("Other account"), Key.Sign(MakeHeader(Key.KeyId), Payload), EResult::Invalid);
+	}
+	{
+		TSharedRef<FJsonObject> Header = MakeHeader(Key.KeyId);
+		Header->RemoveField(TEXT("alg"));
+		AddCase(TEXT("Missing alg"), Key.Sign(Header, MakePayload(ExpiresAtUnixTime)), EResult::Invalid);
+		Header->SetStringField(TEXT("alg"), TEXT("HS256"));
+		AddCase(TEXT("Other alg"), Key.Sign(Header, MakePayload(ExpiresAtUnixTime)), EResult::Invalid);
+		Header->SetStringField(TEXT("alg"), TEXT("RS256"));
+		Header->SetNumberField(TEXT("kid"), 1.0);
+		AddCase(TEXT("Key id is not a string"), Key.Sign(Header, MakePayload(ExpiresAtUnixTime)), EResult::Invalid);
+	}
+	AddCase(TEXT("Not a JWT"), TEXT("not.a-token"), EResult::Invalid);
+
+	FEOSIdTokenVerifier Verifier(JwksPath, {TestAudience}, 2);
+	TArray<EResult> Results;
+	TArray<int64> ExpiresAtUnixTimes;
+	if (!TestTrue(TEXT("Every token was verified in time"), VerifyTokens(Verifier, Tokens, Results, ExpiresAtUnixTimes)))
+	{
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Tokens.Num(); Index++)
+	{
+		TestEqual(Descriptions[Index], (int32)Results[Index], (int32)ExpectedResults[Index]);
+	}
+	TestEqual(TEXT("Valid token expiry"), ExpiresAtUnixTimes[0], ExpiresAtUnixTime);
+
+	int64 ReadExpiresAtUnixTime = 0;
+	TestTrue(TEXT("Read the expiry without verifying"), FEOSIdTokenVerifier::ReadTokenExpiry(Tokens[0], ReadExpiresAtUnixTime));
+	TestEqual(TEXT("Unverified expiry"), ReadExpiresAtUnixTime, ExpiresAtUnixTime);
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEOSWrapperIdTokenBenchmarkTest, "EOSWrapper.IdToken.Benchmark", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FEOSWrapperIdTokenBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace EOSWrapperIdTokenTests;
+
+	static constexpr int32 NumTokens = 2000;
+
+	const FTestKey Key(TEXT("benchmark-key"));
+	const FString JwksPath = Key.IsValid() ? Key.WriteJwks(TEXT("EOSWrapperIdTokenBenchmarkTest.json")) : FString();
+	if (!TestFalse(TEXT("Wrote the JWKS file"), JwksPath.IsEmpty()))
+	{
+		return false;
+	}
+
+	// Every token differs so nothing along the way can get away with caching
+	const int64 ExpiresAtUnixTime = FDateTime::UtcNow().ToUnixTimestamp() + 3600;
+	TArray<FString> Tokens;
+	Tokens.Reserve(NumTokens);
+	for (int32 Index = 0; Index < NumTokens; Index++)
+	{
+		TSharedRef<FJsonObject> Payload = MakePayload(ExpiresAtUnixTime);
+		Payload->SetNumberField(TEXT("jti"), (double)Index);
+		Tokens.Add(Key.Sign(MakeHeader(Key.KeyId), Payload));
+	}
+
+	for (const int32 MaxWorkers : {1, FPlatformMisc::NumberOfCoresIncludingHyperthreads()})
+	{
+		FEOSIdTokenVerifier Verifier(JwksPath, {TestAudience}, MaxWorkers);
+		TArray<EResult> Results;
+		TArray<int64> ExpiresAtUnixTimes;
+		const double StartTimeInSeconds = FPlatformTime::Seconds();
+		if (!TestTrue(TEXT("Every token was verified in time"), VerifyTokens(Verifier, Tokens, Results, ExpiresAtUnixTimes)))
+		{
+			return false;
+		}
+		const double ElapsedInSeconds = FMath::Max(FPlatformTime::Seconds() - StartTimeInSeconds, 1e-6);
+
+		TestEqual(TEXT("Valid tokens"), Results.FilterByPredicate([](EResult Result) { return Result == EResult::Valid; }).Num(), NumTokens);
+		AddInfo(FString::Printf(TEXT("%d workers: %d tokens in %.3f s, %.0f tokens per second"), MaxWorkers, NumTokens, ElapsedInSeconds, NumTokens / ElapsedInSeconds));
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_EOSWRAPPER_OPENSSL
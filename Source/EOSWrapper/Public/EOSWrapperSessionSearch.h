@@ -0,0 +1,32 @@
+﻿// Copyright:       Copyright (C) 2023 Yuri Trofimov
+// Source Code:     https://github.com/YuriTrofimov/EOSWrapper
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Session settings and search parameters understood by the EOSWrapper session interface on top of the ones in OnlineSessionSettings.h.
+ * SEARCH_EOSWRAPPER_* parameters are evaluated on the client and never sent to the backend as filters.
+ */
+
+/** Skill band a session advertises (int32), compared to SEARCH_EOSWRAPPER_RANK_SKILLBAND when ranking search results */
+#define SETTING_EOSWRAPPER_SKILLBAND FName(TEXT("SKILLBAND"))
+/** UDP port the host answers QoS probes on (int32), set automatically on dedicated servers running the QoS responder */
+#define SETTING_EOSWRAPPER_QOSPORT FName(TEXT("QOSPORT"))
+
+/** Keep only the best N results after ranking (int32), 0 keeps all of them */
+#define SEARCH_EOSWRAPPER_RANK_TOPK FName(TEXT("EOSWRAPPER_RANK_TOPK"))
+/** Skill band of the searching player (int32) */
+#define SEARCH_EOSWRAPPER_RANK_SKILLBAND FName(TEXT("EOSWRAPPER_RANK_SKILLBAND"))
+/** Preferred region (FString), compared to the SETTING_REGION a session advertises */
+#define SEARCH_EOSWRAPPER_RANK_REGION FName(TEXT("EOSWRAPPER_RANK_REGION"))
+
+/**
+ * Session setting to split a search on (FString), e.g. "REGION" or "SKILLBAND".
+ * When set together with SEARCH_EOSWRAPPER_PARTITION_VALUES and MaxSearchResults is above what a single EOS query returns,
+ * FindSessions runs one query per value in parallel and merges the results.
+ */
+#define SEARCH_EOSWRAPPER_PARTITION_KEY FName(TEXT("EOSWRAPPER_PARTITION_KEY"))
+/** Values of the partition key to search (FString), comma separated. "First..Last" expands to every integer in between */
+#define SEARCH_EOSWRAPPER_PARTITION_VALUES FName(TEXT("EOSWRAPPER_PARTITION_VALUES"))